@@ -6,25 +6,40 @@
  */
 
 #include "analyser.h"
-#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <thread>
 
 namespace tinylang {
 
-using traverse_proc_t = std::function<int(TreeNode *)>;
+void DiagnosticLog::error(const char * fmt, ...) {
+    va_list args, size_args;
+    va_start(args, fmt);
+    va_copy(size_args, args);
+    int len = vsnprintf(nullptr, 0, fmt, size_args);
+    va_end(size_args);
+    std::string msg(len > 0 ? len : 0, '\0');
+    if (len > 0)
+        vsnprintf(&msg[0], msg.size() + 1, fmt, args);
+    va_end(args);
+    entries.emplace_back(event, std::move(msg));
+}
 
-//! @brief Just do nothing
-static int empty_proc(TreeNode * t) {
-    return 0;
+void report_undeclared(DiagnosticLog * log, int line_no, const char * name) {
+    log->error("file:%d: error: use of undeclared identifier '%s'\n",
+               line_no, name);
 }
 
-static int insert_node_to_symtable(SymTable * st, TreeNode * t) {
+static int insert_node_to_symtable(SymTable * st, DiagnosticLog * log, TreeNode * t) {
     switch (t->node_type) {
         case NodeType::NodeStmt:
             switch (t->stmt) {
                 // only assign / read statement create new symbols
                 case StmtProp::StmtAssign:
                 case StmtProp::StmtRead:
-                    st->insert(t->attr.name, t->line_no);
+                    t->slot = st->insert(t->attr.name, t->line_no);
                     break;
                 default:
                     break;
@@ -32,12 +47,13 @@ static int insert_node_to_symtable(SymTable * st, TreeNode * t) {
             break;
         case NodeType::NodeExpr:
             if (t->expr == ExprProp::ExprIdentifier) {
-                if (st->find(t->attr.name) != 0) {
-                    printf("file:%d: error: use of undeclared identifier '%s'\n",
-                            t->line_no, t->attr.name);
+                int id = st->lookup(t->attr.name);
+                t->slot = id;
+                if (id < 0) {
+                    report_undeclared(log, t->line_no, t->attr.name);
                     return -1;
                 }
-                st->insert(t->attr.name, t->line_no);
+                st->insert_line(id, t->line_no);
             }
             break;
         default:
@@ -46,7 +62,7 @@ static int insert_node_to_symtable(SymTable * st, TreeNode * t) {
     return 0;
 }
 
-static int check_node_type(SymTable * st, TreeNode * t) {
+static int check_node_type(DiagnosticLog * log, TreeNode * t) {
     if (t->node_type == NodeType::NodeExpr) {
         if (t->expr == ExprProp::ExprConst) {
             t->expr_type = ExprType::ExpInteger;
@@ -56,7 +72,7 @@ static int check_node_type(SymTable * st, TreeNode * t) {
         } else if (t->expr == ExprProp::ExprOp) {
             if (t->children[0]->expr_type != ExprType::ExpInteger ||
                 t->children[1]->expr_type != ExprType::ExpInteger) {
-                printf("file:%d: expect operands to be integer\n", t->line_no);
+                log->error("file:%d: expect operands to be integer\n", t->line_no);
                 return -1;
             }
             if (t->attr.op == TokenType::EQ || t->attr.op == TokenType::LT) {
@@ -69,17 +85,19 @@ static int check_node_type(SymTable * st, TreeNode * t) {
         if (t->stmt == StmtAssign) {
             // FIXME: for boolean asignment
             if (t->children[0]->expr_type != ExprType::ExpInteger) {
-                printf("file:%d: expect expression type to be integer\n", t->line_no);
+                log->error("file:%d: expect expression type to be integer\n", t->line_no);
                 return -1;
             }
         } else if (t->stmt == StmtIf || t->stmt == StmtRepeat) {
-            if (t->children[0]->expr_type != ExprType::ExpBool) {
-                printf("file:%d: expect expression type to be boolean\n", t->line_no);
+            // the condition of repeat-until is its second child
+            TreeNode * cond = t->stmt == StmtIf ? t->children[0] : t->children[1];
+            if (cond->expr_type != ExprType::ExpBool) {
+                log->error("file:%d: expect expression type to be boolean\n", t->line_no);
                 return -1;
             }
         } else if (t->stmt == StmtWrite) {
             if (t->children[0]->expr_type != ExprType::ExpInteger) {
-                printf("file:%d: expect expression type to be integer\n", t->line_no);
+                log->error("file:%d: expect expression type to be integer\n", t->line_no);
                 return -1;
             }
         }
@@ -88,46 +106,194 @@ static int check_node_type(SymTable * st, TreeNode * t) {
     return 0;
 }
 
-static int traverse(TreeNode * node,
-                    traverse_proc_t pre_proc, traverse_proc_t post_proc) {
+int SymbolTableBuilder::pre_visit(TreeNode * t) {
+    ++log_->event;
+    return insert_node_to_symtable(st_, log_, t);
+}
+
+int TypeChecker::post_visit(TreeNode * t) {
+    ++log_->event;
+    return check_node_type(log_, t);
+}
+
+namespace {
+
+//! @brief An identifier use not declared before it in its own chunk
+struct PendingUse {
+    size_t event;
+    TreeNode * node;
+    int id; // global symbol id found at the merge, -1 if undeclared
+};
+
+//! @brief Symbols and messages of a chunk of top-level statements
+struct ChunkResult {
+    SymTable symtable; // ids are local to the chunk
+    DiagnosticLog log;
+    std::vector<PendingUse> pending;
+    std::vector<int> global_ids; // local id -> global id
     int ret = 0;
-    if (node != nullptr) {
-        //node->print();
-        pre_proc(node);
-        for (int i = 0; i < TreeNode::MAX_CHILDREN; ++i) {
-            // recursively call this function
-            ret |= traverse(node->children[i], pre_proc, post_proc);
+};
+
+/**
+ * @brief SymbolTableBuilder for a chunk.
+ *  A use of a name the chunk has not declared yet may still be declared by
+ *  an earlier chunk, so it is deferred to the merge instead of reported.
+ */
+class ChunkSymbolBuilder : public AstVisitor<ChunkSymbolBuilder> {
+public:
+    explicit ChunkSymbolBuilder(ChunkResult * chunk) : chunk_(chunk) {}
+
+    int pre_visit(TreeNode * t) {
+        ++chunk_->log.event;
+        if (t->node_type == NodeExpr && t->expr == ExprIdentifier) {
+            int id = chunk_->symtable.lookup(t->attr.name);
+            t->slot = id;
+            if (id < 0) {
+                chunk_->pending.push_back({chunk_->log.event, t, -1});
+            } else {
+                chunk_->symtable.insert_line(id, t->line_no);
+            }
+            return 0;
         }
-        post_proc(node);
-        // TODO: do not make recursive calls for neighbor nodes
-        ret |= traverse(node->neighbor, pre_proc, post_proc);
+        return insert_node_to_symtable(&chunk_->symtable, &chunk_->log, t);
     }
-    return ret;
-}
 
-int Analyser::build_symbol_table(TreeNode * tree) {
-    using std::placeholders::_1;
-    traverse_proc_t proc = std::bind(insert_node_to_symtable, &symtable_, _1);
-    traverse(tree, proc, empty_proc);
-    return 0;
-}
+private:
+    ChunkResult * chunk_;
+};
 
-int Analyser::check_type(TreeNode * tree) {
-    using std::placeholders::_1;
-    traverse_proc_t proc = std::bind(check_node_type, &symtable_, _1);
-    traverse(tree, empty_proc, proc);
-    return 0;
+//! @brief Translate the slots of a chunk from local to global symbol ids
+class SlotRemapper : public AstVisitor<SlotRemapper> {
+public:
+    explicit SlotRemapper(const ChunkResult * chunk) : chunk_(chunk) {}
+
+    int pre_visit(TreeNode * t) {
+        bool named = (t->node_type == NodeStmt &&
+                      (t->stmt == StmtAssign || t->stmt == StmtRead)) ||
+                     (t->node_type == NodeExpr && t->expr == ExprIdentifier);
+        if (named && t->slot >= 0)
+            t->slot = chunk_->global_ids[t->slot];
+        return 0;
+    }
+
+private:
+    const ChunkResult * chunk_;
+};
+
+//! @brief Run f(chunk) for every chunk on the given number of threads
+template <class F>
+static void for_each_chunk(unsigned threads, size_t chunk_count, F f) {
+    std::atomic<size_t> next_chunk(0);
+    auto worker = [&]() {
+        for (size_t c = next_chunk++; c < chunk_count; c = next_chunk++) {
+            f(c);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread & th : pool) {
+        th.join();
+    }
 }
 
+// below this many top-level statements threads do not pay off
+const size_t MIN_PARALLEL_STATEMENTS = 2048;
+const size_t MIN_CHUNK_STATEMENTS = 1024;
+
+} /* namespace */
+
 int Analyser::analyse(TreeNode * tree) {
-    if (this->build_symbol_table(tree) != 0) {
-        return -1;
+    if (threads_ > 1) {
+        return this->analyse_parallel(tree);
+    }
+    return this->analyse_with(tree);
+}
+
+int Analyser::analyse_parallel(TreeNode * tree) {
+    std::vector<TreeNode *> stmts;
+    for (TreeNode * t = tree; t != nullptr; t = t->neighbor) {
+        stmts.push_back(t);
     }
-    symtable_.print();
-    if (this->check_type(tree) != 0) {
-        return -1;
+    if (stmts.size() < MIN_PARALLEL_STATEMENTS) {
+        return this->analyse_with(tree);
+    }
+
+    // several chunks per thread, so that threads finishing early take more
+    size_t chunk_size = std::max(MIN_CHUNK_STATEMENTS, stmts.size() / (threads_ * 8));
+    size_t chunk_count = (stmts.size() + chunk_size - 1) / chunk_size;
+    std::vector<ChunkResult> chunks(chunk_count);
+    for_each_chunk(threads_, chunk_count, [&](size_t c) {
+        ChunkResult & chunk = chunks[c];
+        ChunkSymbolBuilder builder(&chunk);
+        TypeChecker checker(&chunk.symtable, &chunk.log);
+        PassPipeline<ChunkSymbolBuilder, TypeChecker> pipeline(builder, checker);
+        size_t end = std::min(stmts.size(), (c + 1) * chunk_size);
+        for (size_t i = c * chunk_size; i < end; ++i) {
+            chunk.ret |= pipeline.walk_node(stmts[i]);
+        }
+    });
+
+    // merge in program order, so ids, lines and messages match a single walk
+    int ret = 0;
+    DiagnosticLog log;
+    for (ChunkResult & chunk : chunks) {
+        ret |= chunk.ret;
+        auto msg = chunk.log.entries.begin();
+        // pending uses precede any declaration in the chunk of the same name
+        for (PendingUse & use : chunk.pending) {
+            int id = symtable_.lookup(use.node->attr.name);
+            use.id = id;
+            if (id >= 0) {
+                symtable_.insert_line(id, use.node->line_no);
+                continue;
+            }
+            for (; msg != chunk.log.entries.end() && msg->first < use.event; ++msg) {
+                log.entries.push_back(std::move(*msg));
+            }
+            report_undeclared(&log, use.node->line_no, use.node->attr.name);
+            ret = -1;
+        }
+        for (; msg != chunk.log.entries.end(); ++msg) {
+            log.entries.push_back(std::move(*msg));
+        }
+        for (size_t local = 0; local < chunk.symtable.size(); ++local) {
+            const SymRecord & rec = chunk.symtable.record(local);
+            int id = symtable_.lookup(rec.name.c_str(), rec.name.size());
+            rec.lines.for_each([&](int line_no) {
+                if (id < 0) {
+                    id = symtable_.insert(rec.name, line_no);
+                } else {
+                    symtable_.insert_line(id, line_no);
+                }
+            });
+            chunk.global_ids.push_back(id);
+        }
+    }
+
+    // the slots of the nodes were chunk-local ids
+    for_each_chunk(threads_, chunk_count, [&](size_t c) {
+        SlotRemapper remapper(&chunks[c]);
+        size_t end = std::min(stmts.size(), (c + 1) * chunk_size);
+        for (size_t i = c * chunk_size; i < end; ++i) {
+            remapper.walk_node(stmts[i]);
+        }
+        for (const PendingUse & use : chunks[c].pending) {
+            use.node->slot = use.id;
+        }
+    });
+    this->report(log);
+    return ret == 0 ? 0 : -1;
+}
+
+void Analyser::report(const DiagnosticLog & log) {
+    diagnostics_.clear();
+    for (const auto & entry : log.entries) {
+        fputs(entry.second.c_str(), stdout);
+        diagnostics_.push_back(entry.second);
     }
-    return 0;
 }
 
 } /* namespace tinylang */
@@ -10,9 +10,54 @@
 
 #include "parser.h"
 #include "symtable.h"
+#include "ast_visitor.h"
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace tinylang {
 
+/**
+ * @brief Error messages of the analysis passes.
+ *  Every hook call of the built-in passes is an event; messages are tagged
+ *  with the event that raised them, so logs of separately analysed parts
+ *  of a program can be merged back into traversal order.
+ */
+struct DiagnosticLog {
+    //! @brief Append a printf-style message tagged with the current event
+    void error(const char * fmt, ...);
+
+    size_t event = 0; // number of events so far
+    std::vector<std::pair<size_t, std::string>> entries; // (event, message)
+};
+
+//! @brief Log the error of a use of an undeclared identifier
+void report_undeclared(DiagnosticLog * log, int line_no, const char * name);
+
+//! @brief Pre-order pass that records every symbol occurrence
+class SymbolTableBuilder : public AstVisitor<SymbolTableBuilder> {
+public:
+    SymbolTableBuilder(SymTable * st, DiagnosticLog * log) : st_(st), log_(log) {}
+
+    int pre_visit(TreeNode * t);
+
+private:
+    SymTable * st_;
+    DiagnosticLog * log_;
+};
+
+//! @brief Post-order pass that assigns and checks expression types
+class TypeChecker : public AstVisitor<TypeChecker> {
+public:
+    TypeChecker(SymTable * st, DiagnosticLog * log) : st_(st), log_(log) {}
+
+    int post_visit(TreeNode * t);
+
+private:
+    SymTable * st_;
+    DiagnosticLog * log_;
+};
+
 /**
  * @brief Class for semantic analysis.
  */
@@ -20,18 +65,53 @@ class Analyser {
 public:
     /**
      * @brief Do semantic analysis on the given syntax tree.
+     *  Symbol table construction and type checking share one walk, which
+     *  also sets the slot of every named node to its symbol id. With
+     *  more than one thread, chunks of the top-level statements are
+     *  analysed concurrently and merged into the same symbol table and
+     *  diagnostics as the sequential walk.
      *
      * @return 0 for no error.
      */
     int analyse(TreeNode * tree);
 
+    /**
+     * @brief Do semantic analysis with extra passes fused into the walk.
+     *  At each node the hooks of the extra passes run after the built-in
+     *  ones, so they can rely on symbols and types of the node.
+     *
+     * @return 0 for no error.
+     */
+    template <class... Passes>
+    int analyse_with(TreeNode * tree, Passes &... passes) {
+        DiagnosticLog log;
+        SymbolTableBuilder builder(&symtable_, &log);
+        TypeChecker checker(&symtable_, &log);
+        PassPipeline<SymbolTableBuilder, TypeChecker, Passes...>
+            pipeline(builder, checker, passes...);
+        int ret = pipeline.walk(tree);
+        this->report(log);
+        return ret == 0 ? 0 : -1;
+    }
+
+    //! @brief Number of threads used by analyse(), 1 by default
+    void set_threads(unsigned threads) { threads_ = threads; }
+
+    const SymTable & symtable() const { return symtable_; }
+
+    //! @brief Messages of the last analysis, in the order they were printed
+    const std::vector<std::string> & diagnostics() const { return diagnostics_; }
+
 private:
-    int build_symbol_table(TreeNode * tree);
+    int analyse_parallel(TreeNode * tree);
 
-    int check_type(TreeNode * tree);
+    //! @brief Print and keep the messages of the log
+    void report(const DiagnosticLog & log);
 
 private:
     SymTable symtable_;
+    std::vector<std::string> diagnostics_;
+    unsigned threads_ = 1;
 };
 
 } /* namespace tinylang */
@@ -0,0 +1,78 @@
+/*
+ * ast_pool.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "ast_pool.h"
+#include "parser.h"
+#include <cstring>
+#include <new>
+
+namespace tinylang {
+
+constexpr size_t NodePool::BLOCK_NODES;
+constexpr size_t StringArena::BLOCK_SIZE;
+
+NodePool::~NodePool() {
+    for (TreeNode *block : blocks_) {
+        delete[] block;
+    }
+}
+
+TreeNode *NodePool::allocate() {
+    if (used_ == BLOCK_NODES) {
+        ++block_;
+        used_ = 0;
+    }
+    if (block_ == blocks_.size()) {
+        blocks_.push_back(new TreeNode[BLOCK_NODES]);
+    }
+    TreeNode *node = blocks_[block_] + used_++;
+    return new (node) TreeNode();
+}
+
+void NodePool::reset() {
+    block_ = 0;
+    used_ = 0;
+}
+
+StringArena::~StringArena() {
+    this->reset();
+    for (char *block : blocks_) {
+        delete[] block;
+    }
+}
+
+char *StringArena::copy(const char *str, size_t len) {
+    char *dst = nullptr;
+    if (len + 1 > BLOCK_SIZE) {
+        dst = new char[len + 1];
+        large_.push_back(dst);
+    } else {
+        if (used_ + len + 1 > BLOCK_SIZE) {
+            ++block_;
+            used_ = 0;
+        }
+        if (block_ == blocks_.size()) {
+            blocks_.push_back(new char[BLOCK_SIZE]);
+        }
+        dst = blocks_[block_] + used_;
+        used_ += len + 1;
+    }
+    memcpy(dst, str, len);
+    dst[len] = '\0';
+    return dst;
+}
+
+void StringArena::reset() {
+    for (char *str : large_) {
+        delete[] str;
+    }
+    large_.clear();
+    block_ = 0;
+    used_ = 0;
+}
+
+} /* namespace tinylang */
@@ -0,0 +1,73 @@
+/*
+ * ast_pool.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef AST_POOL_H
+#define AST_POOL_H
+
+#include <cstddef>
+#include <vector>
+
+namespace tinylang {
+
+struct TreeNode;
+
+/**
+ * @brief Block allocator for TreeNode.
+ *  Nodes are never freed one by one; reset() recycles all of them at once
+ *  and keeps the blocks, so a warmed-up pool does not touch the heap.
+ */
+class NodePool {
+public:
+    NodePool() = default;
+    NodePool(const NodePool &) = delete;
+    NodePool &operator=(const NodePool &) = delete;
+    ~NodePool();
+
+    //! @brief Get a value-initialized node
+    TreeNode *allocate();
+
+    //! @brief Recycle every node allocated so far
+    void reset();
+
+    //! @brief Number of nodes in use
+    size_t size() const { return block_ * BLOCK_NODES + used_; }
+
+private:
+    static constexpr size_t BLOCK_NODES = 1024;
+    std::vector<TreeNode *> blocks_;
+    size_t block_ = 0; // index of the block being filled
+    size_t used_ = 0;  // nodes used in that block
+};
+
+/**
+ * @brief Bump allocator for the NUL-terminated names stored in TreeNode.
+ *  Same lifetime rules as NodePool.
+ */
+class StringArena {
+public:
+    StringArena() = default;
+    StringArena(const StringArena &) = delete;
+    StringArena &operator=(const StringArena &) = delete;
+    ~StringArena();
+
+    //! @brief Copy len characters of str and append a NUL
+    char *copy(const char *str, size_t len);
+
+    //! @brief Recycle every string copied so far
+    void reset();
+
+private:
+    static constexpr size_t BLOCK_SIZE = 16 * 1024;
+    std::vector<char *> blocks_;
+    std::vector<char *> large_; // strings longer than a block
+    size_t block_ = 0;
+    size_t used_ = 0;
+};
+
+} /* namespace tinylang */
+
+#endif /* !AST_POOL_H */
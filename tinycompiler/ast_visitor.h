@@ -0,0 +1,110 @@
+/*
+ * ast_visitor.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef AST_VISITOR_H
+#define AST_VISITOR_H
+
+#include "parser.h"
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+
+namespace tinylang {
+
+/**
+ * @brief Statically dispatched syntax tree walker (CRTP).
+ *  Derived classes define pre_visit() and / or post_visit(); the hooks are
+ *  resolved at compile time and can be inlined into the walk. A hook
+ *  returns 0 for no error, and walk() returns the OR of all hooks.
+ *
+ * @code
+ *  class Counter : public AstVisitor<Counter> {
+ *  public:
+ *      int pre_visit(TreeNode *t) { ++count; return 0; }
+ *      int count = 0;
+ *  };
+ * @endcode
+ */
+template <class Derived>
+class AstVisitor {
+public:
+    //! @brief Walk the tree and all of its neighbors in order
+    int walk(TreeNode *node) {
+        int ret = 0;
+        // neighbors are visited in a loop, only children recurse
+        for (; node != nullptr; node = node->neighbor) {
+            ret |= this->walk_node(node);
+        }
+        return ret;
+    }
+
+    //! @brief Walk a node and its children, but not its neighbors
+    int walk_node(TreeNode *node) {
+        Derived &self = static_cast<Derived &>(*this);
+        int ret = self.pre_visit(node);
+        for (int i = 0; i < TreeNode::MAX_CHILDREN; ++i) {
+            if (node->children[i] != nullptr) {
+                ret |= this->walk(node->children[i]);
+            }
+        }
+        ret |= self.post_visit(node);
+        return ret;
+    }
+
+    //! @brief Called before the children of a node, does nothing by default
+    int pre_visit(TreeNode *) { return 0; }
+
+    //! @brief Called after the children of a node, does nothing by default
+    int post_visit(TreeNode *) { return 0; }
+};
+
+/**
+ * @brief Fuses several passes into a single walk of the tree.
+ *  At every node the pre_visit() hooks of the passes run in the given order,
+ *  then the children are walked, then the post_visit() hooks run in the
+ *  same order. A pass is any class with both hooks, usually an AstVisitor.
+ *  The passes are held by reference.
+ */
+template <class... Passes>
+class PassPipeline : public AstVisitor<PassPipeline<Passes...>> {
+public:
+    explicit PassPipeline(Passes &... passes) : passes_(passes...) {}
+
+    int pre_visit(TreeNode *node) { return this->pre_each<0>(node); }
+
+    int post_visit(TreeNode *node) { return this->post_each<0>(node); }
+
+private:
+    template <size_t I>
+    typename std::enable_if<I == sizeof...(Passes), int>::type
+    pre_each(TreeNode *) { return 0; }
+
+    template <size_t I>
+    typename std::enable_if<I < sizeof...(Passes), int>::type
+    pre_each(TreeNode *node) {
+        int ret = std::get<I>(passes_).pre_visit(node);
+        return ret | this->pre_each<I + 1>(node);
+    }
+
+    template <size_t I>
+    typename std::enable_if<I == sizeof...(Passes), int>::type
+    post_each(TreeNode *) { return 0; }
+
+    template <size_t I>
+    typename std::enable_if<I < sizeof...(Passes), int>::type
+    post_each(TreeNode *node) {
+        int ret = std::get<I>(passes_).post_visit(node);
+        return ret | this->post_each<I + 1>(node);
+    }
+
+private:
+    std::tuple<Passes &...> passes_;
+};
+
+} /* namespace tinylang */
+
+#endif /* !AST_VISITOR_H */
@@ -0,0 +1,59 @@
+/*
+ * bench.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace tinybench {
+
+/**
+ * @brief Run f for the given rounds and return the best wall time in seconds.
+ */
+template <class F>
+double best_seconds(int rounds, F f) {
+    double best = 0;
+    for (int i = 0; i < rounds; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        if (i == 0 || elapsed.count() < best) {
+            best = elapsed.count();
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Generate a syntactically valid TINY program with the given number of
+ *  statements. Every variable is defined before it is used.
+ */
+std::string make_program(size_t statements);
+
+/**
+ * @brief Generate a TINY program that runs an arithmetic loop for the given
+ *  number of iterations and writes two results, for the execution engines.
+ */
+std::string make_loop_program(int iterations);
+
+//! @brief Print one result line: name, time and throughput
+void report(const char *name, double seconds, double units, const char *unit);
+
+void bench_parser();
+void bench_analyser();
+void bench_symtable();
+void bench_dataflow();
+void bench_interp();
+void bench_gvn();
+
+} /* namespace tinybench */
+
+#endif /* !BENCH_H */
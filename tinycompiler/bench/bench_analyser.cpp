@@ -0,0 +1,90 @@
+/*
+ * bench_analyser.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include "../analyser.h"
+#include "../incremental_analyser.h"
+#include "../xref.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+using namespace tinylang;
+
+namespace tinybench {
+
+void bench_analyser() {
+    const size_t statements = 200000;
+    const std::string prog = make_program(statements);
+    Parser parser;
+    TreeNode *tree = parser.parse(prog.c_str(), prog.size());
+
+    double t = best_seconds(3, [&]() {
+        Analyser analyser;
+        analyser.analyse(tree);
+    });
+    report("semantic analysis", t, statements, "statements/s");
+
+    unsigned cores = std::max(2u, std::thread::hardware_concurrency());
+    for (unsigned threads = 2; threads <= cores; threads *= 2) {
+        double tp = best_seconds(3, [&]() {
+            Analyser analyser;
+            analyser.set_threads(threads);
+            analyser.analyse(tree);
+        });
+        char name[64];
+        snprintf(name, sizeof(name), "semantic analysis, %u threads", threads);
+        report(name, tp, statements, "statements/s");
+    }
+
+    XrefIndex index;
+    t = best_seconds(3, [&]() {
+        index = XrefIndex();
+        Analyser analyser;
+        XrefBuilder builder(&index, analyser.symtable(), index.add_file("bench.tny"));
+        analyser.analyse_with(tree, builder);
+        index.finish();
+    });
+    report("semantic analysis + xref index", t, statements, "statements/s");
+    const int queries = 1000000;
+    size_t found = 0;
+    t = best_seconds(3, [&]() {
+        for (int i = 0; i < queries; ++i) {
+            found += index.symbol_at(0, (i * 7919u) % prog.size()) >= 0;
+        }
+    });
+    report("xref symbol_at", t, queries, "queries/s");
+
+    // editor workload: retype one statement in the middle of the program
+    IncrementalAnalyser incremental;
+    incremental.analyse(tree);
+    const int edits = 1000;
+    Parser edit_parser;
+    t = best_seconds(3, [&]() {
+        for (int i = 0; i < edits; ++i) {
+            char edit[64];
+            snprintf(edit, sizeof(edit), "v%d := v%d + %d", i % 16, (i + 5) % 16, i);
+            TreeNode *stmt = edit_parser.parse(edit, strlen(edit));
+            incremental.replace(statements / 2 + i, 1, stmt);
+        }
+        edit_parser.reset();
+    });
+    report("incremental, 1-statement edit", t, edits, "edits/s");
+
+    Analyser analyser;
+    analyser.analyse(tree);
+    size_t occurrences = 0, bytes = 0;
+    for (size_t id = 0; id < analyser.symtable().size(); ++id) {
+        occurrences += analyser.symtable().record(id).lines.size();
+        bytes += analyser.symtable().record(id).lines.bytes();
+    }
+    printf("%-36s %10.3f bytes/occurrence\n", "",
+           static_cast<double>(bytes) / occurrences);
+}
+
+} /* namespace tinybench */
@@ -0,0 +1,53 @@
+/*
+ * bench_dataflow.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include "../definite_assignment.h"
+#include "../range_analysis.h"
+#include <cstdio>
+
+using namespace tinylang;
+
+namespace tinybench {
+
+void bench_dataflow() {
+    // every statement defines a new variable from the previous one, with a
+    // branch or a loop every 256 statements
+    const int variables = 100000;
+    std::string prog = "read v0";
+    char buf[256];
+    for (int i = 1; i < variables; ++i) {
+        if (i % 256 == 0) {
+            snprintf(buf, sizeof(buf),
+                     ";\nif v%d < 1 then v%d := 1 else read v%d end", i - 1, i, i);
+        } else if (i % 256 == 128) {
+            snprintf(buf, sizeof(buf),
+                     ";\nrepeat v%d := v%d - 1 until v%d < 0", i, i - 1, i);
+        } else {
+            snprintf(buf, sizeof(buf), ";\nv%d := v%d + 1", i, i - 1);
+        }
+        prog += buf;
+    }
+    Parser parser;
+    TreeNode *tree = parser.parse(prog.c_str(), prog.size());
+
+    DefiniteAssignment checker;
+    double t = best_seconds(3, [&]() { checker.check(tree); });
+    report("definite assignment, 100k variables", t, variables, "variables/s");
+
+    const size_t statements = 200000;
+    const std::string mixed = make_program(statements);
+    Parser mixed_parser;
+    TreeNode *mixed_tree = mixed_parser.parse(mixed.c_str(), mixed.size());
+    RangeAnalysis ranges;
+    t = best_seconds(3, [&]() { ranges.run(mixed_tree); });
+    report("range analysis", t, statements, "statements/s");
+    printf("%-36s %10zu of %zu run-time checks removed\n", "", ranges.proven(),
+           ranges.checks());
+}
+
+} /* namespace tinybench */
@@ -0,0 +1,59 @@
+/*
+ * bench_gvn.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include "../analyser.h"
+#include "../gvn.h"
+#include "../ssa_interpreter.h"
+#include <cstdio>
+
+using namespace tinylang;
+
+namespace tinybench {
+
+void bench_gvn() {
+    // the pass itself, on a large program
+    const size_t statements = 100000;
+    const std::string large = make_program(statements);
+    Parser parser;
+    TreeNode *tree = parser.parse(large.c_str(), large.size());
+    Analyser analyser;
+    analyser.analyse(tree);
+    SsaBuilder builder;
+    SsaFunction fn;
+    double tb = best_seconds(3, [&]() {
+        fn = builder.build(tree, analyser.symtable().size());
+    });
+    report("SSA construction", tb, statements, "statements/s");
+    size_t before = fn.size();
+    GlobalValueNumbering gvn;
+    double tg = best_seconds(1, [&]() { gvn.run(&fn); });
+    report("global value numbering", tg, before, "instructions/s");
+    printf("%-36s %10zu -> %zu instructions in the IR\n", "", before, fn.size());
+
+    // executed instructions, on the loop of the interp benchmark
+    const int iterations = 1000000;
+    const std::string loop = make_loop_program(iterations);
+    tree = parser.parse(loop.c_str(), loop.size());
+    analyser.analyse(tree);
+    fn = builder.build(tree, analyser.symtable().size());
+    FILE *out = fopen("/dev/null", "w");
+    SsaInterpreter interpreter(stdin, out);
+    double t0 = best_seconds(3, [&]() { interpreter.run(fn); });
+    uint64_t executed = interpreter.steps();
+    report("SSA interpreter", t0, executed, "SSA instructions/s");
+    gvn.run(&fn);
+    double t1 = best_seconds(3, [&]() { interpreter.run(fn); });
+    report("SSA interpreter after GVN", t1, interpreter.steps(), "SSA instructions/s");
+    printf("%-36s %10llu -> %llu instructions executed (%.1f%% fewer)\n", "",
+           static_cast<unsigned long long>(executed),
+           static_cast<unsigned long long>(interpreter.steps()),
+           100.0 * (executed - interpreter.steps()) / executed);
+    fclose(out);
+}
+
+} /* namespace tinybench */
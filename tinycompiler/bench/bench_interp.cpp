@@ -0,0 +1,99 @@
+/*
+ * bench_interp.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include "../analyser.h"
+#include "../elf_writer.h"
+#include "../interpreter.h"
+#include "../jit.h"
+#include "../register_vm.h"
+#include "../ssa_interpreter.h"
+#include "../stack_vm.h"
+#include "../tm_codegen.h"
+#include "../tm_simulator.h"
+#include <cstdio>
+
+using namespace tinylang;
+
+namespace tinybench {
+
+void bench_interp() {
+    const int iterations = 1000000;
+    const std::string prog = make_loop_program(iterations);
+    Parser parser;
+    TreeNode *tree = parser.parse(prog.c_str(), prog.size());
+    Analyser analyser;
+    analyser.analyse(tree);
+
+    FILE *out = fopen("/dev/null", "w");
+    Interpreter interpreter(stdin, out);
+    double t = best_seconds(3, [&]() {
+        interpreter.run(tree, analyser.symtable().size());
+    });
+    report("tree-walking interpreter", t, interpreter.steps(), "nodes/s");
+    report("", t, iterations, "iterations/s");
+
+    BytecodeCompiler compiler;
+    BytecodeProgram bytecode = compiler.compile(tree, analyser.symtable().size());
+    StackVM vm(stdin, out);
+    double tv = best_seconds(3, [&]() { vm.run(bytecode); });
+    report("stack VM", tv, iterations, "iterations/s");
+    printf("%-36s %10.2fx the interpreter, %zu bytes of code\n", "", t / tv,
+           bytecode.code.size());
+
+    RegisterCompiler reg_compiler;
+    RegisterProgram regcode = reg_compiler.compile(tree, analyser.symtable().size());
+    RegisterVM reg_vm(stdin, out);
+    double tr = best_seconds(3, [&]() { reg_vm.run(regcode); });
+    report("register VM", tr, iterations, "iterations/s");
+    printf("%-36s %10.2fx the interpreter, %.2fx the stack VM, %zu instructions\n",
+           "", t / tr, tv / tr, regcode.code.size());
+
+    SsaBuilder ssa_builder;
+    SsaFunction ssa = ssa_builder.build(tree, analyser.symtable().size());
+    SsaInterpreter ssa_interpreter(stdin, out);
+    double ts = best_seconds(3, [&]() { ssa_interpreter.run(ssa); });
+    report("SSA interpreter", ts, ssa_interpreter.steps(), "SSA instructions/s");
+    printf("%-36s %10llu instructions executed, %zu in the IR\n", "",
+           static_cast<unsigned long long>(ssa_interpreter.steps()), ssa.size());
+
+    FILE *tm_code = tmpfile();
+    TmCodeGenerator tm_codegen(tm_code);
+    tm_codegen.generate(tree, analyser.symtable().size());
+    rewind(tm_code);
+    TmSimulator sim(stdin, out);
+    sim.load(tm_code);
+    fclose(tm_code);
+    double ttm = best_seconds(3, [&]() { sim.run(tm_codegen.data_size()); });
+    report("TM simulator", ttm, sim.steps(), "TM instructions/s");
+    report("", ttm, iterations, "iterations/s");
+
+    JitCompiler jit_compiler;
+    JitProgram native = jit_compiler.compile(tree, analyser.symtable().size());
+    if (native.valid()) {
+        double tj = best_seconds(3, [&]() { native.run(stdin, out); });
+        report("x86-64 JIT", tj, iterations, "iterations/s");
+        printf("%-36s %10.2fx the interpreter, %.2fx the register VM, %zu bytes\n",
+               "", t / tj, tr / tj, native.size());
+    }
+    fclose(out);
+
+    // ahead of time: a standalone executable of a large program
+    const size_t statements = 100000;
+    const std::string large = make_program(statements);
+    TreeNode *large_tree = parser.parse(large.c_str(), large.size());
+    Analyser large_analyser;
+    large_analyser.analyse(large_tree);
+    ElfWriter writer;
+    double te = best_seconds(3, [&]() {
+        writer.build(large_tree, large_analyser.symtable().size());
+    });
+    report("ELF executable", te, statements, "statements/s");
+    printf("%-36s %10zu bytes\n", "", writer.image().size());
+}
+
+} /* namespace tinybench */
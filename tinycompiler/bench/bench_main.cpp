@@ -0,0 +1,96 @@
+/*
+ * bench_main.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include <cstdio>
+#include <cstring>
+
+namespace tinybench {
+
+std::string make_program(size_t statements) {
+    static const int NUM_VARS = 16;
+    std::string prog;
+    char buf[256];
+    for (int v = 0; v < NUM_VARS; ++v) {
+        snprintf(buf, sizeof(buf), "read v%d;\n", v);
+        prog += buf;
+    }
+    for (size_t i = 0; i < statements; ++i) {
+        int a = i % NUM_VARS;
+        int b = (i * 7 + 3) % NUM_VARS;
+        int c = (i * 13 + 5) % NUM_VARS;
+        switch (i % 8) {
+            case 3:
+                snprintf(buf, sizeof(buf),
+                         "if v%d < v%d then v%d := v%d - 1 else v%d := 2 end",
+                         a, b, a, b, c);
+                break;
+            case 5:
+                snprintf(buf, sizeof(buf),
+                         "repeat v%d := v%d + 1 until %d < v%d", a, a, 
+                         static_cast<int>(i % 97), a);
+                break;
+            case 7:
+                snprintf(buf, sizeof(buf), "write (v%d + %d) * v%d", a,
+                         static_cast<int>(i % 1000), b);
+                break;
+            default:
+                snprintf(buf, sizeof(buf),
+                         "v%d := (v%d + %d) * 3 - v%d / 2 { %zu }", a, b,
+                         static_cast<int>(i % 1000), c, i);
+                break;
+        }
+        prog += buf;
+        prog += (i + 1 == statements) ? "\n" : ";\n";
+    }
+    return prog;
+}
+
+std::string make_loop_program(int iterations) {
+    char buf[512];
+    snprintf(buf, sizeof(buf),
+             "n := %d; i := 0; s := 0; t := 1;\n"
+             "repeat\n"
+             "  s := (s + i * 3) - s / 7;\n"
+             "  if s < 1000000 then t := t + 1 else t := t - s / 3 end;\n"
+             "  i := i + 1\n"
+             "until n < i + 1;\n"
+             "write s; write t",
+             iterations);
+    return buf;
+}
+
+void report(const char *name, double seconds, double units, const char *unit) {
+    printf("%-36s %10.3f ms %12.2f %s\n", name, seconds * 1e3,
+           units / seconds, unit);
+}
+
+} /* namespace tinybench */
+
+struct BenchEntry {
+    const char *name;
+    void (*run)();
+};
+
+int main(int argc, char *argv[]) {
+    static const BenchEntry entries[] = {
+        {"parser", tinybench::bench_parser},
+        {"analyser", tinybench::bench_analyser},
+        {"symtable", tinybench::bench_symtable},
+        {"dataflow", tinybench::bench_dataflow},
+        {"interp", tinybench::bench_interp},
+        {"gvn", tinybench::bench_gvn},
+    };
+    for (const auto &entry : entries) {
+        if (argc > 1 && strcmp(argv[1], entry.name) != 0) {
+            continue;
+        }
+        printf("== %s\n", entry.name);
+        entry.run();
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * bench_parser.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include "../ll1parser.h"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+using namespace tinylang;
+
+// count heap allocations of the whole benchmark binary
+static size_t heap_allocations = 0;
+
+void *operator new(size_t size) {
+    ++heap_allocations;
+    void *ptr = malloc(size);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+    free(ptr);
+}
+
+namespace tinybench {
+
+void bench_parser() {
+    const std::string prog = make_program(200000);
+    const double mbytes = prog.size() / 1e6;
+
+    Scanner scanner;
+    double t = best_seconds(3, [&]() {
+        scanner.setInput(prog.c_str(), prog.size());
+        while (scanner.getToken() != TokenType::ENDFILE) {
+        }
+    });
+    report("scanner only", t, mbytes, "MB/s");
+
+    Parser parser;
+    t = best_seconds(3, [&]() {
+        parser.parse(prog.c_str(), prog.size());
+        parser.reset();
+    });
+    report("recursive descent, full AST", t, mbytes, "MB/s");
+
+    LL1Parser ll1_parser;
+    t = best_seconds(3, [&]() {
+        ll1_parser.parse(prog.c_str(), prog.size());
+        ll1_parser.reset();
+    });
+    report("table-driven LL(1), full AST", t, mbytes, "MB/s");
+
+    // break one statement in every 20000, every error must be reported
+    std::string broken = prog;
+    size_t line = 0;
+    for (size_t pos = 0; (pos = broken.find('\n', pos)) != std::string::npos; ++pos) {
+        size_t assign = broken.find(":=", pos);
+        if (++line % 20000 == 0 && assign != std::string::npos) {
+            broken[assign] = ' ';
+        }
+    }
+    parser.set_max_errors(1 << 30);
+    t = best_seconds(3, [&]() {
+        parser.parse(broken.c_str(), broken.size());
+        parser.reset();
+    });
+    report("recursive descent, broken input", t, mbytes, "MB/s");
+
+    Parser validator(ParseSyntaxOnly);
+    t = best_seconds(3, [&]() {
+        validator.parse(prog.c_str(), prog.size());
+    });
+    report("recursive descent, syntax only", t, mbytes, "MB/s");
+
+    // a compile service: many small programs through one long-lived parser
+    const std::string small = make_program(20);
+    const int programs = 20000;
+    size_t allocations = 0;
+    t = best_seconds(3, [&]() {
+        size_t before = heap_allocations;
+        for (int i = 0; i < programs; ++i) {
+            parser.parse(small.c_str(), small.size());
+            parser.reset();
+        }
+        allocations = heap_allocations - before;
+    });
+    report("recursive descent, small programs", t, programs, "programs/s");
+    printf("%-36s %10.3f allocations/parse\n", "",
+           static_cast<double>(allocations) / programs);
+}
+
+} /* namespace tinybench */
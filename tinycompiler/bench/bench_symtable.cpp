@@ -0,0 +1,130 @@
+/*
+ * bench_symtable.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include "../concurrent_symtable.h"
+#include "../scoped_symtable.h"
+#include "../symtable.h"
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace tinylang;
+
+namespace tinybench {
+
+//! @brief Run f(thread_index) on the given number of threads
+template <class F>
+static void run_threads(unsigned threads, F f) {
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) {
+        pool.emplace_back(f, t);
+    }
+    f(0);
+    for (std::thread & th : pool) {
+        th.join();
+    }
+}
+
+void bench_symtable() {
+    const int names = 4096, ops = 400000;
+    std::vector<std::string> keys;
+    for (int k = 0; k < names; ++k) {
+        keys.push_back("sym" + std::to_string(k));
+    }
+    // three uses per definition, like an ordinary program
+    auto key_of = [&](unsigned t, int i) -> const std::string & {
+        return keys[(i * 7 + t * 977) % names];
+    };
+
+    unsigned cores = std::max(4u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= cores; threads *= 2) {
+        int per_thread = ops / threads;
+        double t = best_seconds(3, [&]() {
+            SymTable st;
+            std::mutex mutex;
+            run_threads(threads, [&](unsigned tid) {
+                for (int i = 0; i < per_thread; ++i) {
+                    const std::string & key = key_of(tid, i);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (i % 4 == 0) {
+                        st.insert(key, i);
+                    } else {
+                        int id = st.lookup(key.c_str(), key.size());
+                        if (id >= 0)
+                            st.insert_line(id, i);
+                    }
+                }
+            });
+        });
+        char name[64];
+        snprintf(name, sizeof(name), "mutex SymTable, %u threads", threads);
+        report(name, t, ops, "ops/s");
+
+        t = best_seconds(3, [&]() {
+            ConcurrentSymTable st(names);
+            run_threads(threads, [&](unsigned tid) {
+                for (int i = 0; i < per_thread; ++i) {
+                    const std::string & key = key_of(tid, i);
+                    if (i % 4 == 0) {
+                        st.insert(key.c_str(), key.size(), i);
+                    } else {
+                        ConcurrentSymTable::Symbol * sym =
+                            st.lookup(key.c_str(), key.size());
+                        if (sym != nullptr)
+                            ConcurrentSymTable::insert_line(sym, i);
+                    }
+                }
+            });
+        });
+        snprintf(name, sizeof(name), "ConcurrentSymTable, %u threads", threads);
+        report(name, t, ops, "ops/s");
+    }
+
+    // nested blocks declaring a few locals each over many globals
+    const int blocks = 20000, locals = 4, depth = 8;
+    double t = best_seconds(3, [&]() {
+        ScopedSymTable st;
+        for (int k = 0; k < names; ++k)
+            st.insert(keys[k].c_str(), keys[k].size(), 0);
+        for (int b = 0; b < blocks; b += depth) {
+            for (int d = 0; d < depth; ++d) {
+                st.enter_scope();
+                for (int l = 0; l < locals; ++l) {
+                    const std::string & key = keys[(b + d * 31 + l) % names];
+                    st.declare(key.c_str(), key.size(), b);
+                }
+            }
+            for (int d = 0; d < depth; ++d)
+                st.exit_scope();
+        }
+    });
+    report("ScopedSymTable, undo stack", t, blocks, "scopes/s");
+
+    // fewer blocks, the copies are slow
+    const int copied_blocks = blocks / 100;
+    t = best_seconds(3, [&]() {
+        std::vector<std::unordered_map<std::string, int>> scopes(1);
+        for (int k = 0; k < names; ++k)
+            scopes.back()[keys[k]] = k;
+        for (int b = 0; b < copied_blocks; b += depth) {
+            for (int d = 0; d < depth; ++d) {
+                // copy the enclosing bindings
+                scopes.push_back(scopes.back());
+                for (int l = 0; l < locals; ++l)
+                    scopes.back()[keys[(b + d * 31 + l) % names]] = b;
+            }
+            scopes.resize(1);
+        }
+    });
+    report("copied scope maps", t, copied_blocks, "scopes/s");
+}
+
+} /* namespace tinybench */
@@ -0,0 +1,173 @@
+/*
+ * bytecode.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bytecode.h"
+#include <algorithm>
+
+namespace tinylang {
+
+static const char * const OPCODE_NAMES[] = {
+#define TINY_OPCODE_NAME(op, bytes) #op + 3,
+    TINY_STACK_OPCODES(TINY_OPCODE_NAME)
+#undef TINY_OPCODE_NAME
+};
+
+static const int OPCODE_IMM_BYTES[] = {
+#define TINY_OPCODE_BYTES(op, bytes) bytes,
+    TINY_STACK_OPCODES(TINY_OPCODE_BYTES)
+#undef TINY_OPCODE_BYTES
+};
+
+int instruction_size(Opcode op) {
+    return 1 + OPCODE_IMM_BYTES[op];
+}
+
+int BytecodeProgram::line_of(uint32_t offset) const {
+    auto it = std::lower_bound(div_lines.begin(), div_lines.end(),
+                               std::make_pair(offset, 0));
+    return it != div_lines.end() && it->first == offset ? it->second : 0;
+}
+
+void BytecodeProgram::print(FILE * out) const {
+    for (size_t pc = 0; pc < code.size();) {
+        Opcode op = static_cast<Opcode>(code[pc]);
+        fprintf(out, "%6zu  %s", pc, OPCODE_NAMES[op]);
+        for (int i = 0; i < OPCODE_IMM_BYTES[op]; i += 4)
+            fprintf(out, " %d", read_imm(&code[pc + 1 + i]));
+        fprintf(out, "\n");
+        pc += instruction_size(op);
+    }
+}
+
+void BytecodeCompiler::emit_imm(int32_t imm) {
+    size_t at = prog_.code.size();
+    prog_.code.resize(at + sizeof(imm));
+    memcpy(&prog_.code[at], &imm, sizeof(imm));
+}
+
+size_t BytecodeCompiler::jump_unless(TreeNode * cond) {
+    if (cond->expr != ExprOp ||
+        (cond->attr.op != TokenType::LT && cond->attr.op != TokenType::EQ)) {
+        this->expr(cond);
+        this->emit(OP_JUMP_FALSE, 0);
+        this->push(-1);
+        return prog_.code.size() - 4;
+    }
+    bool lt = cond->attr.op == TokenType::LT;
+    this->expr(cond->children[0]);
+    TreeNode * r = cond->children[1];
+    if (r->expr == ExprConst) {
+        this->emit(lt ? OP_JUMP_GEK : OP_JUMP_NEK, r->attr.val);
+        this->emit_imm(0);
+        this->push(-1);
+    } else {
+        this->expr(r);
+        this->emit(lt ? OP_JUMP_GE : OP_JUMP_NE, 0);
+        this->push(-2);
+    }
+    return prog_.code.size() - 4;
+}
+
+BytecodeProgram BytecodeCompiler::compile(TreeNode * tree, size_t slots) {
+    prog_ = BytecodeProgram();
+    prog_.slots = slots;
+    depth_ = 0;
+    this->stmt_sequence(tree);
+    this->emit(OP_HALT);
+    return std::move(prog_);
+}
+
+void BytecodeCompiler::stmt_sequence(TreeNode * t) {
+    for (; t != nullptr; t = t->neighbor) {
+        switch (t->stmt) {
+            case StmtIf: {
+                size_t to_else = this->jump_unless(t->children[0]);
+                this->stmt_sequence(t->children[1]);
+                if (t->children[2] != nullptr) {
+                    this->emit(OP_JUMP, 0);
+                    size_t to_end = prog_.code.size() - 4;
+                    this->patch(to_else, prog_.code.size());
+                    this->stmt_sequence(t->children[2]);
+                    this->patch(to_end, prog_.code.size());
+                } else {
+                    this->patch(to_else, prog_.code.size());
+                }
+                break;
+            }
+            case StmtRepeat: {
+                uint32_t body = prog_.code.size();
+                this->stmt_sequence(t->children[0]);
+                this->patch(this->jump_unless(t->children[1]), body);
+                break;
+            }
+            case StmtAssign: {
+                // x := x + k and x := x - k update the variable in place
+                TreeNode * e = t->children[0];
+                if (e->expr == ExprOp &&
+                    (e->attr.op == TokenType::PLUS || e->attr.op == TokenType::MINUS) &&
+                    e->children[0]->expr == ExprIdentifier &&
+                    e->children[0]->slot == t->slot &&
+                    e->children[1]->expr == ExprConst) {
+                    uint32_t k = e->children[1]->attr.val;
+                    this->emit(OP_INCR, t->slot);
+                    this->emit_imm(e->attr.op == TokenType::PLUS ? k : 0u - k);
+                    break;
+                }
+                this->expr(e);
+                this->emit(OP_STORE, t->slot);
+                this->push(-1);
+                break;
+            }
+            case StmtRead:
+                this->emit(OP_READ, t->slot);
+                break;
+            case StmtWrite:
+                this->expr(t->children[0]);
+                this->emit(OP_WRITE);
+                this->push(-1);
+                break;
+        }
+    }
+}
+
+void BytecodeCompiler::expr(TreeNode * e) {
+    if (e->expr == ExprConst) {
+        this->emit(OP_CONST, e->attr.val);
+        this->push(1);
+        return;
+    }
+    if (e->expr == ExprIdentifier) {
+        this->emit(OP_LOAD, e->slot);
+        this->push(1);
+        return;
+    }
+    Opcode op = OP_ADD;
+    switch (e->attr.op) {
+        case TokenType::PLUS: op = OP_ADD; break;
+        case TokenType::MINUS: op = OP_SUB; break;
+        case TokenType::TIMES: op = OP_MUL; break;
+        case TokenType::OVER: op = OP_DIV; break;
+        case TokenType::LT: op = OP_LT; break;
+        case TokenType::EQ: op = OP_EQ; break;
+        default: break;
+    }
+    this->expr(e->children[0]);
+    TreeNode * r = e->children[1];
+    // a constant right operand saves a push, except a zero divisor that
+    // has to fail at run time
+    if (r->expr == ExprConst && !(op == OP_DIV && r->attr.val == 0)) {
+        this->emit(static_cast<Opcode>(op - OP_ADD + OP_ADDK), r->attr.val);
+        return;
+    }
+    this->expr(r);
+    if (op == OP_DIV)
+        prog_.div_lines.emplace_back(prog_.code.size(), e->line_no);
+    this->emit(op);
+    this->push(-1);
+}
+
+} /* namespace tinylang */
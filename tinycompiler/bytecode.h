@@ -0,0 +1,118 @@
+/*
+ * bytecode.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include "parser.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace tinylang {
+
+/**
+ * @brief Opcodes of the stack bytecode and the bytes of their immediate.
+ *  A K suffix marks the form whose right operand is the constant immediate
+ *  instead of the top of the stack. The conditional jumps fuse a comparison
+ *  with the jump taken when it fails; an instruction with two immediates
+ *  has the constant or variable first and the target second.
+ */
+#define TINY_STACK_OPCODES(X) \
+    X(OP_HALT, 0)             \
+    X(OP_CONST, 4)  /* push k */                  \
+    X(OP_LOAD, 4)   /* push vars[s] */            \
+    X(OP_STORE, 4)  /* vars[s] = pop */           \
+    X(OP_ADD, 0)    X(OP_SUB, 0)  X(OP_MUL, 0)    \
+    X(OP_DIV, 0)    X(OP_LT, 0)   X(OP_EQ, 0)     \
+    X(OP_ADDK, 4)   X(OP_SUBK, 4) X(OP_MULK, 4)   \
+    X(OP_DIVK, 4)   X(OP_LTK, 4)  X(OP_EQK, 4)    \
+    X(OP_JUMP, 4)   /* pc = t */                  \
+    X(OP_JUMP_FALSE, 4) /* if !pop then pc = t */ \
+    X(OP_JUMP_GE, 4)    /* b = pop, a = pop; if !(a < b) then pc = t */ \
+    X(OP_JUMP_NE, 4)    /* b = pop, a = pop; if a != b then pc = t */   \
+    X(OP_JUMP_GEK, 8)   /* a = pop; if !(a < k) then pc = t */         \
+    X(OP_JUMP_NEK, 8)   /* a = pop; if a != k then pc = t */           \
+    X(OP_INCR, 8)   /* vars[s] += k */            \
+    X(OP_READ, 4)   /* vars[s] = input */         \
+    X(OP_WRITE, 0)  /* print pop */
+
+enum Opcode : uint8_t {
+#define TINY_OPCODE_ENUM(op, bytes) op,
+    TINY_STACK_OPCODES(TINY_OPCODE_ENUM)
+#undef TINY_OPCODE_ENUM
+    OPCODE_COUNT
+};
+
+//! @brief Bytes of an instruction, the opcode and its immediates
+int instruction_size(Opcode op);
+
+//! @brief 32-bit immediate at p, in host byte order and maybe unaligned
+inline int32_t read_imm(const uint8_t * p) {
+    int32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/**
+ * @brief Stack bytecode of a program: 1-byte opcodes, each followed by its
+ *  32-bit immediate if it has one. Jump targets are offsets in the code.
+ */
+struct BytecodeProgram {
+    std::vector<uint8_t> code;
+    size_t slots = 0;     // variables
+    size_t max_stack = 0; // deepest operand stack
+    std::vector<std::pair<uint32_t, int>> div_lines; // OP_DIV offset -> line
+
+    //! @brief Source line of the OP_DIV at the offset
+    int line_of(uint32_t offset) const;
+
+    //! @brief Print the disassembly
+    void print(FILE * out = stdout) const;
+};
+
+/**
+ * @brief Lower an analysed syntax tree into stack bytecode.
+ *  The variables are the slots the analyser gave the nodes.
+ */
+class BytecodeCompiler {
+public:
+    BytecodeProgram compile(TreeNode * tree, size_t slots);
+
+private:
+    void stmt_sequence(TreeNode * t);
+    void expr(TreeNode * e);
+
+    //! @brief Emit a jump taken if the condition is false
+    //! @return offset of its target, to be patched
+    size_t jump_unless(TreeNode * cond);
+
+    void emit(Opcode op) { prog_.code.push_back(op); }
+    void emit(Opcode op, int32_t imm) {
+        prog_.code.push_back(op);
+        this->emit_imm(imm);
+    }
+    void emit_imm(int32_t imm);
+    void patch(size_t at, uint32_t target) {
+        memcpy(&prog_.code[at], &target, sizeof(target));
+    }
+    void push(int n) {
+        depth_ += n;
+        prog_.max_stack = std::max(prog_.max_stack, static_cast<size_t>(depth_));
+    }
+
+private:
+    BytecodeProgram prog_;
+    int depth_ = 0; // of the operand stack at the code emitted so far
+};
+
+} /* namespace tinylang */
+
+#endif /* !BYTECODE_H */
@@ -0,0 +1,157 @@
+/*
+ * c_backend.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "c_backend.h"
+
+namespace tinylang {
+
+static const char C_PRELUDE[] =
+    "/* generated by tiny --emit-c */\n"
+    "#include <stdio.h>\n"
+    "#include <stdlib.h>\n"
+    "\n"
+    "static inline int tiny_add(int a, int b) { return (int)((unsigned)a + (unsigned)b); }\n"
+    "static inline int tiny_sub(int a, int b) { return (int)((unsigned)a - (unsigned)b); }\n"
+    "static inline int tiny_mul(int a, int b) { return (int)((unsigned)a * (unsigned)b); }\n"
+    "static inline int tiny_div(int a, int b, int line_no) {\n"
+    "    if (b == 0) {\n"
+    "        fflush(stdout);\n"
+    "        fprintf(stderr, \"file:%d: runtime error: division by zero\\n\", line_no);\n"
+    "        exit(255);\n"
+    "    }\n"
+    "    return b == -1 ? tiny_sub(0, a) : a / b;\n"
+    "}\n"
+    "static inline int tiny_read(void) {\n"
+    "    int v;\n"
+    "    return scanf(\"%d\", &v) == 1 ? v : 0;\n"
+    "}\n"
+    "\n"
+    "int main(void) {\n";
+
+void CEmitter::emit(TreeNode * tree, const SymTable & symtable) {
+    fputs(C_PRELUDE, out_);
+    // prefixed, so that no name clashes with C
+    for (size_t id = 0; id < symtable.size(); ++id) {
+        fprintf(out_, "    int v_%s = 0;\n", symtable.record(id).name.c_str());
+    }
+    // constant folding may have removed every use of a variable
+    for (size_t id = 0; id < symtable.size(); ++id) {
+        fprintf(out_, "    (void) v_%s;\n", symtable.record(id).name.c_str());
+    }
+    this->stmt_sequence(tree, 1);
+    fputs("    return 0;\n}\n", out_);
+}
+
+void CEmitter::var(const TreeNode * t) {
+    fprintf(out_, "v_%s", t->attr.name);
+}
+
+void CEmitter::stmt_sequence(TreeNode * t, int indent) {
+    for (; t != nullptr; t = t->neighbor) {
+        fprintf(out_, "%*s", indent * 4, "");
+        switch (t->stmt) {
+            case StmtIf:
+                fputs("if ", out_);
+                this->condition(t->children[0]);
+                fputs(" {\n", out_);
+                this->stmt_sequence(t->children[1], indent + 1);
+                if (t->children[2] != nullptr) {
+                    fprintf(out_, "%*s} else {\n", indent * 4, "");
+                    this->stmt_sequence(t->children[2], indent + 1);
+                }
+                fprintf(out_, "%*s}\n", indent * 4, "");
+                break;
+            case StmtRepeat:
+                fputs("do {\n", out_);
+                this->stmt_sequence(t->children[0], indent + 1);
+                fprintf(out_, "%*s} while (!", indent * 4, "");
+                this->condition(t->children[1]);
+                fputs(");\n", out_);
+                break;
+            case StmtAssign:
+                this->var(t);
+                fputs(" = ", out_);
+                this->expr(t->children[0]);
+                fputs(";\n", out_);
+                break;
+            case StmtRead:
+                this->var(t);
+                fputs(" = tiny_read();\n", out_);
+                break;
+            case StmtWrite:
+                fputs("printf(\"%d\\n\", ", out_);
+                this->expr(t->children[0]);
+                fputs(");\n", out_);
+                break;
+        }
+    }
+}
+
+void CEmitter::condition(TreeNode * e) {
+    // comparisons come with their parentheses
+    bool comparison = e->expr == ExprOp &&
+                      (e->attr.op == TokenType::LT || e->attr.op == TokenType::EQ);
+    if (!comparison)
+        fputs("(", out_);
+    this->expr(e);
+    if (!comparison)
+        fputs(")", out_);
+}
+
+void CEmitter::expr(TreeNode * e) {
+    if (e->expr == ExprConst) {
+        // INT_MIN has no literal in C
+        if (e->attr.val == -2147483647 - 1) {
+            fputs("(-2147483647 - 1)", out_);
+        } else {
+            fprintf(out_, "%d", e->attr.val);
+        }
+        return;
+    }
+    if (e->expr == ExprIdentifier) {
+        this->var(e);
+        return;
+    }
+    const char * fn = nullptr;
+    const char * c_op = nullptr;
+    switch (e->attr.op) {
+        case TokenType::PLUS: fn = "tiny_add"; c_op = " + "; break;
+        case TokenType::MINUS: fn = "tiny_sub"; c_op = " - "; break;
+        case TokenType::TIMES: fn = "tiny_mul"; c_op = " * "; break;
+        case TokenType::OVER: fn = "tiny_div"; c_op = " / "; break;
+        default: break;
+    }
+    if (fn == nullptr) {
+        fputs("(", out_);
+        this->expr(e->children[0]);
+        fputs(e->attr.op == TokenType::LT ? " < " : " == ", out_);
+        this->expr(e->children[1]);
+        fputs(")", out_);
+        return;
+    }
+    // the range analysis proved that the plain C operator can not trap
+    unsigned needed = SafeNoOverflow;
+    if (e->attr.op == TokenType::OVER)
+        needed |= SafeNoDivZero;
+    if ((e->safety & needed) == needed) {
+        fputs("(", out_);
+        this->expr(e->children[0]);
+        fputs(c_op, out_);
+        this->expr(e->children[1]);
+        fputs(")", out_);
+        return;
+    }
+    fprintf(out_, "%s(", fn);
+    this->expr(e->children[0]);
+    fputs(", ", out_);
+    this->expr(e->children[1]);
+    if (e->attr.op == TokenType::OVER)
+        fprintf(out_, ", %d", e->line_no);
+    fputs(")", out_);
+}
+
+} /* namespace tinylang */
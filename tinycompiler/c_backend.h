@@ -0,0 +1,46 @@
+/*
+ * c_backend.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef C_BACKEND_H
+#define C_BACKEND_H
+
+#include "parser.h"
+#include "symtable.h"
+#include <cstdio>
+
+namespace tinylang {
+
+/**
+ * @brief Lower an analysed syntax tree into a standalone C translation unit.
+ *  Each variable becomes a local of main() named after it, repeat-until a
+ *  do/while, read and write scanf and printf. Arithmetic goes through
+ *  small inline helpers that wrap in 32 bits and fail on a division by
+ *  zero like the Interpreter, so the C compiler is free to optimize
+ *  without undefined behaviour changing the result. An operation the
+ *  range analysis proved safe is written as the plain C operator.
+ */
+class CEmitter {
+public:
+    explicit CEmitter(FILE * out = stdout) : out_(out) {}
+
+    //! @param symtable The symbol table of the analysis, naming the slots
+    void emit(TreeNode * tree, const SymTable & symtable);
+
+private:
+    void stmt_sequence(TreeNode * t, int indent);
+    void expr(TreeNode * e);
+    //! @brief Emit the expression in parentheses, as the condition of a statement
+    void condition(TreeNode * e);
+    void var(const TreeNode * t);
+
+private:
+    FILE * out_;
+};
+
+} /* namespace tinylang */
+
+#endif /* !C_BACKEND_H */
@@ -0,0 +1,89 @@
+/*
+ * cfg.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "cfg.h"
+#include <algorithm>
+#include <utility>
+
+namespace tinylang {
+
+ControlFlowGraph::ControlFlowGraph(TreeNode * tree) {
+    exit_ = this->build(tree, this->new_block());
+}
+
+int ControlFlowGraph::new_block() {
+    blocks_.emplace_back();
+    return blocks_.size() - 1;
+}
+
+void ControlFlowGraph::add_edge(int from, int slot, int to) {
+    blocks_[from].succ[slot] = to;
+    blocks_[to].preds.push_back(from);
+}
+
+int ControlFlowGraph::build(TreeNode * stmts, int b) {
+    for (TreeNode * t = stmts; t != nullptr; t = t->neighbor) {
+        if (t->node_type != NodeStmt ||
+            (t->stmt != StmtIf && t->stmt != StmtRepeat)) {
+            blocks_[b].stmts.push_back(t);
+            continue;
+        }
+        if (t->stmt == StmtIf) {
+            blocks_[b].cond = t->children[0];
+            int then_block = this->new_block();
+            this->add_edge(b, 0, then_block);
+            int then_end = this->build(t->children[1], then_block);
+            int else_end = b;
+            if (t->children[2] != nullptr) {
+                int else_block = this->new_block();
+                this->add_edge(b, 1, else_block);
+                else_end = this->build(t->children[2], else_block);
+            }
+            int join = this->new_block();
+            this->add_edge(then_end, 0, join);
+            this->add_edge(else_end, else_end == b ? 1 : 0, join);
+            b = join;
+        } else {
+            int body = this->new_block();
+            this->add_edge(b, 0, body);
+            int body_end = this->build(t->children[0], body);
+            blocks_[body_end].cond = t->children[1];
+            int after = this->new_block();
+            // until the condition holds, run the body again
+            this->add_edge(body_end, 0, after);
+            this->add_edge(body_end, 1, body);
+            b = after;
+        }
+    }
+    return b;
+}
+
+std::vector<int> ControlFlowGraph::reverse_postorder() const {
+    std::vector<int> order;
+    std::vector<char> visited(blocks_.size(), 0);
+    // iterative DFS, a frame is (block, next successor slot)
+    std::vector<std::pair<int, int>> stack;
+    stack.emplace_back(this->entry(), 0);
+    visited[this->entry()] = 1;
+    while (!stack.empty()) {
+        std::pair<int, int> & frame = stack.back();
+        if (frame.second < 2) {
+            int s = blocks_[frame.first].succ[frame.second++];
+            if (s >= 0 && !visited[s]) {
+                visited[s] = 1;
+                stack.emplace_back(s, 0);
+            }
+        } else {
+            order.push_back(frame.first);
+            stack.pop_back();
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+} /* namespace tinylang */
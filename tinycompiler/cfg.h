@@ -0,0 +1,62 @@
+/*
+ * cfg.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef CFG_H
+#define CFG_H
+
+#include "parser.h"
+#include <vector>
+
+namespace tinylang {
+
+/**
+ * @brief A maximal run of statements without control flow.
+ *  The assign / read / write statements of the block run in order, then
+ *  the condition, if any, chooses the successor.
+ */
+struct BasicBlock {
+    std::vector<TreeNode *> stmts;
+    TreeNode * cond = nullptr; // condition of an if or of a repeat-until
+    int succ[2] = {-1, -1};    // {true, false} after a condition, else {next, -1}
+    std::vector<int> preds;
+};
+
+/**
+ * @brief Control flow graph of a statement list.
+ *  The entry is block 0 and the exit is an empty block without successors.
+ *  The body of a repeat loop always starts a block of its own, so the
+ *  entry block has no predecessors.
+ */
+class ControlFlowGraph {
+public:
+    explicit ControlFlowGraph(TreeNode * tree);
+
+    const std::vector<BasicBlock> & blocks() const { return blocks_; }
+    const BasicBlock & block(int b) const { return blocks_[b]; }
+    size_t size() const { return blocks_.size(); }
+
+    int entry() const { return 0; }
+    int exit() const { return exit_; }
+
+    //! @brief Blocks reachable from the entry, in reverse postorder
+    std::vector<int> reverse_postorder() const;
+
+private:
+    int new_block();
+    void add_edge(int from, int slot, int to);
+
+    //! @brief Append the statements to block b, return the block they end in
+    int build(TreeNode * stmts, int b);
+
+private:
+    std::vector<BasicBlock> blocks_;
+    int exit_;
+};
+
+} /* namespace tinylang */
+
+#endif /* !CFG_H */
@@ -0,0 +1,133 @@
+/*
+ * concurrent_symtable.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "concurrent_symtable.h"
+#include "symtable.h"
+#include <algorithm>
+
+namespace tinylang {
+
+const int ConcurrentSymTable::LineChunk::CAPACITY;
+
+std::vector<int> ConcurrentSymTable::Symbol::sorted_lines() const {
+    std::vector<int> result;
+    for (const LineChunk * chunk = lines.load(std::memory_order_acquire);
+         chunk != nullptr; chunk = chunk->next) {
+        int used = std::min(chunk->used.load(std::memory_order_relaxed),
+                            LineChunk::CAPACITY);
+        result.insert(result.end(), chunk->lines, chunk->lines + used);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+ConcurrentSymTable::ConcurrentSymTable(size_t capacity) : size_(0) {
+    // at least twice the names, to keep the probe sequences short
+    capacity_ = 16;
+    while (capacity_ < capacity * 2) {
+        capacity_ *= 2;
+    }
+    slots_ = new std::atomic<Symbol *>[capacity_];
+    for (size_t i = 0; i < capacity_; ++i) {
+        slots_[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+ConcurrentSymTable::~ConcurrentSymTable() {
+    for (size_t i = 0; i < capacity_; ++i) {
+        Symbol * sym = slots_[i].load(std::memory_order_relaxed);
+        if (sym == nullptr)
+            continue;
+        LineChunk * chunk = sym->lines.load(std::memory_order_relaxed);
+        while (chunk != nullptr) {
+            LineChunk * next = chunk->next;
+            delete chunk;
+            chunk = next;
+        }
+        delete sym;
+    }
+    delete[] slots_;
+}
+
+ConcurrentSymTable::Symbol *
+ConcurrentSymTable::insert(const char * name, size_t len, int line_no) {
+    uint32_t h = SymTable::hash(name, len);
+    size_t mask = capacity_ - 1;
+    Symbol * fresh = nullptr;
+    for (size_t n = 0, i = h & mask; n < capacity_; ++n, i = (i + 1) & mask) {
+        Symbol * sym = slots_[i].load(std::memory_order_acquire);
+        if (sym == nullptr) {
+            if (fresh == nullptr) {
+                fresh = new Symbol;
+                fresh->hash = h;
+                fresh->name.assign(name, len);
+                fresh->occurrences.store(0, std::memory_order_relaxed);
+                fresh->lines.store(nullptr, std::memory_order_relaxed);
+            }
+            if (slots_[i].compare_exchange_strong(sym, fresh,
+                                                  std::memory_order_acq_rel,
+                                                  std::memory_order_acquire)) {
+                size_.fetch_add(1, std::memory_order_relaxed);
+                insert_line(fresh, line_no);
+                return fresh;
+            }
+            // lost the race, sym is the symbol of the winner
+        }
+        if (sym->hash == h && sym->name.size() == len &&
+            memcmp(sym->name.data(), name, len) == 0) {
+            delete fresh;
+            insert_line(sym, line_no);
+            return sym;
+        }
+    }
+    delete fresh;
+    return nullptr;
+}
+
+void ConcurrentSymTable::insert_line(Symbol * sym, int line_no) {
+    sym->occurrences.fetch_add(1, std::memory_order_relaxed);
+    for (;;) {
+        LineChunk * head = sym->lines.load(std::memory_order_acquire);
+        if (head != nullptr) {
+            int slot = head->used.fetch_add(1, std::memory_order_relaxed);
+            if (slot < LineChunk::CAPACITY) {
+                head->lines[slot] = line_no;
+                return;
+            }
+        }
+        // the top chunk is full, push a new one holding the line
+        LineChunk * chunk = new LineChunk;
+        chunk->used.store(1, std::memory_order_relaxed);
+        chunk->lines[0] = line_no;
+        chunk->next = head;
+        if (sym->lines.compare_exchange_strong(head, chunk,
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed)) {
+            return;
+        }
+        delete chunk;
+    }
+}
+
+ConcurrentSymTable::Symbol *
+ConcurrentSymTable::lookup(const char * name, size_t len) const {
+    uint32_t h = SymTable::hash(name, len);
+    size_t mask = capacity_ - 1;
+    for (size_t n = 0, i = h & mask; n < capacity_; ++n, i = (i + 1) & mask) {
+        Symbol * sym = slots_[i].load(std::memory_order_acquire);
+        if (sym == nullptr) {
+            return nullptr;
+        }
+        if (sym->hash == h && sym->name.size() == len &&
+            memcmp(sym->name.data(), name, len) == 0) {
+            return sym;
+        }
+    }
+    return nullptr;
+}
+
+} /* namespace tinylang */
@@ -0,0 +1,104 @@
+/*
+ * concurrent_symtable.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef CONCURRENT_SYMTABLE_H
+#define CONCURRENT_SYMTABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace tinylang {
+
+/**
+ * @brief Symbol table that many threads can insert into and look up
+ *  without locks.
+ *  It is an open-addressing table of a fixed capacity whose slots are
+ *  atomic pointers to symbols. A symbol is published with a single
+ *  compare-and-swap on an empty slot and is never moved or removed before
+ *  the table is destroyed, so readers need no reclamation scheme. The
+ *  lines of a symbol are a lock-free stack of chunks, each line takes a
+ *  slot of the top chunk with a fetch-and-add.
+ */
+class ConcurrentSymTable {
+public:
+    struct LineChunk {
+        static const int CAPACITY = 30;
+        std::atomic<int> used; // reserved slots, may exceed CAPACITY
+        int lines[CAPACITY];
+        LineChunk * next;
+    };
+
+    struct Symbol {
+        uint32_t hash;
+        std::string name;
+        std::atomic<size_t> occurrences;
+        std::atomic<LineChunk *> lines;
+
+        /**
+         * @brief Lines of the symbol in ascending order.
+         *  Unlike the other members, call it only when no thread is
+         *  inserting lines of the symbol.
+         */
+        std::vector<int> sorted_lines() const;
+    };
+
+    //! @param capacity number of distinct names the table must hold
+    explicit ConcurrentSymTable(size_t capacity = 4096);
+
+    ~ConcurrentSymTable();
+
+    ConcurrentSymTable(const ConcurrentSymTable &) = delete;
+    ConcurrentSymTable & operator=(const ConcurrentSymTable &) = delete;
+
+    /**
+     * @brief Record an occurrence of the name.
+     *
+     * @return the symbol, or nullptr if the table is full
+     */
+    Symbol * insert(const char * name, size_t len, int line_no);
+
+    Symbol * insert(const char * name, int line_no) {
+        return this->insert(name, strlen(name), line_no);
+    }
+
+    //! @brief Record another occurrence of a known symbol
+    static void insert_line(Symbol * sym, int line_no);
+
+    //! @return the symbol, or nullptr if the name is not in the table
+    Symbol * lookup(const char * name, size_t len) const;
+
+    Symbol * lookup(const char * name) const {
+        return this->lookup(name, strlen(name));
+    }
+
+    //! @brief Number of symbols
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+    //! @brief Call f(const Symbol &) for every symbol, in slot order
+    template <class F>
+    void for_each(F f) const {
+        for (size_t i = 0; i < capacity_; ++i) {
+            const Symbol * sym = slots_[i].load(std::memory_order_acquire);
+            if (sym != nullptr) {
+                f(*sym);
+            }
+        }
+    }
+
+private:
+    size_t capacity_; // number of slots, a power of two
+    std::atomic<Symbol *> * slots_;
+    std::atomic<size_t> size_;
+};
+
+} /* namespace tinylang */
+
+#endif /* !CONCURRENT_SYMTABLE_H */
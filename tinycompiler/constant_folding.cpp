@@ -0,0 +1,188 @@
+/*
+ * constant_folding.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "constant_folding.h"
+#include "interpreter.h"
+
+namespace tinylang {
+
+static size_t count_nodes(const TreeNode * t) {
+    size_t n = 0;
+    for (; t != nullptr; t = t->neighbor) {
+        ++n;
+        for (int i = 0; i < TreeNode::MAX_CHILDREN; ++i) {
+            n += count_nodes(t->children[i]);
+        }
+    }
+    return n;
+}
+
+static bool is_const(const TreeNode * e, int value) {
+    return e->expr == ExprConst && e->attr.val == value;
+}
+
+//! @brief Whether evaluating e may stop the program with a division by zero
+static bool may_fail(const TreeNode * e) {
+    if (e->expr != ExprOp)
+        return false;
+    if (e->attr.op == TokenType::OVER && !(e->safety & SafeNoDivZero) &&
+        (e->children[1]->expr != ExprConst || e->children[1]->attr.val == 0))
+        return true;
+    return may_fail(e->children[0]) || may_fail(e->children[1]);
+}
+
+TreeNode * ConstantFolder::run(TreeNode * tree) {
+    removed_ = 0;
+    return this->stmt_sequence(tree);
+}
+
+void ConstantFolder::drop(TreeNode * t) {
+    removed_ += count_nodes(t);
+}
+
+TreeNode * ConstantFolder::stmt_sequence(TreeNode * t) {
+    TreeNode * head = nullptr;
+    TreeNode ** tail = &head;
+    while (t != nullptr) {
+        TreeNode * next = t->neighbor;
+        t->neighbor = nullptr;
+        *tail = this->statement(t);
+        while (*tail != nullptr)
+            tail = &(*tail)->neighbor;
+        t = next;
+    }
+    return head;
+}
+
+TreeNode * ConstantFolder::statement(TreeNode * t) {
+    switch (t->stmt) {
+        case StmtIf: {
+            t->children[1] = this->stmt_sequence(t->children[1]);
+            t->children[2] = this->stmt_sequence(t->children[2]);
+            int taken = this->condition(t->children[0]);
+            if (taken < 0)
+                return t;
+            TreeNode * branch = t->children[taken ? 1 : 2];
+            this->drop(t->children[0]);
+            this->drop(t->children[taken ? 2 : 1]);
+            ++removed_;
+            return branch;
+        }
+        case StmtRepeat: {
+            t->children[0] = this->stmt_sequence(t->children[0]);
+            if (this->condition(t->children[1]) != 1)
+                return t;
+            // the body runs once
+            this->drop(t->children[1]);
+            ++removed_;
+            return t->children[0];
+        }
+        case StmtAssign:
+        case StmtWrite:
+            this->expr(t->children[0]);
+            return t;
+        case StmtRead:
+            return t;
+    }
+    return t;
+}
+
+int ConstantFolder::condition(TreeNode * cond) {
+    this->expr(cond);
+    if (cond->expr != ExprOp)
+        return -1;
+    TreeNode * l = cond->children[0];
+    TreeNode * r = cond->children[1];
+    if (l->expr == ExprConst && r->expr == ExprConst) {
+        if (cond->attr.op == TokenType::LT)
+            return l->attr.val < r->attr.val;
+        return l->attr.val == r->attr.val;
+    }
+    if (l->expr == ExprIdentifier && r->expr == ExprIdentifier && l->slot == r->slot)
+        return cond->attr.op == TokenType::EQ; // x = x, x < x
+    return -1;
+}
+
+void ConstantFolder::replace(TreeNode * e, TreeNode * by) {
+    removed_ += count_nodes(e) - count_nodes(by);
+    *e = *by;
+}
+
+void ConstantFolder::replace(TreeNode * e, int value) {
+    removed_ += count_nodes(e) - 1;
+    e->expr = ExprConst;
+    e->attr.val = value;
+    e->children[0] = e->children[1] = nullptr;
+    e->safety = 0;
+}
+
+void ConstantFolder::expr(TreeNode * e) {
+    if (e->expr != ExprOp)
+        return;
+    TreeNode * l = e->children[0];
+    TreeNode * r = e->children[1];
+    this->expr(l);
+    this->expr(r);
+    TokenType op = e->attr.op;
+    if (op == TokenType::LT || op == TokenType::EQ)
+        return; // folded by condition()
+
+    if (l->expr == ExprConst && r->expr == ExprConst) {
+        unsigned a = l->attr.val;
+        unsigned b = r->attr.val;
+        switch (op) {
+            case TokenType::PLUS:
+                this->replace(e, static_cast<int>(a + b));
+                break;
+            case TokenType::MINUS:
+                this->replace(e, static_cast<int>(a - b));
+                break;
+            case TokenType::TIMES:
+                this->replace(e, static_cast<int>(a * b));
+                break;
+            default:
+                if (b != 0)
+                    this->replace(e, tiny_divide(l->attr.val, r->attr.val));
+                break;
+        }
+        return;
+    }
+
+    switch (op) {
+        case TokenType::PLUS:
+            if (is_const(l, 0)) {
+                this->replace(e, r);
+            } else if (is_const(r, 0)) {
+                this->replace(e, l);
+            }
+            break;
+        case TokenType::MINUS:
+            if (is_const(r, 0)) {
+                this->replace(e, l);
+            } else if (l->expr == ExprIdentifier && r->expr == ExprIdentifier &&
+                       l->slot == r->slot) {
+                this->replace(e, 0);
+            }
+            break;
+        case TokenType::TIMES:
+            if (is_const(l, 1)) {
+                this->replace(e, r);
+            } else if (is_const(r, 1)) {
+                this->replace(e, l);
+            } else if ((is_const(l, 0) && !may_fail(r)) ||
+                       (is_const(r, 0) && !may_fail(l))) {
+                this->replace(e, 0);
+            }
+            break;
+        default:
+            if (is_const(r, 1))
+                this->replace(e, l);
+            break;
+    }
+}
+
+} /* namespace tinylang */
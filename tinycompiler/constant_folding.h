@@ -0,0 +1,56 @@
+/*
+ * constant_folding.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef CONSTANT_FOLDING_H
+#define CONSTANT_FOLDING_H
+
+#include "parser.h"
+
+namespace tinylang {
+
+/**
+ * @brief Rewrite an analysed syntax tree to do less work at run time.
+ *  Operators on constants are evaluated with the wrapping semantics of the
+ *  Interpreter, except a division by zero, which stays to fail at run time.
+ *  The identities x + 0, x - 0, x * 1 and x / 1 reduce to x, and x * 0 and
+ *  x - x to 0 when x can not fail. An if with a constant condition is
+ *  replaced by the branch taken, a repeat whose condition is always true
+ *  by its body. Nodes are rewritten in place, so the slots and the types
+ *  set by the analyser stay valid.
+ */
+class ConstantFolder {
+public:
+    //! @return the folded tree, whose first statement may have changed
+    TreeNode * run(TreeNode * tree);
+
+    //! @brief Nodes removed by the last run
+    size_t removed() const { return removed_; }
+
+private:
+    //! @return the rewritten sequence, possibly empty
+    TreeNode * stmt_sequence(TreeNode * t);
+    //! @return the statements replacing t, possibly none
+    TreeNode * statement(TreeNode * t);
+
+    void expr(TreeNode * e);
+    //! @brief Replace e by one of its operands
+    void replace(TreeNode * e, TreeNode * by);
+    void replace(TreeNode * e, int value);
+
+    //! @return 1 or 0 for a constant condition, else -1
+    int condition(TreeNode * cond);
+
+    //! @brief Count the nodes of a dropped sequence or expression
+    void drop(TreeNode * t);
+
+private:
+    size_t removed_ = 0;
+};
+
+} /* namespace tinylang */
+
+#endif /* !CONSTANT_FOLDING_H */
@@ -0,0 +1,142 @@
+/*
+ * dataflow.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "dataflow.h"
+#include <algorithm>
+#include <deque>
+
+namespace tinylang {
+
+BitSet::BitSet(size_t bits, bool value)
+    : words_((bits + 63) / 64, 0), bits_(bits) {
+    this->fill(value);
+}
+
+void BitSet::fill(bool value) {
+    std::fill(words_.begin(), words_.end(), value ? ~uint64_t(0) : 0);
+    // keep the bits past the end clear, so that equal sets compare equal
+    if (value && (bits_ & 63) != 0) {
+        words_.back() &= (uint64_t(1) << (bits_ & 63)) - 1;
+    }
+}
+
+bool BitSet::union_with(const BitSet & other) {
+    uint64_t changed = 0;
+    for (size_t i = 0; i < words_.size(); ++i) {
+        uint64_t word = words_[i] | other.words_[i];
+        changed |= word ^ words_[i];
+        words_[i] = word;
+    }
+    return changed != 0;
+}
+
+bool BitSet::intersect_with(const BitSet & other) {
+    uint64_t changed = 0;
+    for (size_t i = 0; i < words_.size(); ++i) {
+        uint64_t word = words_[i] & other.words_[i];
+        changed |= word ^ words_[i];
+        words_[i] = word;
+    }
+    return changed != 0;
+}
+
+size_t BitSet::count() const {
+    size_t n = 0;
+    for (uint64_t word : words_) {
+        n += __builtin_popcountll(word);
+    }
+    return n;
+}
+
+DataflowResult solve_dataflow(const ControlFlowGraph & cfg,
+                              const BitVectorProblem & problem) {
+    const bool forward = problem.direction == DataflowForward;
+    const bool intersect = problem.meet == MeetIntersect;
+    const int boundary_block = forward ? cfg.entry() : cfg.exit();
+    size_t n = cfg.size();
+
+    DataflowResult result;
+    // the top of a must problem is the full set
+    result.in.assign(n, BitSet(problem.bits, intersect));
+    result.out.assign(n, BitSet(problem.bits, intersect));
+
+    std::vector<int> order = cfg.reverse_postorder();
+    if (!forward) {
+        std::reverse(order.begin(), order.end());
+    }
+    std::deque<int> worklist(order.begin(), order.end());
+    std::vector<char> queued(n, 0);
+    for (int b : order) {
+        queued[b] = 1;
+    }
+
+    BitSet in(problem.bits);
+    while (!worklist.empty()) {
+        int b = worklist.front();
+        worklist.pop_front();
+        queued[b] = 0;
+        const BasicBlock & block = cfg.block(b);
+
+        // meet over the blocks flowing into b
+        bool first = true;
+        auto meet = [&](int from) {
+            if (from < 0)
+                return;
+            if (first) {
+                in = result.out[from];
+                first = false;
+            } else if (intersect) {
+                in.intersect_with(result.out[from]);
+            } else {
+                in.union_with(result.out[from]);
+            }
+        };
+        if (b == boundary_block) {
+            in = problem.boundary;
+            first = false;
+        }
+        if (forward) {
+            for (int p : block.preds)
+                meet(p);
+        } else {
+            meet(block.succ[0]);
+            meet(block.succ[1]);
+        }
+        if (first) {
+            in.fill(intersect);
+        }
+
+        result.in[b] = in;
+        for (int bit : problem.kill[b]) {
+            in.reset(bit);
+        }
+        for (int bit : problem.gen[b]) {
+            in.set(bit);
+        }
+        ++result.visits;
+        if (in == result.out[b])
+            continue;
+        std::swap(result.out[b], in);
+
+        auto push = [&](int to) {
+            if (to >= 0 && !queued[to]) {
+                queued[to] = 1;
+                worklist.push_back(to);
+            }
+        };
+        if (forward) {
+            push(block.succ[0]);
+            push(block.succ[1]);
+        } else {
+            for (int p : block.preds)
+                push(p);
+        }
+    }
+    return result;
+}
+
+} /* namespace tinylang */
@@ -0,0 +1,97 @@
+/*
+ * dataflow.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef DATAFLOW_H
+#define DATAFLOW_H
+
+#include "cfg.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tinylang {
+
+/**
+ * @brief Dense fixed-size set of bits.
+ *  Set operations work on 64 bits at a time.
+ */
+class BitSet {
+public:
+    BitSet() = default;
+    explicit BitSet(size_t bits, bool value = false);
+
+    size_t size() const { return bits_; }
+
+    bool test(size_t i) const { return (words_[i >> 6] >> (i & 63)) & 1; }
+    void set(size_t i) { words_[i >> 6] |= uint64_t(1) << (i & 63); }
+    void reset(size_t i) { words_[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+
+    //! @brief Set every bit to the value
+    void fill(bool value);
+
+    //! @return whether the set changed
+    bool union_with(const BitSet & other);
+
+    //! @return whether the set changed
+    bool intersect_with(const BitSet & other);
+
+    //! @brief Number of bits set
+    size_t count() const;
+
+    bool operator==(const BitSet & other) const { return words_ == other.words_; }
+    bool operator!=(const BitSet & other) const { return words_ != other.words_; }
+
+private:
+    std::vector<uint64_t> words_;
+    size_t bits_ = 0;
+};
+
+enum DataflowDirection {
+    DataflowForward,
+    DataflowBackward
+};
+
+enum DataflowMeet {
+    MeetUnion,     // may problems
+    MeetIntersect  // must problems
+};
+
+/**
+ * @brief A gen / kill problem over a control flow graph.
+ *  The transfer function of a block is out = gen | (in & ~kill). The gen
+ *  and kill sets are lists of bits, as they are usually small.
+ */
+struct BitVectorProblem {
+    DataflowDirection direction = DataflowForward;
+    DataflowMeet meet = MeetUnion;
+    size_t bits = 0;
+    std::vector<std::vector<int>> gen;  // per block
+    std::vector<std::vector<int>> kill; // per block
+    BitSet boundary; // in of the entry (forward) or of the exit (backward)
+};
+
+/**
+ * @brief Fixed point of a problem.
+ *  in is the value where control enters the transfer function of a block:
+ *  its start for forward problems and its end for backward ones.
+ */
+struct DataflowResult {
+    std::vector<BitSet> in;
+    std::vector<BitSet> out;
+    size_t visits = 0; // transfer functions evaluated
+};
+
+/**
+ * @brief Solve the problem with a worklist seeded in reverse postorder
+ *  (postorder for backward problems).
+ */
+DataflowResult solve_dataflow(const ControlFlowGraph & cfg,
+                              const BitVectorProblem & problem);
+
+} /* namespace tinylang */
+
+#endif /* !DATAFLOW_H */
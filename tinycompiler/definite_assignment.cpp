@@ -0,0 +1,109 @@
+/*
+ * definite_assignment.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "definite_assignment.h"
+#include "analyser.h"
+#include "dataflow.h"
+#include "symtable.h"
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+namespace tinylang {
+
+//! @brief Call f(node) for every identifier of an expression
+template <class F>
+static void for_each_identifier(TreeNode * expr, F f) {
+    if (expr == nullptr || expr->node_type != NodeExpr)
+        return;
+    if (expr->expr == ExprIdentifier) {
+        f(expr);
+    } else if (expr->expr == ExprOp) {
+        for_each_identifier(expr->children[0], f);
+        for_each_identifier(expr->children[1], f);
+    }
+}
+
+static bool is_definition(const TreeNode * t) {
+    return t->node_type == NodeStmt && (t->stmt == StmtAssign || t->stmt == StmtRead);
+}
+
+//! @brief Expression evaluated by a simple statement, if any
+static TreeNode * evaluated_expr(TreeNode * t) {
+    if (t->node_type == NodeStmt && (t->stmt == StmtAssign || t->stmt == StmtWrite))
+        return t->children[0];
+    return nullptr;
+}
+
+int DefiniteAssignment::check(TreeNode * tree) {
+    ControlFlowGraph cfg(tree);
+
+    // number the variables
+    SymTable names;
+    auto id_of = [&names](TreeNode * t) {
+        int id = names.lookup(t->attr.name);
+        return id >= 0 ? id : names.insert(t->attr.name, t->line_no);
+    };
+    BitVectorProblem problem;
+    problem.direction = DataflowForward;
+    problem.meet = MeetIntersect;
+    problem.gen.resize(cfg.size());
+    problem.kill.resize(cfg.size());
+    for (size_t b = 0; b < cfg.size(); ++b) {
+        const BasicBlock & block = cfg.block(b);
+        for (TreeNode * t : block.stmts) {
+            for_each_identifier(evaluated_expr(t), id_of);
+            if (is_definition(t))
+                problem.gen[b].push_back(id_of(t));
+        }
+        for_each_identifier(block.cond, id_of);
+    }
+    variables_ = names.size();
+    problem.bits = variables_;
+    problem.boundary = BitSet(variables_);
+
+    DataflowResult result = solve_dataflow(cfg, problem);
+
+    // tagged with the line, blocks are not in program order
+    DiagnosticLog log;
+    auto check_use = [&](const BitSet & assigned, TreeNode * t) {
+        if (assigned.test(names.lookup(t->attr.name)))
+            return;
+        log.event = t->line_no;
+        log.error("file:%d: error: '%s' may be used before it is assigned\n",
+                  t->line_no, t->attr.name);
+    };
+    BitSet assigned;
+    for (size_t b = 0; b < cfg.size(); ++b) {
+        const BasicBlock & block = cfg.block(b);
+        assigned = result.in[b];
+        for (TreeNode * t : block.stmts) {
+            for_each_identifier(evaluated_expr(t), [&](TreeNode * use) {
+                check_use(assigned, use);
+            });
+            if (is_definition(t))
+                assigned.set(names.lookup(t->attr.name));
+        }
+        for_each_identifier(block.cond, [&](TreeNode * use) {
+            check_use(assigned, use);
+        });
+    }
+
+    std::stable_sort(log.entries.begin(), log.entries.end(),
+                     [](const std::pair<size_t, std::string> & a,
+                        const std::pair<size_t, std::string> & b) {
+                         return a.first < b.first;
+                     });
+    diagnostics_.clear();
+    for (const auto & entry : log.entries) {
+        fputs(entry.second.c_str(), stdout);
+        diagnostics_.push_back(entry.second);
+    }
+    return log.entries.empty() ? 0 : -1;
+}
+
+} /* namespace tinylang */
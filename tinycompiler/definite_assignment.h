@@ -0,0 +1,47 @@
+/*
+ * definite_assignment.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef DEFINITE_ASSIGNMENT_H
+#define DEFINITE_ASSIGNMENT_H
+
+#include "parser.h"
+#include <string>
+#include <vector>
+
+namespace tinylang {
+
+/**
+ * @brief Check that every variable is assigned on all paths to its uses.
+ *  Unlike the symbol table pass, which accepts a use after any earlier
+ *  definition in the text, this follows the control flow: an assignment in
+ *  one branch of an if does not cover a use after it, while an assignment
+ *  in a repeat body does cover the condition and the code after the loop.
+ */
+class DefiniteAssignment {
+public:
+    /**
+     * @brief Solve the problem on the control flow graph of the tree and
+     *  report the uses that may see an unassigned variable, by line.
+     *
+     * @return 0 for no error.
+     */
+    int check(TreeNode * tree);
+
+    //! @brief Messages of the last check, in the order they were printed
+    const std::vector<std::string> & diagnostics() const { return diagnostics_; }
+
+    //! @brief Number of variables of the last check
+    size_t variables() const { return variables_; }
+
+private:
+    std::vector<std::string> diagnostics_;
+    size_t variables_ = 0;
+};
+
+} /* namespace tinylang */
+
+#endif /* !DEFINITE_ASSIGNMENT_H */
@@ -0,0 +1,378 @@
+/*
+ * elf_writer.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "elf_writer.h"
+#include "x64_codegen.h"
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+
+namespace tinylang {
+
+namespace {
+
+const uint64_t BASE_ADDR = 0x400000;
+const uint64_t PAGE_SIZE = 0x1000;
+const size_t EHDR_SIZE = 64;
+const size_t PHDR_SIZE = 56;
+const size_t HEADERS_SIZE = EHDR_SIZE + 2 * PHDR_SIZE; // the code follows
+
+// the data segment, zero-filled by the loader; the runtime pointer of the
+// generated code points at its start
+const int32_t BUF_SIZE = 4096;
+const int32_t OUT_LEN = 0;
+const int32_t IN_POS = 8;
+const int32_t IN_LEN = 16;
+const int32_t DIGITS_END = 40; // a number is formatted backwards from here
+const int32_t OUT_BUF = 64;
+const int32_t IN_BUF = OUT_BUF + BUF_SIZE;
+const int32_t VARS = IN_BUF + BUF_SIZE;
+
+const int SYS_READ = 0;
+const int SYS_WRITE = 1;
+const int SYS_EXIT_GROUP = 231;
+
+const char DIV_ZERO_PREFIX[] = "file:";
+const char DIV_ZERO_SUFFIX[] = ": runtime error: division by zero\n";
+
+struct Runtime {
+    X64Assembler::Label flush, flush_err, format, append, getc;
+    X64Assembler::Label prefix, suffix; // messages
+};
+
+// The routines take the runtime in RDI and clobber only caller-saved
+// registers; the comments name the registers each one clobbers
+
+//! flush(rt), flush_err(rt): write out the output buffer to stdout or to
+//! stderr; RAX RCX RDX RSI R11
+void emit_flush(X64Assembler & as, X64Assembler::Label & entry, int fd) {
+    X64Assembler::Label loop, done;
+    as.bind(entry);
+    as.push64(RDI);
+    as.lea64(RSI, RDI, OUT_BUF);
+    as.load64(RDX, RDI, OUT_LEN);
+    as.bind(loop);
+    as.alu64(AluCmp, RDX, 0);
+    as.jcc(CondLE, done);
+    as.mov(RAX, SYS_WRITE);
+    as.mov(RDI, fd);
+    as.syscall();
+    as.alu64(AluCmp, RAX, 0);
+    as.jcc(CondLE, done); // the output is lost, as with a failing stdio
+    as.alu64(AluAdd, RSI, RAX);
+    as.alu64(AluSub, RDX, RAX);
+    as.jmp(loop);
+    as.bind(done);
+    as.pop64(RDI);
+    as.mov(RAX, 0);
+    as.store64(RDI, OUT_LEN, RAX);
+    as.ret();
+}
+
+//! format(rt, value): append the decimal digits; RAX RCX RDX R8 R9 R10
+void emit_format(X64Assembler & as, Runtime & rt) {
+    X64Assembler::Label positive, digit, copy, byte;
+    as.bind(rt.format);
+    as.mov(RAX, RSI);
+    as.test(RAX, RAX);
+    as.jcc(CondGE, positive);
+    as.neg(RAX); // INT_MIN stays, read as unsigned
+    as.bind(positive);
+    as.lea64(R8, RDI, DIGITS_END);
+    as.mov(RCX, 10);
+    as.bind(digit);
+    as.mov(RDX, 0);
+    as.div(RCX);
+    as.alu(AluAdd, RDX, '0');
+    as.alu64(AluSub, R8, 1);
+    as.store8(R8, 0, RDX);
+    as.test(RAX, RAX);
+    as.jcc(CondNE, digit);
+    as.test(RSI, RSI);
+    as.jcc(CondGE, copy);
+    as.alu64(AluSub, R8, 1);
+    as.mov(RDX, '-');
+    as.store8(R8, 0, RDX);
+    as.bind(copy);
+    as.load64(RAX, RDI, OUT_LEN);
+    as.lea64(R9, RDI, OUT_BUF);
+    as.alu64(AluAdd, R9, RAX);
+    as.lea64(R10, RDI, DIGITS_END);
+    as.alu64(AluSub, R10, R8);
+    as.alu64(AluAdd, RAX, R10);
+    as.store64(RDI, OUT_LEN, RAX);
+    as.bind(byte);
+    as.load8(RDX, R8, 0);
+    as.store8(R9, 0, RDX);
+    as.alu64(AluAdd, R8, 1);
+    as.alu64(AluAdd, R9, 1);
+    as.alu64(AluSub, R10, 1);
+    as.jcc(CondNE, byte);
+    as.ret();
+}
+
+//! append(rt, bytes, count): append count > 0 bytes; RAX RCX RDX RSI R11
+void emit_append(X64Assembler & as, Runtime & rt) {
+    X64Assembler::Label byte;
+    as.bind(rt.append);
+    as.load64(RAX, RDI, OUT_LEN);
+    as.lea64(RCX, RDI, OUT_BUF);
+    as.alu64(AluAdd, RCX, RAX);
+    as.alu64(AluAdd, RAX, RDX);
+    as.store64(RDI, OUT_LEN, RAX);
+    as.bind(byte);
+    as.load8(R11, RSI, 0);
+    as.store8(RCX, 0, R11);
+    as.alu64(AluAdd, RSI, 1);
+    as.alu64(AluAdd, RCX, 1);
+    as.alu(AluSub, RDX, 1);
+    as.jcc(CondNE, byte);
+    as.ret();
+}
+
+//! write(rt, value): the number and a newline
+void emit_write(X64Assembler & as, Runtime & rt) {
+    X64Assembler::Label room;
+    as.load64(RAX, RDI, OUT_LEN);
+    as.alu64(AluCmp, RAX, BUF_SIZE - 16);
+    as.jcc(CondL, room);
+    as.push64(RSI);
+    as.call(rt.flush);
+    as.pop64(RSI);
+    as.bind(room);
+    as.call(rt.format);
+    as.load64(RAX, RDI, OUT_LEN);
+    as.lea64(RCX, RDI, OUT_BUF);
+    as.alu64(AluAdd, RCX, RAX);
+    as.mov(RDX, '\n');
+    as.store8(RCX, 0, RDX);
+    as.alu64(AluAdd, RAX, 1);
+    as.store64(RDI, OUT_LEN, RAX);
+    as.ret();
+}
+
+//! getc(rt in R8): the next input byte, or -1 at the end of the input;
+//! RAX RCX RDX RSI RDI R11. The output is flushed before blocking on input.
+void emit_getc(X64Assembler & as, Runtime & rt) {
+    X64Assembler::Label have, eof;
+    as.bind(rt.getc);
+    as.load64(RAX, R8, IN_POS);
+    as.load64(RDX, R8, IN_LEN);
+    as.alu64(AluCmp, RAX, RDX);
+    as.jcc(CondL, have);
+    as.mov64(RDI, R8);
+    as.call(rt.flush);
+    as.mov(RAX, SYS_READ);
+    as.mov(RDI, 0);
+    as.lea64(RSI, R8, IN_BUF);
+    as.mov(RDX, BUF_SIZE);
+    as.syscall();
+    as.alu64(AluCmp, RAX, 0);
+    as.jcc(CondLE, eof);
+    as.store64(R8, IN_LEN, RAX);
+    as.mov(RAX, 0);
+    as.bind(have);
+    as.lea64(RDX, R8, IN_BUF);
+    as.alu64(AluAdd, RDX, RAX);
+    as.load8(RCX, RDX, 0);
+    as.alu64(AluAdd, RAX, 1);
+    as.store64(R8, IN_POS, RAX);
+    as.mov(RAX, RCX);
+    as.ret();
+    as.bind(eof);
+    as.mov(RAX, -1);
+    as.ret();
+}
+
+//! read(rt): the next integer like scanf("%d"), or 0 if there is none
+void emit_read(X64Assembler & as, Runtime & rt) {
+    X64Assembler::Label skip, plus, sign, digit, end, value, done;
+    as.mov64(R8, RDI);
+    as.bind(skip);
+    as.call(rt.getc);
+    as.alu(AluCmp, RAX, ' ');
+    as.jcc(CondE, skip);
+    as.mov(RCX, RAX);
+    as.alu(AluSub, RCX, '\t');
+    as.alu(AluCmp, RCX, '\r' - '\t');
+    as.jcc(CondBE, skip);
+    as.mov(R9, 0);  // negative
+    as.mov(R10, 0); // value
+    as.alu(AluCmp, RAX, '-');
+    as.jcc(CondNE, plus);
+    as.mov(R9, 1);
+    as.jmp(sign);
+    as.bind(plus);
+    as.alu(AluCmp, RAX, '+');
+    as.jcc(CondNE, digit);
+    as.bind(sign);
+    as.call(rt.getc);
+    as.bind(digit);
+    as.mov(RCX, RAX);
+    as.alu(AluSub, RCX, '0');
+    as.alu(AluCmp, RCX, 9);
+    as.jcc(CondA, end);
+    as.imul(R10, R10, 10);
+    as.alu(AluAdd, R10, RCX);
+    as.call(rt.getc);
+    as.jmp(digit);
+    as.bind(end);
+    // leave the byte after the number for the next read
+    as.alu(AluCmp, RAX, -1);
+    as.jcc(CondE, value);
+    as.load64(RAX, R8, IN_POS);
+    as.alu64(AluSub, RAX, 1);
+    as.store64(R8, IN_POS, RAX);
+    as.bind(value);
+    as.mov(RAX, R10);
+    as.test(R9, R9);
+    as.jcc(CondE, done);
+    as.neg(RAX);
+    as.bind(done);
+    as.ret();
+}
+
+//! div_zero(rt, line_no): the message of the Interpreter, on stderr after
+//! the output so far
+void emit_div_zero(X64Assembler & as, Runtime & rt) {
+    as.push64(RBX);
+    as.mov(RBX, RSI);
+    as.call(rt.flush);
+    as.lea64(RSI, rt.prefix);
+    as.mov(RDX, sizeof(DIV_ZERO_PREFIX) - 1);
+    as.call(rt.append);
+    as.mov(RSI, RBX);
+    as.call(rt.format);
+    as.lea64(RSI, rt.suffix);
+    as.mov(RDX, sizeof(DIV_ZERO_SUFFIX) - 1);
+    as.call(rt.append);
+    as.call(rt.flush_err);
+    as.pop64(RBX);
+    as.ret();
+}
+
+void emit_string(X64Assembler & as, X64Assembler::Label & label, const char * s) {
+    as.bind(label);
+    for (; *s != '\0'; ++s) {
+        as.emit8(*s);
+    }
+}
+
+void put16(std::vector<uint8_t> & out, uint16_t v) {
+    out.push_back(v & 0xff);
+    out.push_back(v >> 8);
+}
+
+void put32(std::vector<uint8_t> & out, uint32_t v) {
+    put16(out, v & 0xffff);
+    put16(out, v >> 16);
+}
+
+void put64(std::vector<uint8_t> & out, uint64_t v) {
+    put32(out, v & 0xffffffff);
+    put32(out, v >> 32);
+}
+
+void put_phdr(std::vector<uint8_t> & out, uint32_t flags, uint64_t vaddr,
+              uint64_t filesz, uint64_t memsz) {
+    put32(out, 1); // PT_LOAD
+    put32(out, flags);
+    put64(out, 0); // offset, congruent to the page-aligned address
+    put64(out, vaddr);
+    put64(out, vaddr);
+    put64(out, filesz);
+    put64(out, memsz);
+    put64(out, PAGE_SIZE);
+}
+
+} /* namespace */
+
+const std::vector<uint8_t> & ElfWriter::build(TreeNode * tree, size_t slots) {
+    X64Assembler as;
+    X64CodeGenerator codegen(&as);
+    Runtime rt;
+    X64Assembler::Label start, program, data;
+
+    // _start: run the program on the data segment, flush and exit
+    as.bind(start);
+    as.lea64(RBX, data);
+    as.mov64(RDI, RBX);
+    as.lea64(RSI, RBX, VARS);
+    as.call(program);
+    as.mov(R12, RAX);
+    as.mov64(RDI, RBX);
+    as.call(rt.flush);
+    X64Assembler::Label status;
+    as.mov(RDI, 0);
+    as.test(R12, R12);
+    as.jcc(CondE, status);
+    as.mov(RDI, 255);
+    as.bind(status);
+    as.mov(RAX, SYS_EXIT_GROUP);
+    as.syscall();
+
+    as.bind(program);
+    codegen.generate(tree);
+
+    as.bind(codegen.label(CallRead));
+    emit_read(as, rt);
+    as.bind(codegen.label(CallWrite));
+    emit_write(as, rt);
+    as.bind(codegen.label(CallDivZero));
+    emit_div_zero(as, rt);
+    emit_flush(as, rt.flush, 1);
+    emit_flush(as, rt.flush_err, 2);
+    emit_format(as, rt);
+    emit_append(as, rt);
+    emit_getc(as, rt);
+    emit_string(as, rt.prefix, DIV_ZERO_PREFIX);
+    emit_string(as, rt.suffix, DIV_ZERO_SUFFIX);
+
+    uint64_t code_addr = BASE_ADDR + HEADERS_SIZE;
+    uint64_t end = code_addr + as.size();
+    uint64_t data_addr = (end + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+    as.bind(data, data_addr - code_addr);
+
+    const uint8_t ident[16] = {0x7f, 'E', 'L', 'F', 2 /* 64-bit */,
+                               1 /* little endian */, 1 /* version */};
+    image_.assign(ident, ident + sizeof(ident));
+    put16(image_, 2);    // ET_EXEC
+    put16(image_, 0x3e); // EM_X86_64
+    put32(image_, 1);
+    put64(image_, code_addr + start.pos);
+    put64(image_, EHDR_SIZE); // program headers
+    put64(image_, 0);         // no section headers
+    put32(image_, 0);
+    put16(image_, EHDR_SIZE);
+    put16(image_, PHDR_SIZE);
+    put16(image_, 2);
+    put16(image_, 0);
+    put16(image_, 0);
+    put16(image_, 0);
+    // the headers and code read-only and executable, the data writable
+    put_phdr(image_, 5, BASE_ADDR, end - BASE_ADDR, end - BASE_ADDR);
+    put_phdr(image_, 6, data_addr, 0, VARS + slots * sizeof(int));
+    image_.insert(image_.end(), as.code().begin(), as.code().end());
+    return image_;
+}
+
+int ElfWriter::write(const char * path) const {
+    FILE * fp = fopen(path, "wb");
+    if (fp == nullptr) {
+        printf("error: cannot open file %s\n", path);
+        return -1;
+    }
+    bool ok = fwrite(image_.data(), 1, image_.size(), fp) == image_.size();
+    ok = fclose(fp) == 0 && ok;
+    if (!ok || chmod(path, 0755) != 0) {
+        printf("error: cannot write file %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+} /* namespace tinylang */
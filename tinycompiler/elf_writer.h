@@ -0,0 +1,41 @@
+/*
+ * elf_writer.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef ELF_WRITER_H
+#define ELF_WRITER_H
+
+#include "parser.h"
+#include <cstdint>
+#include <vector>
+
+namespace tinylang {
+
+/**
+ * @brief Compile an analysed syntax tree to a static x86-64 Linux ELF
+ *  executable, without an assembler or linker. The code of the JIT is
+ *  followed by a runtime of raw system calls with buffered input and
+ *  output, so the executable links against nothing. It exits with 0, or
+ *  255 after a run-time error. The image can be built on any host.
+ */
+class ElfWriter {
+public:
+    //! @brief Build the image of the executable in memory
+    const std::vector<uint8_t> & build(TreeNode * tree, size_t slots);
+
+    const std::vector<uint8_t> & image() const { return image_; }
+
+    //! @brief Write the image built last as an executable file
+    //! @return 0 for success
+    int write(const char * path) const;
+
+private:
+    std::vector<uint8_t> image_;
+};
+
+} /* namespace tinylang */
+
+#endif /* !ELF_WRITER_H */
@@ -0,0 +1,209 @@
+/*
+ * gvn.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "gvn.h"
+#include <map>
+#include <utility>
+
+namespace tinylang {
+
+DominatorTree::DominatorTree(const SsaFunction & fn) {
+    size_t n = fn.blocks().size();
+    // reverse postorder by an iterative DFS, a frame is (block, next successor slot)
+    std::vector<int> order;
+    std::vector<int> rpo(n, -1);
+    std::vector<char> visited(n, 0);
+    std::vector<std::pair<int, int>> stack;
+    stack.emplace_back(0, 0);
+    visited[0] = 1;
+    while (!stack.empty()) {
+        std::pair<int, int> & frame = stack.back();
+        if (frame.second < 2) {
+            int s = fn.block(frame.first).succ[frame.second++];
+            if (s >= 0 && !visited[s]) {
+                visited[s] = 1;
+                stack.emplace_back(s, 0);
+            }
+        } else {
+            order.push_back(frame.first);
+            stack.pop_back();
+        }
+    }
+    std::vector<int>(order.rbegin(), order.rend()).swap(order);
+    for (size_t i = 0; i < order.size(); ++i) {
+        rpo[order[i]] = i;
+    }
+
+    idom_.assign(n, -1);
+    idom_[0] = 0;
+    auto intersect = [&](int a, int b) {
+        while (a != b) {
+            while (rpo[a] > rpo[b])
+                a = idom_[a];
+            while (rpo[b] > rpo[a])
+                b = idom_[b];
+        }
+        return a;
+    };
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (size_t i = 1; i < order.size(); ++i) {
+            int b = order[i];
+            int new_idom = -1;
+            for (int p : fn.block(b).preds) {
+                if (idom_[p] < 0)
+                    continue; // not processed yet
+                new_idom = new_idom < 0 ? p : intersect(p, new_idom);
+            }
+            if (idom_[b] != new_idom) {
+                idom_[b] = new_idom;
+                changed = true;
+            }
+        }
+    }
+    children_.resize(n);
+    for (size_t b = 1; b < n; ++b) {
+        if (idom_[b] >= 0)
+            children_[idom_[b]].push_back(b);
+    }
+}
+
+bool DominatorTree::dominates(int a, int b) const {
+    while (b != a && this->idom(b) >= 0)
+        b = this->idom(b);
+    return b == a;
+}
+
+void GlobalValueNumbering::run(SsaFunction * fn) {
+    removed_ = 0;
+    vn_.resize(fn->instrs_.size());
+    for (size_t v = 0; v < vn_.size(); ++v) {
+        vn_[v] = v;
+    }
+    table_.clear();
+    scope_.clear();
+
+    // preorder of the dominator tree; a frame is (block, next child, scope mark)
+    DominatorTree dom(*fn);
+    struct Frame {
+        int block;
+        size_t child;
+        size_t mark;
+    };
+    std::vector<Frame> stack;
+    stack.push_back(Frame{0, 0, 0});
+    this->number_block(fn, 0);
+    while (!stack.empty()) {
+        Frame & frame = stack.back();
+        const std::vector<int> & children = dom.children(frame.block);
+        if (frame.child < children.size()) {
+            int c = children[frame.child++];
+            size_t mark = scope_.size();
+            this->number_block(fn, c);
+            stack.push_back(Frame{c, 0, mark});
+            continue;
+        }
+        // leaving the subtree, its values no longer dominate
+        while (scope_.size() > frame.mark) {
+            table_.erase(scope_.back());
+            scope_.pop_back();
+        }
+        stack.pop_back();
+    }
+    this->rewrite(fn);
+}
+
+void GlobalValueNumbering::number_block(SsaFunction * fn, int b) {
+    const SsaBlock & block = fn->blocks_[b];
+    std::map<std::vector<int32_t>, int32_t> phis; // arguments -> phi
+    std::vector<int32_t> args;
+    for (int v = block.phis; v >= 0; v = fn->instrs_[v].next) {
+        const SsaInstr & phi = fn->instrs_[v];
+        args.clear();
+        int same = -1;
+        bool trivial = true;
+        for (int k = 0; k < phi.b; ++k) {
+            // arguments along back edges are not numbered yet, so stay apart
+            int32_t arg = vn_[fn->phi_arg(phi, k)];
+            args.push_back(arg);
+            if (arg == v)
+                continue;
+            if (same >= 0 && arg != same)
+                trivial = false;
+            same = arg;
+        }
+        if (trivial && same >= 0) {
+            vn_[v] = same;
+            continue;
+        }
+        auto found = phis.emplace(args, v);
+        if (!found.second)
+            vn_[v] = found.first->second;
+    }
+
+    for (int v = block.first; v >= 0; v = fn->instrs_[v].next) {
+        const SsaInstr & in = fn->instrs_[v];
+        Key key{in.op, in.a, 0};
+        if (in.op >= SSA_ADD && in.op <= SSA_EQ) {
+            key.a = vn_[in.a];
+            key.b = vn_[in.b];
+            bool commutative = in.op == SSA_ADD || in.op == SSA_MUL || in.op == SSA_EQ;
+            if (commutative && key.a > key.b)
+                std::swap(key.a, key.b);
+        } else if (in.op != SSA_CONST) {
+            continue;
+        }
+        auto found = table_.emplace(key, v);
+        if (found.second) {
+            scope_.push_back(key);
+        } else {
+            vn_[v] = found.first->second;
+        }
+    }
+}
+
+void GlobalValueNumbering::rewrite(SsaFunction * fn) {
+    for (SsaBlock & block : fn->blocks_) {
+        int32_t * link = &block.phis;
+        while (*link >= 0) {
+            SsaInstr & phi = fn->instrs_[*link];
+            if (vn_[*link] != *link) {
+                *link = phi.next;
+                ++removed_;
+                continue;
+            }
+            for (int k = 0; k < phi.b; ++k) {
+                fn->phi_args_[phi.a + k] = vn_[fn->phi_args_[phi.a + k]];
+            }
+            link = &phi.next;
+        }
+        int32_t last = -1;
+        link = &block.first;
+        while (*link >= 0) {
+            SsaInstr & in = fn->instrs_[*link];
+            if (vn_[*link] != *link) {
+                *link = in.next;
+                ++removed_;
+                continue;
+            }
+            if (in.op >= SSA_ADD && in.op <= SSA_EQ) {
+                in.a = vn_[in.a];
+                in.b = vn_[in.b];
+            } else if (in.op == SSA_WRITE || in.op == SSA_BRANCH) {
+                in.a = vn_[in.a];
+            }
+            last = *link;
+            link = &in.next;
+        }
+        block.last = last;
+    }
+    for (int32_t & v : fn->exit_values_) {
+        v = vn_[v];
+    }
+}
+
+} /* namespace tinylang */
@@ -0,0 +1,90 @@
+/*
+ * gvn.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef GVN_H
+#define GVN_H
+
+#include "ssa.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace tinylang {
+
+/**
+ * @brief Dominator tree of the blocks of an SSA function, with the
+ *  iterative algorithm of Cooper, Harvey and Kennedy, "A Simple, Fast
+ *  Dominance Algorithm". Unreachable blocks have no immediate dominator.
+ */
+class DominatorTree {
+public:
+    explicit DominatorTree(const SsaFunction & fn);
+
+    //! @brief The immediate dominator, -1 for the entry
+    int idom(int b) const { return idom_[b] == b ? -1 : idom_[b]; }
+
+    const std::vector<int> & children(int b) const { return children_[b]; }
+
+    bool dominates(int a, int b) const;
+
+private:
+    std::vector<int> idom_;
+    std::vector<std::vector<int>> children_;
+};
+
+/**
+ * @brief Dominator-based global value numbering over SSA form (Briggs,
+ *  Cooper and Simpson, "Value Numbering"). The blocks are visited in a
+ *  preorder of the dominator tree with a scoped hash table from
+ *  (operation, value numbers of the operands) to the first value computing
+ *  it, so a computation is only replaced by one that dominates it.
+ *  Constants are numbered by value, the operands of commutative operations
+ *  are ordered, and a phi is redundant if all its arguments are the same
+ *  value or another phi of the block merges the same ones. read and write
+ *  are never merged; a division is, since the first one failing stops the
+ *  program.
+ */
+class GlobalValueNumbering {
+public:
+    void run(SsaFunction * fn);
+
+    //! @brief Instructions removed by the last run
+    size_t removed() const { return removed_; }
+
+private:
+    struct Key {
+        uint32_t op;
+        int32_t a;
+        int32_t b;
+
+        bool operator==(const Key & other) const {
+            return op == other.op && a == other.a && b == other.b;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key & k) const {
+            uint64_t h = (static_cast<uint64_t>(k.op) << 32 | static_cast<uint32_t>(k.a)) *
+                         0x9e3779b97f4a7c15ull;
+            return h ^ (static_cast<uint32_t>(k.b) * 0xc2b2ae3d27d4eb4full) ^ (h >> 29);
+        }
+    };
+
+    void number_block(SsaFunction * fn, int b);
+    //! @brief Replace every use by its value number, drop the redundant
+    void rewrite(SsaFunction * fn);
+
+private:
+    std::vector<int32_t> vn_; // value -> the value it is replaced by
+    std::unordered_map<Key, int32_t, KeyHash> table_;
+    std::vector<Key> scope_; // keys in insertion order, popped per subtree
+    size_t removed_ = 0;
+};
+
+} /* namespace tinylang */
+
+#endif /* !GVN_H */
@@ -0,0 +1,314 @@
+/*
+ * incremental_analyser.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "incremental_analyser.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace tinylang {
+
+//! @brief Pre-order pass recording the symbol occurrences of a statement
+class StatementRecorder : public AstVisitor<StatementRecorder> {
+public:
+    using Statement = IncrementalAnalyser::Statement;
+
+    StatementRecorder(IncrementalAnalyser * owner, Statement * s)
+        : owner_(owner), s_(s) {}
+
+    int pre_visit(TreeNode * t) {
+        ++s_->log.event;
+        if (t->node_type == NodeStmt &&
+            (t->stmt == StmtAssign || t->stmt == StmtRead)) {
+            int id = owner_->name_id(t->attr.name);
+            owner_->defined_in_[id] = owner_->epoch_;
+            s_->occurrences.push_back({id, t->line_no, s_->log.event,
+                                       IncrementalAnalyser::OccurDef});
+        } else if (t->node_type == NodeExpr && t->expr == ExprIdentifier) {
+            int id = owner_->name_id(t->attr.name);
+            s_->occurrences.push_back({id, t->line_no, s_->log.event,
+                                       owner_->defined_in_[id] == owner_->epoch_
+                                           ? IncrementalAnalyser::OccurLocalUse
+                                           : IncrementalAnalyser::OccurExternalUse});
+        }
+        return 0;
+    }
+
+private:
+    IncrementalAnalyser * owner_;
+    Statement * s_;
+};
+
+IncrementalAnalyser::~IncrementalAnalyser() {
+    this->clear();
+}
+
+void IncrementalAnalyser::clear() {
+    for (Statement * s : stmts_) {
+        delete s;
+    }
+    stmts_.clear();
+    names_.clear();
+    name_ids_.clear();
+    defined_in_.clear();
+    failed_ = 0;
+}
+
+int IncrementalAnalyser::name_id(const char * name) {
+    auto it = name_ids_.find(name);
+    if (it != name_ids_.end()) {
+        return it->second;
+    }
+    int id = names_.size();
+    names_.emplace_back();
+    names_.back().name = name;
+    name_ids_.emplace(name, id);
+    defined_in_.push_back(0);
+    return id;
+}
+
+uint64_t IncrementalAnalyser::first_def(int name) const {
+    const Name & n = names_[name];
+    return n.defs.empty() ? UINT64_MAX : n.defs.begin()->first;
+}
+
+IncrementalAnalyser::Statement * IncrementalAnalyser::check(TreeNode * t) {
+    Statement * s = new Statement;
+    s->tree = t;
+    ++epoch_;
+    StatementRecorder recorder(this, s);
+    TypeChecker checker(nullptr, &s->log);
+    PassPipeline<StatementRecorder, TypeChecker> pipeline(recorder, checker);
+    pipeline.walk_node(t);
+    return s;
+}
+
+void IncrementalAnalyser::resolve(Statement * s) {
+    // merge the undeclared uses into the type errors, in traversal order
+    DiagnosticLog log;
+    auto msg = s->log.entries.begin();
+    for (const Occurrence & occ : s->occurrences) {
+        if (occ.kind != OccurExternalUse || this->declared(occ.name, s->order))
+            continue;
+        for (; msg != s->log.entries.end() && msg->first < occ.event; ++msg) {
+            log.entries.push_back(*msg);
+        }
+        report_undeclared(&log, occ.line_no, names_[occ.name].name.c_str());
+    }
+    log.entries.insert(log.entries.end(), msg, s->log.entries.end());
+
+    failed_ -= s->failed;
+    s->failed = !log.entries.empty();
+    failed_ += s->failed;
+    s->diagnostics.clear();
+    for (const auto & entry : log.entries) {
+        s->diagnostics.push_back(entry.second);
+    }
+    ++checked_;
+}
+
+void IncrementalAnalyser::link(Statement * s) {
+    for (const Occurrence & occ : s->occurrences) {
+        if (occ.kind == OccurDef) {
+            names_[occ.name].defs[s->order] = s;
+        } else if (occ.kind == OccurExternalUse) {
+            names_[occ.name].external_uses[s->order] = s;
+        }
+    }
+}
+
+void IncrementalAnalyser::unlink(Statement * s) {
+    for (const Occurrence & occ : s->occurrences) {
+        if (occ.kind == OccurDef) {
+            names_[occ.name].defs.erase(s->order);
+        } else if (occ.kind == OccurExternalUse) {
+            names_[occ.name].external_uses.erase(s->order);
+        }
+    }
+}
+
+void IncrementalAnalyser::renumber() {
+    for (Name & n : names_) {
+        n.defs.clear();
+        n.external_uses.clear();
+    }
+    for (size_t i = 0; i < stmts_.size(); ++i) {
+        stmts_[i]->order = (i + 1) * ORDER_GAP;
+        this->link(stmts_[i]);
+    }
+}
+
+int IncrementalAnalyser::analyse(TreeNode * tree) {
+    this->clear();
+    checked_ = 0;
+    for (TreeNode * t = tree; t != nullptr; t = t->neighbor) {
+        stmts_.push_back(this->check(t));
+    }
+    this->renumber();
+    for (Statement * s : stmts_) {
+        this->resolve(s);
+    }
+    return failed_ == 0 ? 0 : -1;
+}
+
+int IncrementalAnalyser::replace(size_t first, size_t count, TreeNode * stmts) {
+    checked_ = 0;
+    if (first > stmts_.size() || count > stmts_.size() - first) {
+        printf("error: statements [%zu, %zu) out of range, the program has %zu\n",
+               first, first + count, stmts_.size());
+        return -1;
+    }
+    std::vector<Statement *> added;
+    for (TreeNode * t = stmts; t != nullptr; t = t->neighbor) {
+        added.push_back(this->check(t));
+    }
+
+    // first definitions of the names whose definitions change
+    std::map<int, uint64_t> old_first;
+    auto touch_defs = [&](const Statement * s) {
+        for (const Occurrence & occ : s->occurrences) {
+            if (occ.kind == OccurDef && old_first.count(occ.name) == 0)
+                old_first[occ.name] = this->first_def(occ.name);
+        }
+    };
+    for (size_t i = first; i < first + count; ++i) {
+        touch_defs(stmts_[i]);
+    }
+    for (const Statement * s : added) {
+        touch_defs(s);
+    }
+
+    for (size_t i = first; i < first + count; ++i) {
+        this->unlink(stmts_[i]);
+        failed_ -= stmts_[i]->failed;
+        delete stmts_[i];
+    }
+    stmts_.erase(stmts_.begin() + first, stmts_.begin() + first + count);
+    stmts_.insert(stmts_.begin() + first, added.begin(), added.end());
+
+    // relink the top-level list around the new statements
+    size_t end = first + added.size();
+    TreeNode * next = end < stmts_.size() ? stmts_[end]->tree : nullptr;
+    if (!added.empty()) {
+        added.back()->tree->neighbor = next;
+    }
+    if (first > 0) {
+        stmts_[first - 1]->tree->neighbor =
+            added.empty() ? next : added.front()->tree;
+    }
+
+    // number the new statements between their neighbours if there is room
+    uint64_t lo = first > 0 ? stmts_[first - 1]->order : 0;
+    uint64_t hi = end < stmts_.size() ? stmts_[end]->order
+                                      : lo + (added.size() + 1) * ORDER_GAP;
+    uint64_t step = (hi - lo) / (added.size() + 1);
+    if (step == 0) {
+        this->renumber();
+    } else {
+        for (size_t i = 0; i < added.size(); ++i) {
+            added[i]->order = lo + (i + 1) * step;
+            this->link(added[i]);
+        }
+    }
+
+    // a use changes iff its statement lies between the old and the new
+    // first definition of its name
+    ++epoch_;
+    std::vector<Statement *> dirty(added);
+    for (Statement * s : added) {
+        s->mark = epoch_;
+    }
+    for (const auto & entry : old_first) {
+        uint64_t now = this->first_def(entry.first);
+        if (now == entry.second)
+            continue;
+        const auto & uses = names_[entry.first].external_uses;
+        auto it = uses.upper_bound(std::min(now, entry.second));
+        auto last = uses.upper_bound(std::max(now, entry.second));
+        for (; it != last; ++it) {
+            if (it->second->mark != epoch_) {
+                it->second->mark = epoch_;
+                dirty.push_back(it->second);
+            }
+        }
+    }
+    for (Statement * s : dirty) {
+        this->resolve(s);
+    }
+    return failed_ == 0 ? 0 : -1;
+}
+
+TreeNode * IncrementalAnalyser::tree() const {
+    return stmts_.empty() ? nullptr : stmts_.front()->tree;
+}
+
+std::vector<int> IncrementalAnalyser::lines(const char * name) const {
+    std::vector<int> result;
+    auto found = name_ids_.find(name);
+    if (found == name_ids_.end()) {
+        return result;
+    }
+    int id = found->second;
+    const Name & n = names_[id];
+    auto collect = [&](const Statement * s) {
+        for (const Occurrence & occ : s->occurrences) {
+            if (occ.name == id && (occ.kind != OccurExternalUse ||
+                                   this->declared(id, s->order)))
+                result.push_back(occ.line_no);
+        }
+    };
+    // the statements mentioning the name, merged in program order
+    auto d = n.defs.begin();
+    auto u = n.external_uses.begin();
+    while (d != n.defs.end() || u != n.external_uses.end()) {
+        if (u == n.external_uses.end() ||
+            (d != n.defs.end() && d->first <= u->first)) {
+            if (u != n.external_uses.end() && u->first == d->first)
+                ++u;
+            collect((d++)->second);
+        } else {
+            collect((u++)->second);
+        }
+    }
+    return result;
+}
+
+SymTable IncrementalAnalyser::symtable() const {
+    // symbols are numbered in the order of their first definitions
+    std::vector<std::pair<std::pair<uint64_t, size_t>, int>> firsts;
+    for (int id = 0; id < static_cast<int>(names_.size()); ++id) {
+        if (names_[id].defs.empty())
+            continue;
+        const Statement * s = names_[id].defs.begin()->second;
+        for (const Occurrence & occ : s->occurrences) {
+            if (occ.name == id && occ.kind == OccurDef) {
+                firsts.push_back({{s->order, occ.event}, id});
+                break;
+            }
+        }
+    }
+    std::sort(firsts.begin(), firsts.end());
+    SymTable st;
+    for (const auto & entry : firsts) {
+        const std::string & name = names_[entry.second].name;
+        std::vector<int> lines = this->lines(name.c_str());
+        int id = st.insert(name, lines[0]);
+        for (size_t i = 1; i < lines.size(); ++i) {
+            st.insert_line(id, lines[i]);
+        }
+    }
+    return st;
+}
+
+std::vector<std::string> IncrementalAnalyser::diagnostics() const {
+    std::vector<std::string> result;
+    for (const Statement * s : stmts_) {
+        result.insert(result.end(), s->diagnostics.begin(), s->diagnostics.end());
+    }
+    return result;
+}
+
+} /* namespace tinylang */
@@ -0,0 +1,134 @@
+/*
+ * incremental_analyser.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef INCREMENTAL_ANALYSER_H
+#define INCREMENTAL_ANALYSER_H
+
+#include "analyser.h"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tinylang {
+
+/**
+ * @brief Semantic analysis that follows edits of the top-level statements.
+ *  For every top-level statement the analyser records the symbols it
+ *  defines and the symbols it uses before defining them itself. Type errors
+ *  only depend on the statement, and a use is declared iff the first
+ *  definition of its name comes earlier, so an edit re-checks the new
+ *  statements and only those statements whose uses straddle a moved first
+ *  definition. The results equal those of Analyser on the edited tree.
+ */
+class IncrementalAnalyser {
+public:
+    IncrementalAnalyser() = default;
+
+    ~IncrementalAnalyser();
+
+    IncrementalAnalyser(const IncrementalAnalyser &) = delete;
+    IncrementalAnalyser & operator=(const IncrementalAnalyser &) = delete;
+
+    /**
+     * @brief Analyse a whole program, forgetting any previous one.
+     *
+     * @return 0 for no error.
+     */
+    int analyse(TreeNode * tree);
+
+    /**
+     * @brief Replace the top-level statements [first, first + count) with
+     *  the statement list stmts, which may be empty, and re-check what the
+     *  edit affects. The neighbor links of the tree are updated. A range
+     *  past the last statement is rejected and changes nothing.
+     *
+     * @return 0 if the edited program has no error, -1 for an error or an
+     *  out-of-range edit.
+     */
+    int replace(size_t first, size_t count, TreeNode * stmts);
+
+    //! @brief First statement of the edited program
+    TreeNode * tree() const;
+
+    //! @brief Number of top-level statements
+    size_t size() const { return stmts_.size(); }
+
+    //! @brief Number of statements checked by the last analyse() or replace()
+    size_t last_checked() const { return checked_; }
+
+    //! @brief Lines at which the name occurs, as in the symbol table
+    std::vector<int> lines(const char * name) const;
+
+    //! @brief The symbol table Analyser would build for the program
+    SymTable symtable() const;
+
+    //! @brief The messages Analyser would print for the program
+    std::vector<std::string> diagnostics() const;
+
+private:
+    enum OccurrenceKind {
+        OccurDef,          // assigned or read
+        OccurLocalUse,     // used after a definition in the same statement
+        OccurExternalUse,  // used before any definition in the statement
+    };
+
+    struct Occurrence {
+        int name;
+        int line_no;
+        size_t event; // event of the DiagnosticLog of the statement
+        OccurrenceKind kind;
+    };
+
+    struct Statement {
+        TreeNode * tree;
+        uint64_t order; // increasing in program order, with gaps
+        DiagnosticLog log; // type errors
+        std::vector<Occurrence> occurrences;
+        std::vector<std::string> diagnostics;
+        bool failed = false;
+        size_t mark = 0;
+    };
+
+    struct Name {
+        std::string name;
+        std::map<uint64_t, Statement *> defs;
+        std::map<uint64_t, Statement *> external_uses;
+    };
+
+    friend class StatementRecorder;
+
+    Statement * check(TreeNode * t);
+    void resolve(Statement * s);
+    void link(Statement * s);
+    void unlink(Statement * s);
+    void renumber();
+    void clear();
+
+    int name_id(const char * name);
+    uint64_t first_def(int name) const;
+
+    bool declared(int name, uint64_t order) const {
+        return this->first_def(name) < order;
+    }
+
+private:
+    static const uint64_t ORDER_GAP = uint64_t(1) << 20;
+
+    std::vector<Statement *> stmts_;
+    std::vector<Name> names_;
+    std::unordered_map<std::string, int> name_ids_;
+    std::vector<size_t> defined_in_; // per name, epoch of the last defining statement
+    size_t epoch_ = 0;
+    size_t failed_ = 0;  // statements with errors
+    size_t checked_ = 0;
+};
+
+} /* namespace tinylang */
+
+#endif /* !INCREMENTAL_ANALYSER_H */
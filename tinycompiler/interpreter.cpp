@@ -0,0 +1,117 @@
+/*
+ * interpreter.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "interpreter.h"
+#include <cstdarg>
+
+namespace tinylang {
+
+void runtime_error(const char * fmt, ...) {
+    fflush(stdout);
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+}
+
+void report_division_by_zero(int line_no) {
+    runtime_error("file:%d: runtime error: division by zero\n", line_no);
+}
+
+int Interpreter::run(TreeNode * tree, size_t slots) {
+    vars_.assign(slots, 0);
+    steps_ = 0;
+    failed_ = false;
+    int ret = this->exec(tree);
+    fflush(out_);
+    return ret;
+}
+
+int Interpreter::exec(TreeNode * t) {
+    for (; t != nullptr; t = t->neighbor) {
+        ++steps_;
+        switch (t->stmt) {
+            case StmtIf: {
+                // nothing runs after the condition fails
+                int cond = this->eval(t->children[0]);
+                if (failed_)
+                    return -1;
+                if (this->exec(t->children[cond ? 1 : 2]) != 0)
+                    return -1;
+                break;
+            }
+            case StmtRepeat: {
+                int until = 0;
+                do {
+                    if (this->exec(t->children[0]) != 0)
+                        return -1;
+                    until = this->eval(t->children[1]);
+                    if (failed_)
+                        return -1;
+                } while (!until);
+                break;
+            }
+            case StmtAssign: {
+                int v = this->eval(t->children[0]);
+                if (!failed_)
+                    vars_[t->slot] = v;
+                break;
+            }
+            case StmtRead: {
+                int v = 0;
+                if (fscanf(in_, "%d", &v) != 1)
+                    v = 0;
+                vars_[t->slot] = v;
+                break;
+            }
+            case StmtWrite: {
+                int v = this->eval(t->children[0]);
+                if (!failed_)
+                    fprintf(out_, "%d\n", v);
+                break;
+            }
+        }
+        if (failed_)
+            return -1;
+    }
+    return 0;
+}
+
+int Interpreter::eval(TreeNode * e) {
+    ++steps_;
+    if (e->expr == ExprConst)
+        return e->attr.val;
+    if (e->expr == ExprIdentifier)
+        return vars_[e->slot];
+    // wrap around through unsigned arithmetic
+    unsigned a = this->eval(e->children[0]);
+    unsigned b = this->eval(e->children[1]);
+    switch (e->attr.op) {
+        case TokenType::PLUS:
+            return a + b;
+        case TokenType::MINUS:
+            return a - b;
+        case TokenType::TIMES:
+            return a * b;
+        case TokenType::OVER:
+            if (b == 0) {
+                if (!failed_)
+                    report_division_by_zero(e->line_no);
+                failed_ = true;
+                return 0;
+            }
+            return tiny_divide(a, b);
+        case TokenType::LT:
+            return static_cast<int>(a) < static_cast<int>(b);
+        case TokenType::EQ:
+            return a == b;
+        default:
+            return 0;
+    }
+}
+
+} /* namespace tinylang */
@@ -0,0 +1,71 @@
+/*
+ * interpreter.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+
+#include "parser.h"
+#include <cstdio>
+#include <vector>
+
+namespace tinylang {
+
+/**
+ * @brief Tree-walking interpreter, the reference execution engine.
+ *  It runs a syntax tree after Analyser::analyse() succeeded on it: every
+ *  variable is an index into a dense array, taken from the slot the
+ *  analyser gave its node, so no name is looked up at run time.
+ *
+ *  Arithmetic wraps in 32 bits and INT_MIN / -1 is INT_MIN. Variables start
+ *  at 0. read takes an integer from the input, 0 at its end; write prints
+ *  the value and a newline.
+ */
+class Interpreter {
+public:
+    Interpreter(FILE * in = stdin, FILE * out = stdout) : in_(in), out_(out) {}
+
+    /**
+     * @param slots Number of variables, the size of the analyser symtable
+     * @return 0 for success, -1 after a run-time error
+     */
+    int run(TreeNode * tree, size_t slots);
+
+    //! @brief Values of the variables after the last run, indexed by slot
+    const std::vector<int> & variables() const { return vars_; }
+
+    //! @brief Tree nodes executed by the last run
+    size_t steps() const { return steps_; }
+
+private:
+    int exec(TreeNode * t);
+    int eval(TreeNode * e);
+
+private:
+    FILE * in_;
+    FILE * out_;
+    std::vector<int> vars_;
+    size_t steps_ = 0;
+    bool failed_ = false; // set by eval() on a run-time error
+};
+
+//! @brief Integer division of TINY: truncating, INT_MIN / -1 wraps to INT_MIN
+inline int tiny_divide(int a, int b) {
+    return b == -1 ? static_cast<int>(0u - static_cast<unsigned>(a)) : a / b;
+}
+
+/**
+ * @brief Print a run-time error of the program on stderr, the sink of
+ *  every engine. What the program wrote to stdout so far comes first.
+ */
+void runtime_error(const char * fmt, ...);
+
+//! @brief Report a division by zero at the line, the same on every engine
+void report_division_by_zero(int line_no);
+
+} /* namespace tinylang */
+
+#endif /* !INTERPRETER_H */
@@ -0,0 +1,111 @@
+/*
+ * jit.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "jit.h"
+#include "interpreter.h"
+#include <cstring>
+#include <utility>
+
+#ifdef TINY_JIT_SUPPORTED
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace tinylang {
+
+namespace {
+
+struct JitRuntime {
+    FILE * in;
+    FILE * out;
+};
+
+int jit_read(JitRuntime * rt) {
+    int v = 0;
+    if (fscanf(rt->in, "%d", &v) != 1)
+        v = 0;
+    return v;
+}
+
+void jit_write(JitRuntime * rt, int v) {
+    fprintf(rt->out, "%d\n", v);
+}
+
+void jit_div_zero(JitRuntime *, int line_no) {
+    report_division_by_zero(line_no);
+}
+
+} /* namespace */
+
+JitProgram::JitProgram(const std::vector<uint8_t> & code, size_t slots)
+    : slots_(slots) {
+#ifdef TINY_JIT_SUPPORTED
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t mapped = (code.size() + page - 1) / page * page;
+    void * pages = mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pages == MAP_FAILED)
+        return;
+    memcpy(pages, code.data(), code.size());
+    if (mprotect(pages, mapped, PROT_READ | PROT_EXEC) != 0) {
+        munmap(pages, mapped);
+        return;
+    }
+    pages_ = pages;
+    mapped_ = mapped;
+    code_size_ = code.size();
+    entry_ = pages;
+#endif
+}
+
+JitProgram::JitProgram(JitProgram && other) {
+    *this = std::move(other);
+}
+
+JitProgram & JitProgram::operator=(JitProgram && other) {
+    std::swap(pages_, other.pages_);
+    std::swap(mapped_, other.mapped_);
+    std::swap(code_size_, other.code_size_);
+    std::swap(entry_, other.entry_);
+    std::swap(slots_, other.slots_);
+    vars_.swap(other.vars_);
+    return *this;
+}
+
+JitProgram::~JitProgram() {
+#ifdef TINY_JIT_SUPPORTED
+    if (pages_ != nullptr)
+        munmap(pages_, mapped_);
+#endif
+}
+
+int JitProgram::run(FILE * in, FILE * out) {
+    if (!this->valid())
+        return -1;
+    vars_.assign(slots_, 0);
+    JitRuntime rt = {in, out};
+    auto entry = reinterpret_cast<int (*)(JitRuntime *, int *)>(entry_);
+    int ret = entry(&rt, vars_.data());
+    fflush(out);
+    return ret;
+}
+
+JitProgram JitCompiler::compile(TreeNode * tree, size_t slots) {
+#ifndef TINY_JIT_SUPPORTED
+    return JitProgram();
+#else
+    X64Assembler as;
+    X64CodeGenerator codegen(&as);
+    codegen.set_target(CallRead, reinterpret_cast<const void *>(&jit_read));
+    codegen.set_target(CallWrite, reinterpret_cast<const void *>(&jit_write));
+    codegen.set_target(CallDivZero, reinterpret_cast<const void *>(&jit_div_zero));
+    codegen.generate(tree);
+    return JitProgram(as.code(), slots);
+#endif
+}
+
+} /* namespace tinylang */
@@ -0,0 +1,75 @@
+/*
+ * jit.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef JIT_H
+#define JIT_H
+
+#include "parser.h"
+#include "x64_codegen.h"
+#include <cstdio>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define TINY_JIT_SUPPORTED
+#endif
+
+namespace tinylang {
+
+/**
+ * @brief Native code of a program in executable memory.
+ *  The pages are written while only writable, then switched to only
+ *  executable, so they are never both. Move-only; the pages are unmapped
+ *  on destruction.
+ */
+class JitProgram {
+public:
+    JitProgram() = default;
+    JitProgram(JitProgram && other);
+    JitProgram & operator=(JitProgram && other);
+    ~JitProgram();
+
+    //! @brief false if the code could not be mapped
+    bool valid() const { return entry_ != nullptr; }
+
+    //! @return 0 for success, -1 after a run-time error
+    int run(FILE * in = stdin, FILE * out = stdout);
+
+    //! @brief Values of the variables after the last run, indexed by slot
+    const std::vector<int> & variables() const { return vars_; }
+
+    //! @brief Bytes of machine code
+    size_t size() const { return code_size_; }
+
+private:
+    friend class JitCompiler;
+
+    //! @brief Map the code; leaves the program invalid on failure
+    JitProgram(const std::vector<uint8_t> & code, size_t slots);
+
+private:
+    void * pages_ = nullptr;
+    size_t mapped_ = 0;
+    size_t code_size_ = 0;
+    void * entry_ = nullptr;
+    size_t slots_ = 0;
+    std::vector<int> vars_;
+};
+
+/**
+ * @brief Compile an analysed syntax tree to x86-64 machine code in memory,
+ *  with read and write calling back into the runtime. Only available on
+ *  Linux x86-64 (TINY_JIT_SUPPORTED).
+ */
+class JitCompiler {
+public:
+    //! @brief The program is invalid if the platform is not supported
+    JitProgram compile(TreeNode * tree, size_t slots);
+};
+
+} /* namespace tinylang */
+
+#endif /* !JIT_H */
@@ -0,0 +1,179 @@
+/*
+ * ll1parser.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "ll1parser.h"
+#include "ll1_table.h"
+#include <cstdio>
+
+namespace tinylang {
+
+LL1Parser::LL1Parser() {
+    scanner_ = new Scanner();
+}
+
+void LL1Parser::reset() {
+    node_pool_.reset();
+    string_arena_.reset();
+}
+
+LL1Parser::~LL1Parser() {
+    if (scanner_) {
+        delete scanner_;
+        scanner_ = nullptr;
+    }
+}
+
+TreeNode *LL1Parser::make_stmt_node(StmtProp stmt_prop) {
+    TreeNode *node = node_pool_.allocate();
+    node->node_type = NodeStmt;
+    node->stmt = stmt_prop;
+    node->line_no = tokens_.peek().line_no;
+    node->offset = tokens_.peek().text - input_;
+    return node;
+}
+
+TreeNode *LL1Parser::make_expr_node(ExprProp expr_prop) {
+    TreeNode *node = node_pool_.allocate();
+    node->node_type = NodeExpr;
+    node->expr = expr_prop;
+    node->line_no = tokens_.peek().line_no;
+    node->offset = tokens_.peek().text - input_;
+    return node;
+}
+
+void LL1Parser::syntax_error(const char *msg) {
+    ++error_count_;
+    const Token &token = tokens_.peek();
+    printf("Unexpected token: %.*s at line %lu. %s\n",
+           static_cast<int>(token.len), token.text, token.line_no, msg);
+}
+
+void LL1Parser::run_action(int action) {
+    TreeNode *node = nullptr;
+    const Token &token = tokens_.peek();
+    switch (action) {
+        case ll1::ACT_seq_begin:
+            seqs_.emplace_back(nullptr, nullptr);
+            break;
+        case ll1::ACT_seq_add:
+            node = values_.back();
+            values_.pop_back();
+            if (seqs_.back().first == nullptr) {
+                seqs_.back().first = node;
+            } else {
+                seqs_.back().second->neighbor = node;
+            }
+            seqs_.back().second = node;
+            break;
+        case ll1::ACT_seq_end:
+            values_.push_back(seqs_.back().first);
+            seqs_.pop_back();
+            break;
+        case ll1::ACT_if:
+            values_.push_back(make_stmt_node(StmtIf));
+            break;
+        case ll1::ACT_repeat:
+            values_.push_back(make_stmt_node(StmtRepeat));
+            break;
+        case ll1::ACT_assign:
+            values_.push_back(make_stmt_node(StmtAssign));
+            break;
+        case ll1::ACT_read:
+            values_.push_back(make_stmt_node(StmtRead));
+            break;
+        case ll1::ACT_write:
+            values_.push_back(make_stmt_node(StmtWrite));
+            break;
+        case ll1::ACT_name:
+            if (token.type == TokenType::ID) {
+                values_.back()->attr.name =
+                    string_arena_.copy(token.text, token.len);
+                values_.back()->offset = token.text - input_;
+            }
+            break;
+        case ll1::ACT_child0:
+        case ll1::ACT_child1:
+        case ll1::ACT_child2:
+            node = values_.back();
+            values_.pop_back();
+            values_.back()->children[action - ll1::ACT_child0] = node;
+            break;
+        case ll1::ACT_op:
+            node = make_expr_node(ExprOp);
+            node->attr.op = token.type;
+            values_.push_back(node);
+            break;
+        case ll1::ACT_binary: {
+            TreeNode *rhs = values_.back();
+            values_.pop_back();
+            node = values_.back();
+            values_.pop_back();
+            node->children[0] = values_.back();
+            node->children[1] = rhs;
+            values_.back() = node;
+            break;
+        }
+        case ll1::ACT_num:
+            node = make_expr_node(ExprConst);
+            node->attr.val = tokenToInt(token);
+            values_.push_back(node);
+            break;
+        case ll1::ACT_id:
+            node = make_expr_node(ExprIdentifier);
+            node->attr.name = string_arena_.copy(token.text, token.len);
+            values_.push_back(node);
+            break;
+        default:
+            break;
+    }
+}
+
+SyntaxTree LL1Parser::parse(const char *input_data, size_t input_len) {
+    error_count_ = 0;
+    input_ = input_data;
+    scanner_->setInput(input_data, input_len);
+    tokens_.reset(scanner_);
+    stack_.clear();
+    values_.clear();
+    seqs_.clear();
+    stack_.push_back(ll1::START_SYMBOL);
+    while (!stack_.empty()) {
+        int sym = stack_.back();
+        stack_.pop_back();
+        if (sym < ll1::NT_BASE) {
+            if (sym != static_cast<int>(this->token())) {
+                this->syntax_error(("Expect: " +
+                    getTokenTypeName(static_cast<TokenType>(sym))).c_str());
+                break;
+            }
+            tokens_.advance();
+        } else if (sym < ll1::ACT_BASE) {
+            int nt = sym - ll1::NT_BASE;
+            int prod = ll1::parse_table[nt][static_cast<int>(this->token())];
+            if (prod < 0) {
+                this->syntax_error((std::string("Expect: ") +
+                    ll1::nonterminal_names[nt]).c_str());
+                break;
+            }
+            stack_.insert(stack_.end(),
+                          ll1::rhs_symbols + ll1::rhs_offset[prod],
+                          ll1::rhs_symbols + ll1::rhs_offset[prod + 1]);
+        } else {
+            this->run_action(sym - ll1::ACT_BASE);
+        }
+    }
+    if (error_count_ == 0 && this->token() != TokenType::ENDFILE) {
+        this->syntax_error("Expect: end of file");
+    }
+    if (error_count_ != 0) {
+        // partially built nodes are recycled by reset()
+        return nullptr;
+    }
+    return values_.back();
+}
+
+} /* namespace tinylang */
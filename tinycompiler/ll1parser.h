@@ -0,0 +1,68 @@
+/*
+ * ll1parser.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef LL1PARSER_H
+#define LL1PARSER_H
+
+#include "parser.h"
+#include <utility>
+#include <vector>
+
+namespace tinylang {
+
+/**
+ * @brief Table-driven LL(1) parser.
+ *  The parsing table is generated from tiny.grammar at build time by
+ *  tools/ll1gen. The engine keeps an explicit stack of grammar symbols and
+ *  semantic actions, so it builds the same TreeNode output as Parser without
+ *  any recursion. Grammar extensions only need new rules and actions.
+ */
+class LL1Parser {
+public:
+    LL1Parser();
+
+    /** @brief Parse and return the syntax tree if success.
+     *  Parsing stops at the first syntax error and nullptr is returned.
+     *  The tree stays valid until the next reset().
+     */
+    SyntaxTree parse(const char *input_data, size_t input_len);
+
+    /** @brief Recycle the memory of every tree returned so far. */
+    void reset();
+
+    /** @brief Number of syntax errors reported by the last parse. */
+    int error_count() const { return error_count_; }
+
+    ~LL1Parser();
+private:
+    //! @brief Type of the current lookahead token
+    TokenType token() { return tokens_.peek().type; }
+
+    void syntax_error(const char *msg);
+
+    TreeNode *make_stmt_node(StmtProp stmt_prop);
+    TreeNode *make_expr_node(ExprProp expr_prop);
+
+    //! @brief Execute a semantic action on the value stack
+    void run_action(int action);
+
+private:
+    Scanner *scanner_ = nullptr;
+    const char *input_ = nullptr;
+    TokenBuffer tokens_; // lookahead tokens
+    int error_count_ = 0;
+    std::vector<short> stack_;      // grammar symbols and actions
+    std::vector<TreeNode *> values_; // nodes built so far
+    // (head, tail) of the statement sequences being built
+    std::vector<std::pair<TreeNode *, TreeNode *>> seqs_;
+    NodePool node_pool_;
+    StringArena string_arena_;
+};
+
+} /* namespace tinylang */
+
+#endif /* !LL1PARSER_H */
@@ -5,10 +5,49 @@
  * Distributed under terms of the MIT license.
  */
 
+#include "analyser.h"
+#include "c_backend.h"
+#include "constant_folding.h"
+#include "definite_assignment.h"
+#include "elf_writer.h"
+#include "gvn.h"
+#include "interpreter.h"
+#include "jit.h"
 #include "parser.h"
+#include "range_analysis.h"
+#include "register_vm.h"
+#include "ssa_interpreter.h"
+#include "stack_vm.h"
+#include "tm_codegen.h"
+#include "tm_simulator.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <thread>
+
+void print_usage(const char * prog) {
+    std::cerr << "usage: " << prog << " [options] file\n"
+        "  --syntax-only  only check the syntax\n"
+        "  --symtab       print the symbol table\n"
+        "  --check-assigned\n"
+        "                 reject uses that may read a variable before any\n"
+        "                 assignment on some path\n"
+        "  -j N           analyse with N threads, 0 for one per core; large\n"
+        "                 programs are split into chunks of statements\n"
+        "  --no-fold      do not fold constant expressions\n"
+        "  --fold-stats   print the number of folded nodes\n"
+        "  --emit-c       print the program as C\n"
+        "  --emit-tm      print the program as TM code\n"
+        "  --emit-ssa     print the SSA form\n"
+        "  --no-gvn       do not number values of the SSA form\n"
+        "  -o FILE        write a static x86-64 Linux executable\n"
+        "  --run-tm       the file is TM code, run it on the simulator\n"
+        "  --jit          run compiled to native code\n"
+        "  --vm=ENGINE    run on ast, stack, reg (default), tm or ssa\n";
+}
 
 int load_file(const char * filepath, std::string & dst) {
     std::ifstream ifs(filepath);
@@ -23,18 +62,194 @@ int load_file(const char * filepath, std::string & dst) {
 }
 
 int main(int argc, char * argv[]) {
-    if (argc < 2) {
+    const char * input_file = nullptr;
+    tinylang::ParseMode parse_mode = tinylang::ParseFull;
+    bool print_symtab = false;
+    bool check_assigned = false;
+    bool emit_c = false;
+    bool emit_tm = false;
+    bool emit_ssa = false;
+    bool run_tm = false; // the input is TM code
+    const char * output_file = nullptr; // executable to write
+    bool fold = true;
+    bool fold_stats = false;
+    bool gvn = true; // on the SSA form
+    std::string engine = "reg"; // the fastest in the interp benchmark
+    unsigned threads = 1; // of the analyser
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--syntax-only") {
+            parse_mode = tinylang::ParseSyntaxOnly;
+        } else if (arg == "--symtab") {
+            print_symtab = true;
+        } else if (arg == "--check-assigned") {
+            check_assigned = true;
+        } else if (arg == "--emit-c") {
+            emit_c = true;
+        } else if (arg == "--emit-ssa") {
+            emit_ssa = true;
+        } else if (arg == "--emit-tm") {
+            emit_tm = true;
+        } else if (arg == "--run-tm") {
+            run_tm = true;
+        } else if (arg == "--no-fold") {
+            fold = false;
+        } else if (arg == "--no-gvn") {
+            gvn = false;
+        } else if (arg == "--fold-stats") {
+            fold_stats = true;
+        } else if (arg == "-j") {
+            char * end = nullptr;
+            long n = i + 1 < argc ? strtol(argv[i + 1], &end, 10) : -1;
+            if (n < 0 || end == argv[i + 1] || *end != '\0') {
+                std::cerr << "error: expect a number of threads after -j" << std::endl;
+                return -1;
+            }
+            ++i;
+            threads = n == 0 ? std::max(1u, std::thread::hardware_concurrency())
+                             : static_cast<unsigned>(n);
+        } else if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (arg == "-o") {
+            if (i + 1 == argc) {
+                std::cerr << "error: missing file name after -o" << std::endl;
+                return -1;
+            }
+            output_file = argv[++i];
+        } else if (arg == "--jit") {
+            engine = "jit";
+        } else if (arg.compare(0, 5, "--vm=") == 0) {
+            engine = arg.substr(5);
+            if (engine != "ast" && engine != "stack" && engine != "reg" &&
+                engine != "tm" && engine != "ssa") {
+                std::cerr << "error: unknown engine " << engine << std::endl;
+                return -1;
+            }
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            std::cerr << "error: unknown option " << arg << std::endl;
+            print_usage(argv[0]);
+            return -1;
+        } else {
+            input_file = argv[i];
+        }
+    }
+    if (input_file == nullptr) {
         std::cerr << "error: no input files" << std::endl;
+        print_usage(argv[0]);
         return -1;
     }
+    if (run_tm) {
+        FILE * fp = fopen(input_file, "r");
+        if (fp == nullptr) {
+            std::cerr << "error: cannot open file " << input_file << std::endl;
+            return -1;
+        }
+        tinylang::TmSimulator sim;
+        int ret = sim.load(fp);
+        fclose(fp);
+        return ret == 0 ? sim.run() : -1;
+    }
     std::string source_lines;
-    if (load_file(argv[1], source_lines) != 0) {
+    if (load_file(input_file, source_lines) != 0) {
         return -1;
     }
-    tinylang::Parser parser = tinylang::Parser();
+    tinylang::Parser parser(parse_mode);
     tinylang::TreeNode * ast =
         parser.parse(source_lines.c_str(), source_lines.size());
-    return 0;
+    if (parser.error_count() != 0) {
+        return -1;
+    }
+    if (parse_mode == tinylang::ParseSyntaxOnly) {
+        return 0;
+    }
+    tinylang::Analyser analyser;
+    analyser.set_threads(threads);
+    if (analyser.analyse(ast) != 0) {
+        return -1;
+    }
+    if (print_symtab) {
+        analyser.symtable().print();
+    }
+    if (check_assigned) {
+        tinylang::DefiniteAssignment checker;
+        if (checker.check(ast) != 0) {
+            return -1;
+        }
+    }
+    // flags the checks the folder and the code generators may leave out
+    tinylang::RangeAnalysis ranges;
+    ranges.run(ast);
+    if (fold) {
+        tinylang::ConstantFolder folder;
+        ast = folder.run(ast);
+        if (fold_stats) {
+            std::cerr << "constant folding: " << folder.removed() << " nodes removed"
+                      << std::endl;
+        }
+    }
+    if (emit_c) {
+        tinylang::CEmitter emitter;
+        emitter.emit(ast, analyser.symtable());
+        return 0;
+    }
+    size_t slots = analyser.symtable().size();
+    if (output_file != nullptr) {
+        tinylang::ElfWriter writer;
+        writer.build(ast, slots);
+        return writer.write(output_file);
+    }
+    if (emit_ssa || engine == "ssa") {
+        tinylang::SsaBuilder builder;
+        tinylang::SsaFunction fn = builder.build(ast, slots);
+        if (gvn) {
+            tinylang::GlobalValueNumbering numbering;
+            numbering.run(&fn);
+        }
+        if (emit_ssa) {
+            fn.print();
+            return 0;
+        }
+        tinylang::SsaInterpreter interpreter;
+        return interpreter.run(fn);
+    }
+    if (emit_tm) {
+        tinylang::TmCodeGenerator codegen;
+        codegen.generate(ast, slots);
+        return 0;
+    }
+    if (engine == "ast") {
+        tinylang::Interpreter interpreter;
+        return interpreter.run(ast, slots);
+    }
+    if (engine == "jit") {
+        tinylang::JitCompiler compiler;
+        tinylang::JitProgram program = compiler.compile(ast, slots);
+        if (!program.valid()) {
+            std::cerr << "error: cannot compile to native code on this platform"
+                      << std::endl;
+            return -1;
+        }
+        return program.run();
+    }
+    if (engine == "tm") {
+        FILE * code = tmpfile();
+        tinylang::TmCodeGenerator codegen(code);
+        codegen.generate(ast, slots);
+        rewind(code);
+        tinylang::TmSimulator sim;
+        int ret = sim.load(code);
+        fclose(code);
+        return ret == 0 ? sim.run(std::max<size_t>(1024, codegen.data_size())) : -1;
+    }
+    if (engine == "reg") {
+        tinylang::RegisterCompiler compiler;
+        tinylang::RegisterVM vm;
+        return vm.run(compiler.compile(ast, slots));
+    }
+    tinylang::BytecodeCompiler compiler;
+    tinylang::StackVM vm;
+    return vm.run(compiler.compile(ast, slots));
 }
 
 
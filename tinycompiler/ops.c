@@ -0,0 +1 @@
+Unexpected token: - at line 9. Expect: ;
@@ -7,36 +7,57 @@
 
 #include "parser.h"
 #include <cstdio>
-#include <cstdlib>
 
 namespace tinylang {
 
 TreeNode *Parser::make_stmt_node(StmtProp stmt_prop) {
-    TreeNode *node = new TreeNode();
+    if (mode_ == ParseSyntaxOnly) {
+        return &sink_node_;
+    }
+    TreeNode *node = node_pool_.allocate();
     node->node_type = NodeStmt;
     node->stmt = stmt_prop;
-    node->line_no = this->scanner_->current_line_no();
+    node->line_no = tokens_.peek().line_no;
+    node->offset = this->token_offset();
     return node;
 }
 
 TreeNode *Parser::make_expr_node(ExprProp expr_prop) {
-    TreeNode *node = new TreeNode();
+    if (mode_ == ParseSyntaxOnly) {
+        return &sink_node_;
+    }
+    TreeNode *node = node_pool_.allocate();
     node->node_type = NodeExpr;
     node->expr = expr_prop;
-    node->line_no = this->scanner_->current_line_no();
+    node->line_no = tokens_.peek().line_no;
+    node->offset = this->token_offset();
+    return node;
+}
+
+TreeNode *Parser::make_error_node() {
+    if (mode_ == ParseSyntaxOnly) {
+        return &sink_node_;
+    }
+    TreeNode *node = node_pool_.allocate();
+    node->node_type = NodeError;
+    node->line_no = tokens_.peek().line_no;
+    node->offset = this->token_offset();
     return node;
 }
 
-static char *copy_str(const std::string &src) {
-    size_t n = src.size();
-    char *dst = new char[n + 1];
-    strncpy(dst, src.c_str(), n + 1);
-    return dst;
+char *Parser::copy_token_str() {
+    if (mode_ == ParseSyntaxOnly) {
+        return nullptr;
+    }
+    const Token &token = tokens_.peek();
+    return string_arena_.copy(token.text, token.len);
 }
 
 void TreeNode::print() {
     printf("TreeNode: line %d, NodeType %d, ", line_no, node_type);
-    if (this->node_type == NodeType::NodeExpr) {
+    if (this->node_type == NodeType::NodeError) {
+        printf("Error, ");
+    } else if (this->node_type == NodeType::NodeExpr) {
         printf("ExprProp: %d, ", this->expr);
         if (this->expr == ExprProp::ExprIdentifier) {
             printf("Identifier: %s, ", this->attr.name);
@@ -50,40 +71,47 @@ void TreeNode::print() {
     printf("\n");
 }
 
-void destroyTreeNode(TreeNode *tree) {
-    if (tree->node_type == NodeExpr && tree->expr == ExprIdentifier) {
-        delete tree->attr.name;
-        tree->attr.name = nullptr;
-    }
-    for (int i = 0; i < TreeNode::MAX_CHILDREN; ++i) {
-        if (tree->children[i] != nullptr) {
-            destroyTreeNode(tree->children[i]);
-        }
-    }
-    // do not use recursion here
-    TreeNode *next_node = nullptr;
-    TreeNode *neighbor = tree->neighbor;
-    while (neighbor != nullptr) {
-        if (neighbor->neighbor != nullptr) {
-            next_node = neighbor->neighbor;
-            neighbor->neighbor = nullptr;
-        }
-        destroyTreeNode(neighbor);
-        neighbor = next_node;
-        next_node = nullptr;
-    }
-}
-
-Parser::Parser() {
+Parser::Parser(ParseMode mode) : mode_(mode), sink_node_() {
     scanner_ = new Scanner();
 }
 
-TreeNode *Parser::parse(const char *input_data, size_t input_len) {
+SyntaxTree Parser::parse(const char *input_data, size_t input_len) {
+    error_count_ = 0;
+    panic_ = false;
     this->init_scanner(input_data, input_len);
+    if (this->token() == TokenType::ENDFILE) {
+        return nullptr; // an empty source is an empty program
+    }
     TreeNode *t = this->stmt_sequence();
+    TreeNode *tail = t;
+    while (this->token() != TokenType::ENDFILE) {
+        // a stray end / else / until at the top level
+        this->syntax_error("Expect: end of file");
+        tokens_.advance();
+        if (this->token() == TokenType::SEMI) {
+            tokens_.advance();
+        }
+        if (this->token() == TokenType::ENDFILE) {
+            break;
+        }
+        TreeNode *rest = this->stmt_sequence();
+        if (mode_ != ParseSyntaxOnly) {
+            while (tail->neighbor != nullptr)
+                tail = tail->neighbor;
+            tail->neighbor = rest;
+        }
+    }
+    if (mode_ == ParseSyntaxOnly) {
+        return nullptr;
+    }
     return t;
 }
 
+void Parser::reset() {
+    node_pool_.reset();
+    string_arena_.reset();
+}
+
 Parser::~Parser() {
     if (scanner_) {
         delete scanner_;
@@ -92,36 +120,74 @@ Parser::~Parser() {
 }
 
 void Parser::match_token(TokenType token) {
-    if (token == token_) {
-        token_ = this->scanner_->getToken(&token_str_);
+    if (token == this->token()) {
+        tokens_.advance();
+        panic_ = false;
     } else {
         this->syntax_error(("Expect: " + getTokenTypeName(token)).c_str());
+        this->synchronize();
     }
 }
 
 void Parser::syntax_error(const char *msg) {
-    printf("Unexpected token: %s at line %lu. %s\n",
-           token_str_.c_str(), scanner_->current_line_no(), msg);
+    if (panic_) {
+        return;
+    }
+    panic_ = true;
+    ++error_count_;
+    const Token &token = tokens_.peek();
+    printf("Unexpected token: %.*s at line %lu. %s\n",
+           static_cast<int>(token.len), token.text, token.line_no, msg);
+    if (error_count_ >= max_errors_) {
+        printf("Too many errors, stop parsing.\n");
+        // every loop of the parser terminates at the end of file
+        tokens_.finish();
+    }
+}
+
+void Parser::synchronize() {
+    while (this->token() != TokenType::SEMI && this->token() != TokenType::END &&
+           this->token() != TokenType::UNTIL && this->token() != TokenType::ELSE &&
+           this->token() != TokenType::ENDFILE) {
+        tokens_.advance();
+    }
 }
 
 TreeNode *Parser::stmt_sequence() {
     TreeNode *node = this->statement();
-    if (node == nullptr) {
-        return node;
-    }
     TreeNode *t = node;
-    while (token_ != TokenType::ENDFILE && token_ != TokenType::END &&
-           token_ != TokenType::ELSE && token_ != TokenType::UNTIL) {
-        this->match_token(TokenType::SEMI);
+    while (this->token() != TokenType::ENDFILE && this->token() != TokenType::END &&
+           this->token() != TokenType::ELSE && this->token() != TokenType::UNTIL) {
+        switch (this->token()) {
+            case TokenType::IF:
+            case TokenType::REPEAT:
+            case TokenType::ID:
+            case TokenType::READ:
+            case TokenType::WRITE:
+                // a missing ';' before a statement, keep parsing
+                this->syntax_error("Expect: ;");
+                break;
+            case TokenType::SEMI:
+                this->match_token(TokenType::SEMI);
+                break;
+            default:
+                this->syntax_error("Expect: ;");
+                this->synchronize();
+                if (this->token() != TokenType::SEMI) {
+                    // resynchronized at end / else / until / end of file
+                    continue;
+                }
+                this->match_token(TokenType::SEMI);
+                break;
+        }
         t->neighbor = this->statement();
-        if (t->neighbor != nullptr)
-            t = t->neighbor;
+        t = t->neighbor;
     }
     return node;
 }
 TreeNode *Parser::statement() {
     TreeNode *node = nullptr;
-    switch (token_) {
+    switch (this->token()) {
         case TokenType::IF:
             node = this->if_stmt();
             break;
@@ -138,7 +204,9 @@ TreeNode *Parser::statement() {
             node = this->write_stmt();
             break;
         default:
-            this->match_token(token_);
+            node = make_error_node();
+            this->syntax_error("Expect: statement");
+            this->synchronize();
             break;
     }
     return node;
@@ -149,7 +217,7 @@ TreeNode *Parser::if_stmt() {
     node->children[0] = this->expr();
     this->match_token(TokenType::THEN);
     node->children[1] = this->stmt_sequence();
-    if (token_ == TokenType::ELSE) {
+    if (this->token() == TokenType::ELSE) {
         this->match_token(TokenType::ELSE);
         node->children[2] = this->stmt_sequence();
     }
@@ -166,7 +234,7 @@ TreeNode *Parser::repeat_stmt() {
 }
 TreeNode *Parser::assign_stmt() {
     TreeNode *node = make_stmt_node(StmtAssign);
-    node->attr.name = copy_str(token_str_);
+    node->attr.name = this->copy_token_str();
     this->match_token(TokenType::ID);
     this->match_token(TokenType::ASSIGN);
     node->children[0] = this->expr();
@@ -175,7 +243,10 @@ TreeNode *Parser::assign_stmt() {
 TreeNode *Parser::read_stmt() {
     TreeNode *node = make_stmt_node(StmtRead);
     this->match_token(TokenType::READ);
-    node->attr.name = copy_str(token_str_);
+    if (mode_ != ParseSyntaxOnly) {
+        node->offset = this->token_offset();
+    }
+    node->attr.name = this->copy_token_str();
     this->match_token(TokenType::ID);
     return node;
 }
@@ -187,19 +258,19 @@ TreeNode *Parser::write_stmt() {
 }
 TreeNode *Parser::expr() {
     TreeNode *node = this->simple_expr();
-    if (token_ == TokenType::LT || token_ == TokenType::EQ) {
+    if (this->token() == TokenType::LT || this->token() == TokenType::EQ) {
         TreeNode *t = make_expr_node(ExprOp);
         t->children[0] = node;
-        t->attr.op = token_;
+        t->attr.op = this->token();
         node = t; // node t is now the parent node
-        this->match_token(token_);
+        this->match_token(this->token());
         node->children[1] = this->simple_expr();
     }
     return node;
 }
 TreeNode *Parser::simple_expr() {
     TreeNode *node = this->term();
-    if (token_ == TokenType::PLUS || token_ == TokenType::MINUS) {
+    if (this->token() == TokenType::PLUS || this->token() == TokenType::MINUS) {
         TreeNode *t = this->add_op();
         t->children[0] = node;
         node = t;
@@ -209,13 +280,13 @@ TreeNode *Parser::simple_expr() {
 }
 TreeNode *Parser::add_op() {
     TreeNode *node = make_expr_node(ExprOp);
-    node->attr.op = token_;
-    this->match_token(token_);
+    node->attr.op = this->token();
+    this->match_token(this->token());
     return node;
 }
 TreeNode *Parser::term() {
     TreeNode *node = this->factor();
-    if (token_ == TokenType::TIMES || token_ == TokenType::OVER) {
+    if (this->token() == TokenType::TIMES || this->token() == TokenType::OVER) {
         TreeNode *t = this->mul_op();
         t->children[0] = node;
         node = t;
@@ -225,13 +296,13 @@ TreeNode *Parser::term() {
 }
 TreeNode *Parser::mul_op() {
     TreeNode *node = make_expr_node(ExprOp);
-    node->attr.op = token_;
-    this->match_token(token_);
+    node->attr.op = this->token();
+    this->match_token(this->token());
     return node;
 }
 TreeNode *Parser::factor() {
     TreeNode *node = nullptr;
-    switch (token_) {
+    switch (this->token()) {
         case TokenType::LPAREN:
             this->match_token(TokenType::LPAREN);
             node = this->expr();
@@ -239,16 +310,20 @@ TreeNode *Parser::factor() {
             break;
         case TokenType::NUM:
             node = make_expr_node(ExprConst);
-            node->attr.val = strtol(token_str_.c_str(), nullptr, 10);
+            if (mode_ != ParseSyntaxOnly) {
+                node->attr.val = tokenToInt(tokens_.peek());
+            }
             this->match_token(TokenType::NUM);
             break;
         case TokenType::ID:
             node = make_expr_node(ExprIdentifier);
-            node->attr.name = copy_str(token_str_);
+            node->attr.name = this->copy_token_str();
             this->match_token(TokenType::ID);
             break;
         default:
-            this->syntax_error("");
+            node = make_error_node();
+            this->syntax_error("Expect: expression");
+            this->synchronize();
             break;
     }
     return node;
@@ -9,12 +9,15 @@
 #define PARSER_H
 
 #include "scanner.h"
+#include "token_buffer.h"
+#include "ast_pool.h"
 
 namespace tinylang {
 
 enum NodeType {
     NodeStmt,
-    NodeExpr
+    NodeExpr,
+    NodeError // placeholder for a statement or factor that failed to parse
 };
 
 enum StmtProp {
@@ -40,11 +43,20 @@ enum ExprType {
     ExpBool
 };
 
+/**
+ * @brief Run-time checks an operator node is proven not to need
+ */
+enum SafetyFlags {
+    SafeNoDivZero = 1, // the divisor of an OVER node is never zero
+    SafeNoOverflow = 2 // the result always fits in 32 bits
+};
+
 struct TreeNode {
     static constexpr int MAX_CHILDREN = 8;
     TreeNode *children[MAX_CHILDREN];
     TreeNode *neighbor = nullptr;
     int line_no;
+    unsigned offset; // in the input, of the name if any, else of the first token
     NodeType node_type;
     union {
         StmtProp stmt;
@@ -56,26 +68,61 @@ struct TreeNode {
         char *name;   // for Identifier expression
     } attr; // un-named union for expression
     ExprType expr_type;
+    unsigned safety; // SafetyFlags set by the range analysis
+    int slot = -1; // variable of a named node, set by the analyser
 
     void print();
 };
 
 /**
- * @brief Destroy the TreeNode recursively
+ * @brief Lightweight handle to a syntax tree owned by a parser.
+ *  It stays valid until the next reset() of that parser.
+ */
+class SyntaxTree {
+public:
+    SyntaxTree(TreeNode *root = nullptr) : root_(root) {}
+
+    TreeNode *root() const { return root_; }
+
+    operator TreeNode *() const { return root_; }
+    TreeNode *operator->() const { return root_; }
+
+private:
+    TreeNode *root_;
+};
+
+/**
+ * @brief Parsing modes.
+ *  ParseSyntaxOnly runs the same recursive descent but allocates no nodes
+ *  and copies no names; only the diagnostics are reported.
  */
-void destroyTreeNode(TreeNode *tree);
+enum ParseMode {
+    ParseFull,
+    ParseSyntaxOnly
+};
 
 class Parser {
 public:
     /** @brief
      * Initialize the parser
      */
-    Parser();
+    Parser(ParseMode mode = ParseFull);
 
     /** @brief Parse and return the syntax tree if success.
-     *  The TreeNode pointer should be released by the caller.
+     *  The nodes and names live in pools owned by the parser, so the tree
+     *  stays valid until the next reset(). Trees of several parse() calls
+     *  may coexist. Always returns nullptr in ParseSyntaxOnly mode.
      */
-    TreeNode *parse(const char *input_data, size_t input_len);
+    SyntaxTree parse(const char *input_data, size_t input_len);
+
+    /** @brief Recycle the memory of every tree returned so far. */
+    void reset();
+
+    /** @brief Number of syntax errors reported by the last parse. */
+    int error_count() const { return error_count_; }
+
+    /** @brief Stop parsing after reporting this many syntax errors. */
+    void set_max_errors(int max_errors) { max_errors_ = max_errors; }
 
     ~Parser();
 private:
@@ -83,10 +130,23 @@ private:
      * @brief Initialize the scanner and try to get the first token
      */
     void init_scanner(const char *input_data, size_t input_len) {
+        input_ = input_data;
         scanner_->setInput(input_data, input_len);
-        token_ = scanner_->getToken(&token_str_);
+        tokens_.reset(scanner_);
     }
 
+    //! @brief Offset of the current lookahead token in the input
+    unsigned token_offset() { return tokens_.peek().text - input_; }
+
+    //! @brief Type of the current lookahead token
+    TokenType token() { return tokens_.peek().type; }
+
+    /**
+     * @brief Look k tokens past the current lookahead without consuming.
+     *  k must be less than TokenBuffer::CAPACITY.
+     */
+    const Token &peek(size_t k) { return tokens_.peek(k); }
+
     /**
      * @brief Compare the given token with the current lookahead token.
      *  Get next lookahead token if they matches or it throws error.
@@ -95,11 +155,24 @@ private:
      */
     void match_token(TokenType token);
 
+    /**
+     * @brief Report a syntax error and enter panic mode.
+     *  Errors are not reported again until a token is matched.
+     */
     void syntax_error(const char *msg);
 
+    /**
+     * @brief Skip tokens until one that can end a statement:
+     *  ; end until else or end of file.
+     */
+    void synchronize();
+
 
     TreeNode *make_stmt_node(StmtProp stmt_prop);
     TreeNode *make_expr_node(ExprProp expr_prop);
+    TreeNode *make_error_node();
+    //! @brief Copy the lookahead token string, or nullptr in syntax-only mode
+    char *copy_token_str();
 
     // stmt_sequence -> statement {; statement}
     TreeNode *stmt_sequence();
@@ -126,8 +199,16 @@ private:
 
 private:
     Scanner *scanner_ = nullptr;
-    TokenType token_; // token for lookahead
-    std::string token_str_;
+    const char *input_ = nullptr;
+    TokenBuffer tokens_; // lookahead tokens
+    ParseMode mode_;
+    int error_count_ = 0;
+    int max_errors_ = 100;
+    bool panic_ = false; // suppress cascading errors until resynchronized
+    // all nodes are folded into this one in ParseSyntaxOnly mode
+    TreeNode sink_node_;
+    NodePool node_pool_;
+    StringArena string_arena_;
 };
 
 } /* namespace tinylang */
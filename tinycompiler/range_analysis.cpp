@@ -0,0 +1,334 @@
+/*
+ * range_analysis.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "range_analysis.h"
+#include <algorithm>
+#include <set>
+
+namespace tinylang {
+
+static bool fits(const Interval & r) {
+    return r.lo >= INT32_MIN && r.hi <= INT32_MAX;
+}
+
+static Interval join(const Interval & a, const Interval & b) {
+    if (a.empty())
+        return b;
+    if (b.empty())
+        return a;
+    return Interval{std::min(a.lo, b.lo), std::max(a.hi, b.hi)};
+}
+
+//! @brief Range of truncating a / b for a divisor range without zero
+static Interval divide(const Interval & a, const Interval & b) {
+    int64_t q[4] = {a.lo / b.lo, a.lo / b.hi, a.hi / b.lo, a.hi / b.hi};
+    return Interval{*std::min_element(q, q + 4), *std::max_element(q, q + 4)};
+}
+
+void RangeAnalysis::collect(TreeNode * e) {
+    if (e == nullptr || e->node_type != NodeExpr)
+        return;
+    if (e->expr == ExprIdentifier) {
+        if (names_.lookup(e->attr.name) < 0)
+            names_.insert(e->attr.name, e->line_no);
+    } else if (e->expr == ExprConst) {
+        for (int64_t d = -1; d <= 1; ++d) {
+            int64_t t = static_cast<int64_t>(e->attr.val) + d;
+            if (Interval::top().contains(t))
+                thresholds_.push_back(t);
+        }
+    } else {
+        this->collect(e->children[0]);
+        this->collect(e->children[1]);
+    }
+}
+
+Interval RangeAnalysis::widen(const Interval & old, const Interval & now) const {
+    if (old.empty() || now.empty())
+        return join(old, now);
+    Interval r = old;
+    if (now.lo < old.lo) {
+        // the largest threshold not above the new bound
+        auto it = std::upper_bound(thresholds_.begin(), thresholds_.end(), now.lo);
+        r.lo = *(it - 1);
+    }
+    if (now.hi > old.hi) {
+        r.hi = *std::lower_bound(thresholds_.begin(), thresholds_.end(), now.hi);
+    }
+    return r;
+}
+
+void RangeAnalysis::clear_flags(TreeNode * e) {
+    if (e == nullptr || e->node_type != NodeExpr)
+        return;
+    e->safety = 0;
+    if (e->expr == ExprOp) {
+        this->clear_flags(e->children[0]);
+        this->clear_flags(e->children[1]);
+    }
+}
+
+Interval RangeAnalysis::eval(TreeNode * e, const State & s, bool annotate) {
+    if (e == nullptr || e->node_type != NodeExpr)
+        return Interval::top();
+    if (e->expr == ExprConst)
+        return Interval::constant(e->attr.val);
+    if (e->expr == ExprIdentifier)
+        return s[this->var(e)];
+
+    Interval a = this->eval(e->children[0], s, annotate);
+    Interval b = this->eval(e->children[1], s, annotate);
+    if (e->attr.op == TokenType::LT || e->attr.op == TokenType::EQ)
+        return Interval::top();
+    if (a.empty() || b.empty())
+        return Interval::bottom();
+
+    unsigned safety = 0;
+    Interval r = Interval::top();
+    switch (e->attr.op) {
+        case TokenType::PLUS:
+            r = Interval{a.lo + b.lo, a.hi + b.hi};
+            break;
+        case TokenType::MINUS:
+            r = Interval{a.lo - b.hi, a.hi - b.lo};
+            break;
+        case TokenType::TIMES: {
+            int64_t p[4] = {a.lo * b.lo, a.lo * b.hi, a.hi * b.lo, a.hi * b.hi};
+            r = Interval{*std::min_element(p, p + 4), *std::max_element(p, p + 4)};
+            break;
+        }
+        case TokenType::OVER:
+            if (!b.contains(0)) {
+                safety |= SafeNoDivZero;
+                r = divide(a, b);
+            } else {
+                // the quotient of the non-zero divisors, if any
+                r = Interval::bottom();
+                if (b.lo < 0)
+                    r = join(r, divide(a, Interval{b.lo, -1}));
+                if (b.hi > 0)
+                    r = join(r, divide(a, Interval{1, b.hi}));
+            }
+            break;
+        default:
+            break;
+    }
+    if (fits(r)) {
+        safety |= SafeNoOverflow;
+    } else {
+        r = Interval::top(); // wraps around
+    }
+    if (annotate) {
+        e->safety = safety;
+        checks_ += e->attr.op == TokenType::OVER ? 2 : 1;
+        proven_ += ((safety & SafeNoDivZero) != 0) + ((safety & SafeNoOverflow) != 0);
+    }
+    return r;
+}
+
+void RangeAnalysis::transfer(const BasicBlock & block, State & s, bool annotate) {
+    for (TreeNode * t : block.stmts) {
+        if (t->node_type != NodeStmt)
+            continue;
+        if (t->stmt == StmtAssign) {
+            s[this->var(t)] = this->eval(t->children[0], s, annotate);
+        } else if (t->stmt == StmtRead) {
+            s[this->var(t)] = Interval::top();
+        } else if (t->stmt == StmtWrite) {
+            this->eval(t->children[0], s, annotate);
+        }
+    }
+    if (block.cond != nullptr) {
+        this->eval(block.cond, s, annotate);
+    }
+}
+
+bool RangeAnalysis::refine(TreeNode * cond, bool taken, State & s) {
+    if (cond->node_type != NodeExpr || cond->expr != ExprOp ||
+        (cond->attr.op != TokenType::LT && cond->attr.op != TokenType::EQ))
+        return true;
+    TreeNode * l = cond->children[0];
+    TreeNode * r = cond->children[1];
+    Interval a = this->eval(l, s, false);
+    Interval b = this->eval(r, s, false);
+    bool l_var = l->node_type == NodeExpr && l->expr == ExprIdentifier;
+    bool r_var = r->node_type == NodeExpr && r->expr == ExprIdentifier;
+    Interval * lv = l_var ? &s[this->var(l)] : nullptr;
+    Interval * rv = r_var ? &s[this->var(r)] : nullptr;
+    if (cond->attr.op == TokenType::LT) {
+        if (taken) {
+            // a < b
+            if (lv) lv->hi = std::min(lv->hi, b.hi - 1);
+            if (rv) rv->lo = std::max(rv->lo, a.lo + 1);
+        } else {
+            // a >= b
+            if (lv) lv->lo = std::max(lv->lo, b.lo);
+            if (rv) rv->hi = std::min(rv->hi, a.hi);
+        }
+    } else if (taken) {
+        if (lv) *lv = Interval{std::max(lv->lo, b.lo), std::min(lv->hi, b.hi)};
+        if (rv) *rv = Interval{std::max(rv->lo, a.lo), std::min(rv->hi, a.hi)};
+    } else {
+        // a != b only excludes a constant at the end of the range
+        if (lv && b.lo == b.hi) {
+            if (lv->lo == b.lo) ++lv->lo;
+            if (lv->hi == b.lo) --lv->hi;
+        }
+        if (rv && a.lo == a.hi) {
+            if (rv->lo == a.lo) ++rv->lo;
+            if (rv->hi == a.lo) --rv->hi;
+        }
+    }
+    return !(a.empty() || b.empty() || (lv && lv->empty()) || (rv && rv->empty()));
+}
+
+void RangeAnalysis::run(TreeNode * tree) {
+    ControlFlowGraph cfg(tree);
+    names_ = SymTable();
+    thresholds_ = {INT32_MIN, 0, INT32_MAX};
+    for (const BasicBlock & block : cfg.blocks()) {
+        for (TreeNode * t : block.stmts) {
+            if (t->node_type != NodeStmt)
+                continue;
+            if ((t->stmt == StmtAssign || t->stmt == StmtRead) &&
+                names_.lookup(t->attr.name) < 0)
+                names_.insert(t->attr.name, t->line_no);
+            this->collect(t->children[0]);
+        }
+        this->collect(block.cond);
+    }
+    std::sort(thresholds_.begin(), thresholds_.end());
+    thresholds_.erase(std::unique(thresholds_.begin(), thresholds_.end()),
+                      thresholds_.end());
+
+    size_t n = cfg.size();
+    std::vector<int> order = cfg.reverse_postorder();
+    std::vector<int> rank(n, -1);
+    for (size_t i = 0; i < order.size(); ++i) {
+        rank[order[i]] = i;
+    }
+    // a block entered by a back edge heads a loop
+    std::vector<char> loop_head(n, 0);
+    for (int b : order) {
+        for (int p : cfg.block(b).preds) {
+            if (rank[p] >= rank[b])
+                loop_head[b] = 1;
+        }
+    }
+
+    State bottom(names_.size(), Interval::bottom());
+    in_.assign(n, bottom);
+    reachable_.assign(n, 0);
+    std::vector<State> edge[2] = {std::vector<State>(n, bottom),
+                                  std::vector<State>(n, bottom)};
+    std::vector<char> edge_reachable[2] = {std::vector<char>(n, 0),
+                                           std::vector<char>(n, 0)};
+
+    // the input of b from its predecessors; false if none reaches it
+    State input;
+    auto gather = [&](int b) {
+        if (b == cfg.entry()) {
+            input.assign(names_.size(), Interval::top());
+            return true;
+        }
+        bool any = false;
+        input = bottom;
+        for (int p : cfg.block(b).preds) {
+            for (int slot = 0; slot < 2; ++slot) {
+                if (cfg.block(p).succ[slot] != b || !edge_reachable[slot][p])
+                    continue;
+                any = true;
+                for (size_t v = 0; v < input.size(); ++v) {
+                    input[v] = join(input[v], edge[slot][p][v]);
+                }
+            }
+        }
+        return any;
+    };
+    auto flow = [&](int b, bool annotate) {
+        const BasicBlock & block = cfg.block(b);
+        State s = in_[b];
+        this->transfer(block, s, annotate);
+        if (block.cond == nullptr) {
+            edge[0][b] = s;
+            edge_reachable[0][b] = 1;
+            return;
+        }
+        for (int slot = 0; slot < 2; ++slot) {
+            edge[slot][b] = s;
+            edge_reachable[slot][b] = this->refine(block.cond, slot == 0, edge[slot][b]);
+        }
+    };
+
+    // ascending iterations with widening, in reverse postorder
+    std::set<int> worklist = {rank[cfg.entry()]};
+    while (!worklist.empty()) {
+        int b = order[*worklist.begin()];
+        worklist.erase(worklist.begin());
+        if (!gather(b))
+            continue;
+        if (reachable_[b] && loop_head[b]) {
+            for (size_t v = 0; v < input.size(); ++v) {
+                input[v] = this->widen(in_[b][v], input[v]);
+            }
+        }
+        if (reachable_[b] && input == in_[b])
+            continue;
+        in_[b] = input;
+        reachable_[b] = 1;
+        flow(b, false);
+        for (int slot = 0; slot < 2; ++slot) {
+            int s = cfg.block(b).succ[slot];
+            if (s >= 0 && edge_reachable[slot][b])
+                worklist.insert(rank[s]);
+        }
+    }
+
+    // descending rounds without widening
+    for (int round = 0; round < 2; ++round) {
+        for (int b : order) {
+            if (!reachable_[b])
+                continue;
+            if (gather(b)) {
+                in_[b] = input;
+            } else {
+                reachable_[b] = 0;
+                in_[b] = bottom;
+                edge_reachable[0][b] = edge_reachable[1][b] = 0;
+                continue;
+            }
+            flow(b, false);
+        }
+    }
+
+    checks_ = proven_ = 0;
+    exit_state_.clear();
+    for (size_t b = 0; b < n; ++b) {
+        const BasicBlock & block = cfg.block(b);
+        if (reachable_[b]) {
+            State s = in_[b];
+            this->transfer(block, s, true);
+            if (static_cast<int>(b) == cfg.exit())
+                exit_state_.swap(s);
+        } else {
+            for (TreeNode * t : block.stmts) {
+                if (t->node_type == NodeStmt)
+                    this->clear_flags(t->children[0]);
+            }
+            this->clear_flags(block.cond);
+        }
+    }
+}
+
+Interval RangeAnalysis::exit_range(const char * name) const {
+    int v = names_.lookup(name);
+    if (v < 0 || exit_state_.empty())
+        return Interval::bottom();
+    return exit_state_[v];
+}
+
+} /* namespace tinylang */
@@ -0,0 +1,89 @@
+/*
+ * range_analysis.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef RANGE_ANALYSIS_H
+#define RANGE_ANALYSIS_H
+
+#include "cfg.h"
+#include "symtable.h"
+#include <cstdint>
+#include <vector>
+
+namespace tinylang {
+
+//! @brief Closed range of 32-bit integers, empty if lo > hi
+struct Interval {
+    int64_t lo;
+    int64_t hi;
+
+    static Interval top() { return Interval{INT32_MIN, INT32_MAX}; }
+    static Interval bottom() { return Interval{1, 0}; }
+    static Interval constant(int64_t v) { return Interval{v, v}; }
+
+    bool empty() const { return lo > hi; }
+    bool contains(int64_t v) const { return lo <= v && v <= hi; }
+
+    bool operator==(const Interval & other) const {
+        return (empty() && other.empty()) || (lo == other.lo && hi == other.hi);
+    }
+    bool operator!=(const Interval & other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Abstract interpretation of the program over integer intervals.
+ *  Every variable gets an interval per basic block; conditions narrow the
+ *  variables they compare on each outgoing edge. At loop heads the ranges
+ *  are widened to the next constant of the program (or to the 32-bit
+ *  limits), then two descending rounds recover the precision lost.
+ *
+ *  Afterwards every PLUS / MINUS / TIMES / OVER node carries SafeNoOverflow
+ *  if its result always fits in 32 bits, and an OVER node carries
+ *  SafeNoDivZero if its divisor can not be zero, so a code generator may
+ *  leave out those checks. Arithmetic wraps in 32 bits, so an operation
+ *  that may overflow yields the full range.
+ */
+class RangeAnalysis {
+public:
+    void run(TreeNode * tree);
+
+    //! @brief Range of the variable at the end of the program
+    Interval exit_range(const char * name) const;
+
+    //! @brief Run-time checks the operator nodes would need without the analysis
+    size_t checks() const { return checks_; }
+
+    //! @brief Checks proven unnecessary
+    size_t proven() const { return proven_; }
+
+private:
+    typedef std::vector<Interval> State; // indexed by variable
+
+    Interval eval(TreeNode * e, const State & s, bool annotate);
+    void transfer(const BasicBlock & block, State & s, bool annotate);
+
+    //! @return false if the branch can not be taken
+    bool refine(TreeNode * cond, bool taken, State & s);
+
+    void collect(TreeNode * e);
+    int var(const TreeNode * t) const { return names_.lookup(t->attr.name); }
+
+    Interval widen(const Interval & old, const Interval & now) const;
+    void clear_flags(TreeNode * e);
+
+private:
+    SymTable names_;
+    std::vector<int64_t> thresholds_; // sorted
+    std::vector<State> in_;
+    std::vector<char> reachable_;
+    State exit_state_; // at the end of the exit block, empty if unreachable
+    size_t checks_ = 0;
+    size_t proven_ = 0;
+};
+
+} /* namespace tinylang */
+
+#endif /* !RANGE_ANALYSIS_H */
@@ -0,0 +1,244 @@
+/*
+ * register_vm.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "register_vm.h"
+#include "interpreter.h"
+#include "vm_dispatch.h"
+#include <algorithm>
+
+#define VM_FETCH() ((pc++)->op)
+
+namespace tinylang {
+
+static const char * const REG_OPCODE_NAMES[] = {
+#define TINY_REG_OPCODE_NAME(op) #op + 4,
+    TINY_REG_OPCODES(TINY_REG_OPCODE_NAME)
+#undef TINY_REG_OPCODE_NAME
+};
+
+int RegisterProgram::line_of(uint32_t index) const {
+    auto it = std::lower_bound(div_lines.begin(), div_lines.end(),
+                               std::make_pair(index, 0));
+    return it != div_lines.end() && it->first == index ? it->second : 0;
+}
+
+void RegisterProgram::print(FILE * out) const {
+    for (size_t i = 0; i < constants.size(); ++i) {
+        fprintf(out, "        r%zu = %d\n", slots + i, constants[i]);
+    }
+    for (size_t pc = 0; pc < code.size(); ++pc) {
+        const RegInstr & ins = code[pc];
+        fprintf(out, "%6zu  %s %d %d %d\n", pc, REG_OPCODE_NAMES[ins.op],
+                ins.a, ins.b, ins.c);
+    }
+}
+
+RegisterProgram RegisterCompiler::compile(TreeNode * tree, size_t slots) {
+    prog_ = RegisterProgram();
+    prog_.slots = slots;
+    constant_regs_.clear();
+    this->collect_constants(tree);
+    first_temp_ = temp_top_ = slots + prog_.constants.size();
+    this->stmt_sequence(tree);
+    this->emit(ROP_HALT, 0);
+    return std::move(prog_);
+}
+
+void RegisterCompiler::collect_constants(TreeNode * t) {
+    for (; t != nullptr; t = t->neighbor) {
+        if (t->node_type == NodeExpr && t->expr == ExprConst &&
+            constant_regs_.find(t->attr.val) == constant_regs_.end()) {
+            constant_regs_[t->attr.val] = prog_.slots + prog_.constants.size();
+            prog_.constants.push_back(t->attr.val);
+        }
+        for (TreeNode * child : t->children) {
+            if (child != nullptr)
+                this->collect_constants(child);
+        }
+    }
+}
+
+void RegisterCompiler::stmt_sequence(TreeNode * t) {
+    for (; t != nullptr; t = t->neighbor) {
+        switch (t->stmt) {
+            case StmtIf: {
+                size_t to_else = this->jump_unless(t->children[0]);
+                this->stmt_sequence(t->children[1]);
+                if (t->children[2] != nullptr) {
+                    size_t to_end = this->emit(ROP_JUMP, 0);
+                    prog_.code[to_else].a = prog_.code.size();
+                    this->stmt_sequence(t->children[2]);
+                    prog_.code[to_end].a = prog_.code.size();
+                } else {
+                    prog_.code[to_else].a = prog_.code.size();
+                }
+                break;
+            }
+            case StmtRepeat: {
+                int body = prog_.code.size();
+                this->stmt_sequence(t->children[0]);
+                prog_.code[this->jump_unless(t->children[1])].a = body;
+                break;
+            }
+            case StmtAssign:
+                this->expr(t->children[0], t->slot);
+                break;
+            case StmtRead:
+                this->emit(ROP_READ, t->slot);
+                break;
+            case StmtWrite:
+                this->emit(ROP_WRITE, 0, this->expr(t->children[0], -1));
+                break;
+        }
+        temp_top_ = first_temp_;
+    }
+}
+
+int RegisterCompiler::expr(TreeNode * e, int dst) {
+    int src = -1;
+    if (e->expr == ExprConst) {
+        src = constant_regs_[e->attr.val];
+    } else if (e->expr == ExprIdentifier) {
+        src = e->slot;
+    }
+    if (src >= 0) {
+        if (dst >= 0 && dst != src)
+            this->emit(ROP_MOVE, dst, src);
+        return dst >= 0 ? dst : src;
+    }
+
+    RegOpcode op = ROP_ADD;
+    switch (e->attr.op) {
+        case TokenType::PLUS: op = ROP_ADD; break;
+        case TokenType::MINUS: op = ROP_SUB; break;
+        case TokenType::TIMES: op = ROP_MUL; break;
+        case TokenType::OVER:
+            op = (e->safety & SafeNoDivZero) ? ROP_DIV_NZ : ROP_DIV;
+            break;
+        case TokenType::LT: op = ROP_LT; break;
+        case TokenType::EQ: op = ROP_EQ; break;
+        default: break;
+    }
+    int mark = temp_top_;
+    int l = this->expr(e->children[0], -1);
+    int r = this->expr(e->children[1], -1);
+    // the temporaries of the operands are free once the result is written
+    temp_top_ = mark;
+    if (dst < 0) {
+        dst = temp_top_++;
+        prog_.temps = std::max(prog_.temps, static_cast<size_t>(temp_top_ - first_temp_));
+    }
+    if (op == ROP_DIV)
+        prog_.div_lines.emplace_back(prog_.code.size(), e->line_no);
+    this->emit(op, dst, l, r);
+    return dst;
+}
+
+size_t RegisterCompiler::jump_unless(TreeNode * cond) {
+    if (cond->expr == ExprOp &&
+        (cond->attr.op == TokenType::LT || cond->attr.op == TokenType::EQ)) {
+        int l = this->expr(cond->children[0], -1);
+        int r = this->expr(cond->children[1], -1);
+        return this->emit(cond->attr.op == TokenType::LT ? ROP_JUMP_GE : ROP_JUMP_NE,
+                          0, l, r);
+    }
+    return this->emit(ROP_JUMP_FALSE, 0, this->expr(cond, -1));
+}
+
+int RegisterVM::run(const RegisterProgram & prog) {
+#ifdef TINY_VM_COMPUTED_GOTO
+    static void * const labels[] = {
+#define TINY_REG_OPCODE_LABEL(op) &&L_##op,
+        TINY_REG_OPCODES(TINY_REG_OPCODE_LABEL)
+#undef TINY_REG_OPCODE_LABEL
+    };
+#endif
+    regs_.assign(prog.registers(), 0);
+    std::copy(prog.constants.begin(), prog.constants.end(),
+              regs_.begin() + prog.slots);
+    const RegInstr * code = prog.code.data();
+    const RegInstr * pc = code;
+    int * r = regs_.data();
+    int ret = 0;
+
+// operands of the instruction being executed
+#define RA pc[-1].a
+#define RB pc[-1].b
+#define RC pc[-1].c
+
+    VM_SWITCH(VM_FETCH()) {
+        VM_CASE(ROP_HALT)
+            goto done;
+        VM_CASE(ROP_MOVE)
+            r[RA] = r[RB];
+            VM_NEXT();
+        // wrap around through unsigned arithmetic
+        VM_CASE(ROP_ADD)
+            r[RA] = static_cast<unsigned>(r[RB]) + r[RC];
+            VM_NEXT();
+        VM_CASE(ROP_SUB)
+            r[RA] = static_cast<unsigned>(r[RB]) - r[RC];
+            VM_NEXT();
+        VM_CASE(ROP_MUL)
+            r[RA] = static_cast<unsigned>(r[RB]) * r[RC];
+            VM_NEXT();
+        VM_CASE(ROP_DIV)
+            if (r[RC] == 0) {
+                report_division_by_zero(prog.line_of(pc - 1 - code));
+                ret = -1;
+                goto done;
+            }
+            r[RA] = tiny_divide(r[RB], r[RC]);
+            VM_NEXT();
+        VM_CASE(ROP_DIV_NZ)
+            r[RA] = tiny_divide(r[RB], r[RC]);
+            VM_NEXT();
+        VM_CASE(ROP_LT)
+            r[RA] = r[RB] < r[RC];
+            VM_NEXT();
+        VM_CASE(ROP_EQ)
+            r[RA] = r[RB] == r[RC];
+            VM_NEXT();
+        VM_CASE(ROP_JUMP)
+            pc = code + RA;
+            VM_NEXT();
+        VM_CASE(ROP_JUMP_FALSE)
+            if (!r[RB])
+                pc = code + RA;
+            VM_NEXT();
+        VM_CASE(ROP_JUMP_GE)
+            if (!(r[RB] < r[RC]))
+                pc = code + RA;
+            VM_NEXT();
+        VM_CASE(ROP_JUMP_NE)
+            if (r[RB] != r[RC])
+                pc = code + RA;
+            VM_NEXT();
+        VM_CASE(ROP_READ)
+            if (fscanf(in_, "%d", &r[RA]) != 1)
+                r[RA] = 0;
+            VM_NEXT();
+        VM_CASE(ROP_WRITE)
+            fprintf(out_, "%d\n", r[RB]);
+            VM_NEXT();
+#ifndef TINY_VM_COMPUTED_GOTO
+        default:
+            ret = -1;
+            goto done;
+#endif
+    }
+#undef RA
+#undef RB
+#undef RC
+
+done:
+    fflush(out_);
+    vars_.assign(regs_.begin(), regs_.begin() + prog.slots);
+    return ret;
+}
+
+} /* namespace tinylang */
@@ -0,0 +1,131 @@
+/*
+ * register_vm.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef REGISTER_VM_H
+#define REGISTER_VM_H
+
+#include "parser.h"
+#include <cstdint>
+#include <cstdio>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tinylang {
+
+/**
+ * @brief Opcodes of the register code; r[x] is register x, t a target.
+ */
+#define TINY_REG_OPCODES(X)                         \
+    X(ROP_HALT)                                     \
+    X(ROP_MOVE)       /* r[a] = r[b] */             \
+    X(ROP_ADD)        /* r[a] = r[b] + r[c] */      \
+    X(ROP_SUB)  X(ROP_MUL)  X(ROP_DIV)              \
+    X(ROP_DIV_NZ)     /* ROP_DIV, the divisor never 0 */ \
+    X(ROP_LT)   X(ROP_EQ)                           \
+    X(ROP_JUMP)       /* pc = a */                  \
+    X(ROP_JUMP_FALSE) /* if !r[b] then pc = a */    \
+    X(ROP_JUMP_GE)    /* if !(r[b] < r[c]) then pc = a */ \
+    X(ROP_JUMP_NE)    /* if r[b] != r[c] then pc = a */   \
+    X(ROP_READ)       /* r[a] = input */            \
+    X(ROP_WRITE)      /* print r[b] */
+
+enum RegOpcode : uint8_t {
+#define TINY_REG_OPCODE_ENUM(op) op,
+    TINY_REG_OPCODES(TINY_REG_OPCODE_ENUM)
+#undef TINY_REG_OPCODE_ENUM
+    REG_OPCODE_COUNT
+};
+
+//! @brief Three-address instruction
+struct RegInstr {
+    RegOpcode op;
+    int32_t a;
+    int32_t b;
+    int32_t c;
+};
+
+/**
+ * @brief Register code of a program.
+ *  The registers are the variables by slot, then the constants, which the
+ *  VM loads before the first instruction, then the temporaries. So every
+ *  operand is a register and `a := b * c + d` is two instructions.
+ */
+struct RegisterProgram {
+    std::vector<RegInstr> code;
+    std::vector<int> constants;
+    size_t slots = 0; // variables
+    size_t temps = 0;
+    std::vector<std::pair<uint32_t, int>> div_lines; // ROP_DIV index -> line
+
+    size_t registers() const { return slots + constants.size() + temps; }
+
+    //! @brief Source line of the ROP_DIV at the index
+    int line_of(uint32_t index) const;
+
+    //! @brief Print the disassembly
+    void print(FILE * out = stdout) const;
+};
+
+/**
+ * @brief Lower an analysed syntax tree into register code.
+ *  The variables are the slots the analyser gave the nodes; the result of
+ *  an assignment is computed straight into the variable. A division the
+ *  range analysis proved SafeNoDivZero becomes ROP_DIV_NZ, without the check.
+ */
+class RegisterCompiler {
+public:
+    RegisterProgram compile(TreeNode * tree, size_t slots);
+
+private:
+    void collect_constants(TreeNode * t);
+    void stmt_sequence(TreeNode * t);
+
+    //! @brief Compute e into dst, or into any register if dst < 0
+    //! @return the register holding the value
+    int expr(TreeNode * e, int dst);
+
+    //! @brief Emit a jump taken if the condition is false
+    //! @return index of the jump, to patch its target
+    size_t jump_unless(TreeNode * cond);
+
+    size_t emit(RegOpcode op, int32_t a, int32_t b = 0, int32_t c = 0) {
+        prog_.code.push_back(RegInstr{op, a, b, c});
+        return prog_.code.size() - 1;
+    }
+
+private:
+    RegisterProgram prog_;
+    std::unordered_map<int, int> constant_regs_;
+    int first_temp_ = 0;
+    int temp_top_ = 0; // next free temporary
+};
+
+/**
+ * @brief Virtual machine for the register code, with the dispatch of
+ *  vm_dispatch.h and the semantics of the Interpreter.
+ */
+class RegisterVM {
+public:
+    RegisterVM(FILE * in = stdin, FILE * out = stdout) : in_(in), out_(out) {}
+
+    //! @return 0 for success, -1 after a run-time error
+    int run(const RegisterProgram & prog);
+
+    //! @brief Values of the variables after the last run, indexed by slot
+    const std::vector<int> & variables() const { return vars_; }
+
+private:
+    FILE * in_;
+    FILE * out_;
+    std::vector<int> regs_;
+    std::vector<int> vars_;
+};
+
+} /* namespace tinylang */
+
+#endif /* !REGISTER_VM_H */
@@ -9,6 +9,7 @@
 #include <vector>
 #include <unordered_map>
 #include <algorithm>
+#include <cstring>
 
 namespace tinylang {
 
@@ -41,7 +42,6 @@ struct TokenTypeHasher {
 };
 
 static std::vector<std::vector<StateType>> transition_table;
-static std::unordered_map<std::string, TokenType> reserved_words;
 
 static void initTransitionTable();
 
@@ -87,11 +87,64 @@ Scanner::Scanner() {
     initTransitionTable();
 }
 
+/**
+ * @brief Look up reserved words and special symbols
+ *
+ * @return TokenType::ERROR if str is neither of them
+ */
+static TokenType lookupReserved(const char *str, size_t len) {
+    struct Reserved {
+        const char *str;
+        size_t len;
+        TokenType token;
+    };
+    static const Reserved reserved_words[] = {
+        {"if", 2, TokenType::IF},
+        {"then", 4, TokenType::THEN},
+        {"else", 4, TokenType::ELSE},
+        {"end", 3, TokenType::END},
+        {"repeat", 6, TokenType::REPEAT},
+        {"until", 5, TokenType::UNTIL},
+        {"read", 4, TokenType::READ},
+        {"write", 5, TokenType::WRITE},
+    };
+    if (len == 1) {
+        switch (str[0]) {
+            case '=': return TokenType::EQ;
+            case '<': return TokenType::LT;
+            case '+': return TokenType::PLUS;
+            case '-': return TokenType::MINUS;
+            case '*': return TokenType::TIMES;
+            case '/': return TokenType::OVER;
+            case '(': return TokenType::LPAREN;
+            case ')': return TokenType::RPAREN;
+            case ';': return TokenType::SEMI;
+            default: return TokenType::ERROR;
+        }
+    }
+    for (const auto &word : reserved_words) {
+        if (word.len == len && memcmp(word.str, str, len) == 0) {
+            return word.token;
+        }
+    }
+    return TokenType::ERROR;
+}
+
 TokenType Scanner::getToken(std::string *token_str) {
+    Token token = this->scan();
+    if (token_str != nullptr) {
+        token_str->assign(token.text, token.len);
+    }
+    return token.type;
+}
+
+Token Scanner::scan() {
     StateType state = StateType::START;
     StateType last_state;
     TokenType token = TokenType::ERROR;
-    std::string token_string;
+    // the characters of a token are contiguous in the input
+    const char *token_begin = current_ptr_;
+    size_t token_len = 0;
     while (state != StateType::DONE) {
         char c = this->getNextChar();
         SymbolType symbol_type = getSymbolType(c);
@@ -102,28 +155,29 @@ TokenType Scanner::getToken(std::string *token_str) {
         } else if (state == StateType::IN_NUM && symbol_type != DIGIT) {
             this->putNextChar();
         } else if (c != '\0') {
-            token_string.push_back(c);
+            if (token_len++ == 0) {
+                token_begin = current_ptr_ - 1;
+            }
         }
         state = transition_table[state][symbol_type];
         if (state == StateType::START){
-            token_string.clear();
+            token_len = 0;
         }
     }
     switch (last_state) {
         case StateType::START:
-            if (reserved_words.find(token_string) != reserved_words.end()) {
-                token = reserved_words[token_string];
-            } else if (token_string.empty()) {
+            if (token_len == 0) {
                 token = TokenType::ENDFILE;
+            } else {
+                token = lookupReserved(token_begin, token_len);
             }
             break;
         case StateType::IN_NUM:
             token = TokenType::NUM;
             break;
         case StateType::IN_IDENTIFIER:
-            if (reserved_words.find(token_string) != reserved_words.end()) {
-                token = reserved_words[token_string];
-            } else {
+            token = lookupReserved(token_begin, token_len);
+            if (token == TokenType::ERROR) {
                 token = TokenType::ID;
             }
             break;
@@ -133,10 +187,7 @@ TokenType Scanner::getToken(std::string *token_str) {
         default:
             break;
     }
-    if (token_str != nullptr) {
-        *token_str = token_string;
-    }
-    return token;
+    return Token{token, token_begin, token_len, line_number_};
 }
 
 void Scanner::setNextLine() {
@@ -211,24 +262,14 @@ static void initTransitionTable() {
     transition_table[StateType::IN_IDENTIFIER][SymbolType::OTHER] = StateType::DONE;
     transition_table[StateType::IN_ASSIGN][SymbolType::EQUAL] = StateType::DONE;
     transition_table[StateType::IN_ASSIGN][SymbolType::OTHER] = StateType::DONE;
+}
 
-    reserved_words["if"] = TokenType::IF;
-    reserved_words["then"] = TokenType::THEN;
-    reserved_words["else"] = TokenType::ELSE;
-    reserved_words["end"] = TokenType::END;
-    reserved_words["repeat"] = TokenType::REPEAT;
-    reserved_words["until"] = TokenType::UNTIL;
-    reserved_words["read"] = TokenType::READ;
-    reserved_words["write"] = TokenType::WRITE;
-    reserved_words["="] = TokenType::EQ;
-    reserved_words["<"] = TokenType::LT;
-    reserved_words["+"] = TokenType::PLUS;
-    reserved_words["-"] = TokenType::MINUS;
-    reserved_words["*"] = TokenType::TIMES;
-    reserved_words["/"] = TokenType::OVER;
-    reserved_words["("] = TokenType::LPAREN;
-    reserved_words[")"] = TokenType::RPAREN;
-    reserved_words[";"] = TokenType::SEMI;
+int tokenToInt(const Token &token) {
+    unsigned int val = 0;
+    for (size_t i = 0; i < token.len; ++i) {
+        val = val * 10 + (token.text[i] - '0');
+    }
+    return static_cast<int>(val);
 }
 
 std::string getTokenTypeName(TokenType t) {
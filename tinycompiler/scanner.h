@@ -26,11 +26,31 @@ enum class TokenType {
     /* multicharacter tokens */
     ID,NUM,
     /* special symbols */
-    ASSIGN,EQ,LT,PLUS,MINUS,TIMES,OVER,LPAREN,RPAREN,SEMI
+    ASSIGN,EQ,LT,PLUS,MINUS,TIMES,OVER,LPAREN,RPAREN,SEMI,
+    /* number of token types, not a real token */
+    TOKEN_TYPE_END_FLAG
 };
 
 std::string getTokenTypeName(TokenType t);
 
+/**
+ * @brief A scanned token. The text points into the input of the scanner,
+ *  so it is only valid as long as that input is.
+ */
+struct Token {
+    TokenType type;
+    const char *text;
+    size_t len;
+    size_t line_no; // line of the scanner after the token was read
+
+    std::string str() const { return std::string(text, len); }
+};
+
+/**
+ * @brief Value of a NUM token, wrapped to int like the arithmetic of TINY
+ */
+int tokenToInt(const Token &token);
+
 class Scanner {
 public:
     Scanner();
@@ -42,6 +62,11 @@ public:
      */
     TokenType getToken(std::string *token_str = nullptr);
 
+    /**
+     * @brief Get next token without copying its text
+     */
+    Token scan();
+
     void setInput(const char *input_data, size_t input_len);
 
     size_t current_line_no() const { return line_number_; }
@@ -0,0 +1,74 @@
+/*
+ * scoped_symtable.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "scoped_symtable.h"
+
+namespace tinylang {
+
+void ScopedSymTable::enter_scope() {
+    marks_.push_back(undo_.size());
+}
+
+void ScopedSymTable::exit_scope() {
+    if (marks_.empty()) {
+        return;
+    }
+    size_t mark = marks_.back();
+    marks_.pop_back();
+    while (undo_.size() > mark) {
+        bindings_[undo_.back().name] = undo_.back().previous;
+        undo_.pop_back();
+    }
+}
+
+int ScopedSymTable::name_id(const char * name, size_t len) {
+    int n = names_.lookup(name, len);
+    if (n < 0) {
+        n = names_.insert(name, len, 0);
+        bindings_.push_back(-1);
+    }
+    return n;
+}
+
+int ScopedSymTable::new_symbol(const char * name, size_t len, size_t scope,
+                               int line_no) {
+    records_.emplace_back();
+    records_.back().name.assign(name, len);
+    records_.back().lines.push_back(line_no);
+    scopes_.push_back(scope);
+    return records_.size() - 1;
+}
+
+int ScopedSymTable::declare(const char * name, size_t len, int line_no) {
+    int n = this->name_id(name, len);
+    int id = bindings_[n];
+    if (id >= 0 && scopes_[id] == this->depth()) {
+        this->insert_line(id, line_no);
+        return id;
+    }
+    if (this->depth() > 0) {
+        undo_.push_back(Undo{n, id});
+    }
+    id = this->new_symbol(name, len, this->depth(), line_no);
+    bindings_[n] = id;
+    return id;
+}
+
+int ScopedSymTable::insert(const char * name, size_t len, int line_no) {
+    int n = this->name_id(name, len);
+    int id = bindings_[n];
+    if (id >= 0) {
+        this->insert_line(id, line_no);
+        return id;
+    }
+    // nothing is visible, so no scope shadows a global binding of the name
+    id = this->new_symbol(name, len, 0, line_no);
+    bindings_[n] = id;
+    return id;
+}
+
+} /* namespace tinylang */
@@ -0,0 +1,104 @@
+/*
+ * scoped_symtable.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef SCOPED_SYMTABLE_H
+#define SCOPED_SYMTABLE_H
+
+#include "symtable.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace tinylang {
+
+/**
+ * @brief Symbol table with nested scopes.
+ *  Every name has one visible binding, found with a single hash probe.
+ *  Declaring a name in a scope saves the binding it shadows on an undo
+ *  stack, and leaving the scope restores the saved bindings, so entering
+ *  and leaving a scope costs O(number of bindings it introduced).
+ *  Scope 0 is the global scope, where insert() behaves as SymTable does.
+ */
+class ScopedSymTable {
+public:
+    ScopedSymTable() = default;
+
+    void enter_scope();
+
+    //! @brief Leave the innermost scope, the global scope is never left
+    void exit_scope();
+
+    //! @brief Depth of the innermost scope, 0 for the global scope
+    size_t depth() const { return marks_.size(); }
+
+    /**
+     * @brief Declare the name in the innermost scope, shadowing any outer
+     *  binding. A second declaration in the same scope adds an occurrence.
+     *
+     * @return the symbol id
+     */
+    int declare(const char * name, size_t len, int line_no);
+
+    int declare(const char * name, int line_no) {
+        return this->declare(name, strlen(name), line_no);
+    }
+
+    /**
+     * @brief Record an occurrence of the visible binding of the name,
+     *  declaring it in the global scope if there is none.
+     *
+     * @return the symbol id
+     */
+    int insert(const char * name, size_t len, int line_no);
+
+    int insert(const char * name, int line_no) {
+        return this->insert(name, strlen(name), line_no);
+    }
+
+    void insert_line(int id, int line_no) {
+        records_[id].lines.push_back(line_no);
+    }
+
+    //! @return the id of the visible binding, or -1
+    int lookup(const char * name, size_t len) const {
+        int n = names_.lookup(name, len);
+        return n < 0 ? -1 : bindings_[n];
+    }
+
+    int lookup(const char * name) const {
+        return this->lookup(name, strlen(name));
+    }
+
+    const SymRecord & record(int id) const { return records_[id]; }
+
+    //! @brief Depth of the scope that declared the symbol
+    size_t scope(int id) const { return scopes_[id]; }
+
+    //! @brief Number of symbols declared so far, in all scopes
+    size_t size() const { return records_.size(); }
+
+private:
+    struct Undo {
+        int name;
+        int previous; // binding before the declaration, -1 for none
+    };
+
+    int name_id(const char * name, size_t len);
+    int new_symbol(const char * name, size_t len, size_t scope, int line_no);
+
+private:
+    SymTable names_;            // interns the names
+    std::vector<int> bindings_; // visible symbol of each name, or -1
+    std::vector<SymRecord> records_;
+    std::vector<size_t> scopes_;
+    std::vector<Undo> undo_;
+    std::vector<size_t> marks_; // undo stack size at each scope entry
+};
+
+} /* namespace tinylang */
+
+#endif /* !SCOPED_SYMTABLE_H */
@@ -0,0 +1,373 @@
+/*
+ * ssa.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "ssa.h"
+
+namespace tinylang {
+
+static const char * const SSA_OP_NAMES[] = {
+    "const", "phi", "add", "sub", "mul", "div", "lt", "eq",
+    "read", "write", "jump", "branch", "return"
+};
+
+size_t SsaFunction::size() const {
+    size_t n = 0;
+    for (const SsaBlock & block : blocks_) {
+        for (int v = block.phis; v >= 0; v = instrs_[v].next)
+            ++n;
+        for (int v = block.first; v >= 0; v = instrs_[v].next)
+            ++n;
+    }
+    return n;
+}
+
+void SsaFunction::print(FILE * out) const {
+    std::vector<int> number(instrs_.size(), -1);
+    int next = 0;
+    for (const SsaBlock & block : blocks_) {
+        for (int v = block.phis; v >= 0; v = instrs_[v].next)
+            number[v] = next++;
+        for (int v = block.first; v >= 0; v = instrs_[v].next) {
+            if (instrs_[v].op < SSA_WRITE)
+                number[v] = next++;
+        }
+    }
+    for (size_t b = 0; b < blocks_.size(); ++b) {
+        const SsaBlock & block = blocks_[b];
+        fprintf(out, "b%zu:", b);
+        for (size_t k = 0; k < block.preds.size(); ++k)
+            fprintf(out, "%s b%d", k == 0 ? " <-" : ",", block.preds[k]);
+        fprintf(out, "\n");
+        for (int v = block.phis; v >= 0; v = instrs_[v].next) {
+            const SsaInstr & phi = instrs_[v];
+            fprintf(out, "  v%d = phi", number[v]);
+            for (int k = 0; k < phi.b; ++k) {
+                fprintf(out, "%s [v%d, b%d]", k == 0 ? "" : ",",
+                        number[this->phi_arg(phi, k)], block.preds[k]);
+            }
+            fprintf(out, "\n");
+        }
+        for (int v = block.first; v >= 0; v = instrs_[v].next) {
+            const SsaInstr & in = instrs_[v];
+            const char * name = SSA_OP_NAMES[in.op];
+            switch (in.op) {
+                case SSA_CONST:
+                    fprintf(out, "  v%d = %s %d\n", number[v], name, in.a);
+                    break;
+                case SSA_READ:
+                    fprintf(out, "  v%d = %s\n", number[v], name);
+                    break;
+                case SSA_WRITE:
+                    fprintf(out, "  %s v%d\n", name, number[in.a]);
+                    break;
+                case SSA_JUMP:
+                    fprintf(out, "  %s b%d\n", name, block.succ[0]);
+                    break;
+                case SSA_BRANCH:
+                    fprintf(out, "  %s v%d, b%d, b%d\n", name, number[in.a],
+                            block.succ[0], block.succ[1]);
+                    break;
+                case SSA_RETURN:
+                    fprintf(out, "  %s\n", name);
+                    break;
+                default:
+                    fprintf(out, "  v%d = %s v%d, v%d\n", number[v], name,
+                            number[in.a], number[in.b]);
+                    break;
+            }
+        }
+    }
+}
+
+SsaFunction SsaBuilder::build(TreeNode * tree, size_t slots, bool exit_values) {
+    fn_ = SsaFunction();
+    defs_.clear();
+    sealed_.clear();
+    incomplete_.clear();
+    replaced_.clear();
+    zero_ = -1;
+    block_ = this->new_block();
+    this->seal(block_);
+    this->stmt_sequence(tree);
+    if (exit_values) {
+        for (size_t var = 0; var < slots; ++var) {
+            fn_.exit_values_.push_back(this->read_variable(var, block_));
+        }
+    }
+    this->emit(SSA_RETURN);
+    this->finish();
+    return std::move(fn_);
+}
+
+int SsaBuilder::new_block() {
+    fn_.blocks_.emplace_back();
+    sealed_.push_back(0);
+    incomplete_.emplace_back();
+    return fn_.blocks_.size() - 1;
+}
+
+void SsaBuilder::add_edge(int from, int slot, int to) {
+    fn_.blocks_[from].succ[slot] = to;
+    fn_.blocks_[to].preds.push_back(from);
+}
+
+int SsaBuilder::emit(SsaOp op, int32_t a, int32_t b, int32_t line_no) {
+    int v = fn_.instrs_.size();
+    fn_.instrs_.push_back(SsaInstr{op, a, b, block_, -1, line_no});
+    replaced_.push_back(-1);
+    SsaBlock & block = fn_.blocks_[block_];
+    if (block.last >= 0) {
+        fn_.instrs_[block.last].next = v;
+    } else {
+        block.first = v;
+    }
+    block.last = v;
+    return v;
+}
+
+int SsaBuilder::zero() {
+    if (zero_ >= 0)
+        return zero_;
+    // at the start of the entry block, which dominates every use
+    zero_ = fn_.instrs_.size();
+    SsaBlock & entry = fn_.blocks_[0];
+    fn_.instrs_.push_back(SsaInstr{SSA_CONST, 0, -1, 0, entry.first, 0});
+    replaced_.push_back(-1);
+    entry.first = zero_;
+    if (entry.last < 0)
+        entry.last = zero_;
+    return zero_;
+}
+
+void SsaBuilder::stmt_sequence(TreeNode * t) {
+    for (; t != nullptr; t = t->neighbor) {
+        switch (t->stmt) {
+            case StmtIf: {
+                this->emit(SSA_BRANCH, this->expr(t->children[0]));
+                int head = block_;
+                int then_block = this->new_block();
+                this->add_edge(head, 0, then_block);
+                this->seal(then_block);
+                block_ = then_block;
+                this->stmt_sequence(t->children[1]);
+                int then_end = block_;
+                int else_end = head;
+                if (t->children[2] != nullptr) {
+                    int else_block = this->new_block();
+                    this->add_edge(head, 1, else_block);
+                    this->seal(else_block);
+                    block_ = else_block;
+                    this->stmt_sequence(t->children[2]);
+                    else_end = block_;
+                }
+                int join = this->new_block();
+                block_ = then_end;
+                this->emit(SSA_JUMP);
+                this->add_edge(then_end, 0, join);
+                if (else_end != head) {
+                    block_ = else_end;
+                    this->emit(SSA_JUMP);
+                    this->add_edge(else_end, 0, join);
+                } else {
+                    this->add_edge(head, 1, join);
+                }
+                this->seal(join);
+                block_ = join;
+                break;
+            }
+            case StmtRepeat: {
+                this->emit(SSA_JUMP);
+                int body = this->new_block();
+                this->add_edge(block_, 0, body);
+                block_ = body;
+                this->stmt_sequence(t->children[0]);
+                this->emit(SSA_BRANCH, this->expr(t->children[1]));
+                int body_end = block_;
+                int after = this->new_block();
+                // until the condition holds, run the body again
+                this->add_edge(body_end, 0, after);
+                this->add_edge(body_end, 1, body);
+                this->seal(body);
+                this->seal(after);
+                block_ = after;
+                break;
+            }
+            case StmtAssign:
+                this->write_variable(t->slot, block_, this->expr(t->children[0]));
+                break;
+            case StmtRead:
+                this->write_variable(t->slot, block_, this->emit(SSA_READ));
+                break;
+            case StmtWrite:
+                this->emit(SSA_WRITE, this->expr(t->children[0]));
+                break;
+        }
+    }
+}
+
+int SsaBuilder::expr(TreeNode * e) {
+    if (e->expr == ExprConst)
+        return this->emit(SSA_CONST, e->attr.val);
+    if (e->expr == ExprIdentifier)
+        return this->read_variable(e->slot, block_);
+    int l = this->expr(e->children[0]);
+    int r = this->expr(e->children[1]);
+    SsaOp op;
+    switch (e->attr.op) {
+        case TokenType::PLUS:
+            op = SSA_ADD;
+            break;
+        case TokenType::MINUS:
+            op = SSA_SUB;
+            break;
+        case TokenType::TIMES:
+            op = SSA_MUL;
+            break;
+        case TokenType::OVER:
+            op = SSA_DIV;
+            break;
+        case TokenType::LT:
+            op = SSA_LT;
+            break;
+        default:
+            op = SSA_EQ;
+            break;
+    }
+    return this->emit(op, l, r, e->line_no);
+}
+
+void SsaBuilder::write_variable(int var, int block, int value) {
+    defs_[static_cast<uint64_t>(block) << 32 | var] = value;
+}
+
+int SsaBuilder::read_variable(int var, int block) {
+    auto it = defs_.find(static_cast<uint64_t>(block) << 32 | var);
+    if (it != defs_.end())
+        return this->find(it->second);
+    return this->read_variable_recursive(var, block);
+}
+
+int SsaBuilder::read_variable_recursive(int var, int block) {
+    const SsaBlock & b = fn_.blocks_[block];
+    int value;
+    if (!sealed_[block]) {
+        value = this->new_phi(block);
+        incomplete_[block].emplace_back(var, value);
+    } else if (b.preds.size() == 1) {
+        value = this->read_variable(var, b.preds[0]);
+    } else if (b.preds.empty()) {
+        value = this->zero();
+    } else {
+        // break cycles through loops with an operandless phi
+        value = this->new_phi(block);
+        this->write_variable(var, block, value);
+        value = this->add_phi_operands(var, value);
+    }
+    this->write_variable(var, block, value);
+    return value;
+}
+
+int SsaBuilder::new_phi(int block) {
+    int v = fn_.instrs_.size();
+    SsaBlock & b = fn_.blocks_[block];
+    fn_.instrs_.push_back(SsaInstr{SSA_PHI, -1, 0, block, b.phis, 0});
+    replaced_.push_back(-1);
+    b.phis = v;
+    return v;
+}
+
+int SsaBuilder::add_phi_operands(int var, int phi) {
+    std::vector<int32_t> args;
+    for (int32_t pred : fn_.blocks_[fn_.instrs_[phi].block].preds) {
+        args.push_back(this->read_variable(var, pred));
+    }
+    // the reads may have added phis, the arguments of one stay contiguous
+    fn_.instrs_[phi].a = fn_.phi_args_.size();
+    fn_.instrs_[phi].b = args.size();
+    fn_.phi_args_.insert(fn_.phi_args_.end(), args.begin(), args.end());
+    return this->try_remove_trivial_phi(phi);
+}
+
+int SsaBuilder::try_remove_trivial_phi(int phi) {
+    const SsaInstr & p = fn_.instrs_[phi];
+    int same = -1;
+    for (int k = 0; k < p.b; ++k) {
+        int arg = this->find(fn_.phi_args_[p.a + k]);
+        if (arg == same || arg == phi)
+            continue;
+        if (same >= 0)
+            return phi; // merges at least two values
+        same = arg;
+    }
+    if (same < 0)
+        same = this->zero(); // only reached from itself
+    replaced_[phi] = same;
+    return same;
+}
+
+void SsaBuilder::seal(int block) {
+    // completing a phi may read through a loop back into this block
+    for (size_t i = 0; i < incomplete_[block].size(); ++i) {
+        std::pair<int, int> p = incomplete_[block][i];
+        this->add_phi_operands(p.first, p.second);
+    }
+    incomplete_[block].clear();
+    sealed_[block] = 1;
+}
+
+int SsaBuilder::find(int v) {
+    int root = v;
+    while (replaced_[root] >= 0)
+        root = replaced_[root];
+    while (replaced_[v] >= 0) {
+        int next = replaced_[v];
+        replaced_[v] = root;
+        v = next;
+    }
+    return root;
+}
+
+void SsaBuilder::finish() {
+    // a phi becomes trivial when the phis it merges are removed
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (SsaBlock & block : fn_.blocks_) {
+            for (int v = block.phis; v >= 0; v = fn_.instrs_[v].next) {
+                if (replaced_[v] < 0 && this->try_remove_trivial_phi(v) != v)
+                    changed = true;
+            }
+        }
+    }
+    for (SsaBlock & block : fn_.blocks_) {
+        int32_t * link = &block.phis;
+        while (*link >= 0) {
+            SsaInstr & phi = fn_.instrs_[*link];
+            if (replaced_[*link] >= 0) {
+                *link = phi.next;
+                continue;
+            }
+            for (int k = 0; k < phi.b; ++k) {
+                fn_.phi_args_[phi.a + k] = this->find(fn_.phi_args_[phi.a + k]);
+            }
+            link = &phi.next;
+        }
+        for (int v = block.first; v >= 0; v = fn_.instrs_[v].next) {
+            SsaInstr & in = fn_.instrs_[v];
+            if (in.op >= SSA_ADD && in.op <= SSA_EQ) {
+                in.a = this->find(in.a);
+                in.b = this->find(in.b);
+            } else if (in.op == SSA_WRITE || in.op == SSA_BRANCH) {
+                in.a = this->find(in.a);
+            }
+        }
+    }
+    for (int32_t & v : fn_.exit_values_) {
+        v = this->find(v);
+    }
+}
+
+} /* namespace tinylang */
@@ -0,0 +1,150 @@
+/*
+ * ssa.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef SSA_H
+#define SSA_H
+
+#include "parser.h"
+#include <cstdint>
+#include <cstdio>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tinylang {
+
+/**
+ * @brief Operations of the SSA form. A value is the index of the
+ *  instruction defining it; a, b are its operands.
+ */
+enum SsaOp : uint8_t {
+    SSA_CONST,  // the constant a
+    SSA_PHI,    // the arguments phi_args[a, a + b), one per predecessor
+    SSA_ADD,
+    SSA_SUB,
+    SSA_MUL,
+    SSA_DIV,    // fails at line_no if b is zero
+    SSA_LT,
+    SSA_EQ,
+    SSA_READ,
+    // no value from here on
+    SSA_WRITE,  // print a
+    SSA_JUMP,   // to succ[0]
+    SSA_BRANCH, // to succ[0] if a, else to succ[1]
+    SSA_RETURN
+};
+
+//! @brief Fixed-size record of the instruction arena
+struct SsaInstr {
+    SsaOp op;
+    int32_t a;
+    int32_t b;
+    int32_t block;
+    int32_t next;    // in the list of the block, -1 at the end
+    int32_t line_no; // of an SSA_DIV
+};
+
+/**
+ * @brief A basic block: its phis, then its instructions, the last one a
+ *  jump, branch or return. Both are lists threaded through the arena.
+ */
+struct SsaBlock {
+    int32_t phis = -1;
+    int32_t first = -1;
+    int32_t last = -1;
+    int32_t succ[2] = {-1, -1};
+    std::vector<int32_t> preds; // in the order of the phi arguments
+};
+
+/**
+ * @brief A program in SSA form over an explicit control flow graph.
+ *  All instructions live in one arena and all phi arguments in another,
+ *  so building and walking the IR touches few cache lines. Block 0 is the
+ *  entry and has no predecessors.
+ */
+class SsaFunction {
+public:
+    const std::vector<SsaBlock> & blocks() const { return blocks_; }
+    const SsaBlock & block(int b) const { return blocks_[b]; }
+
+    const SsaInstr & instr(int v) const { return instrs_[v]; }
+    //! @brief Size of the arena, including removed instructions
+    size_t arena_size() const { return instrs_.size(); }
+    //! @brief Instructions reachable from the blocks, phis included
+    size_t size() const;
+
+    //! @brief The argument of the phi for its k-th predecessor
+    int32_t phi_arg(const SsaInstr & phi, int k) const { return phi_args_[phi.a + k]; }
+
+    //! @brief Values of the variables by slot when the program returns,
+    //!  if the builder was asked to keep them
+    const std::vector<int32_t> & exit_values() const { return exit_values_; }
+
+    //! @brief Print the instructions, the values renumbered densely
+    void print(FILE * out = stdout) const;
+
+private:
+    friend class SsaBuilder;
+    friend class GlobalValueNumbering;
+
+    std::vector<SsaBlock> blocks_;
+    std::vector<SsaInstr> instrs_;
+    std::vector<int32_t> phi_args_;
+    std::vector<int32_t> exit_values_;
+};
+
+/**
+ * @brief Lower an analysed syntax tree into SSA form on the fly, with the
+ *  algorithm of Braun et al., "Simple and Efficient Construction of Static
+ *  Single Assignment Form" (CC 2013). A block is sealed once all of its
+ *  predecessors are known; reading a variable in an unsealed block makes
+ *  an incomplete phi, completed at sealing. Trivial phis are removed as
+ *  they are found and in a final pass, which leaves minimal SSA on the
+ *  reducible graphs of TINY. Variables are zero before their first
+ *  assignment.
+ */
+class SsaBuilder {
+public:
+    //! @param exit_values keep the variables alive to the return
+    SsaFunction build(TreeNode * tree, size_t slots, bool exit_values = false);
+
+private:
+    int new_block();
+    void add_edge(int from, int slot, int to);
+    int emit(SsaOp op, int32_t a = -1, int32_t b = -1, int32_t line_no = 0);
+    int zero();
+
+    void stmt_sequence(TreeNode * t);
+    int expr(TreeNode * e);
+
+    void write_variable(int var, int block, int value);
+    int read_variable(int var, int block);
+    int read_variable_recursive(int var, int block);
+    //! @brief A phi without arguments at the start of the block
+    int new_phi(int block);
+    int add_phi_operands(int var, int phi);
+    int try_remove_trivial_phi(int phi);
+    void seal(int block);
+
+    //! @brief The value a removed phi stands for
+    int find(int v);
+    //! @brief Drop the removed phis, resolve every operand
+    void finish();
+
+private:
+    SsaFunction fn_;
+    int block_; // being filled
+    int zero_;
+    std::unordered_map<uint64_t, int> defs_; // (block, variable) -> value
+    std::vector<char> sealed_;
+    std::vector<std::vector<std::pair<int, int>>> incomplete_; // (variable, phi)
+    std::vector<int32_t> replaced_; // by value, -1 if not a removed phi
+};
+
+} /* namespace tinylang */
+
+#endif /* !SSA_H */
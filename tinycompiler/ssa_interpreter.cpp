@@ -0,0 +1,100 @@
+/*
+ * ssa_interpreter.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "ssa_interpreter.h"
+#include "interpreter.h"
+
+namespace tinylang {
+
+int SsaInterpreter::run(const SsaFunction & fn) {
+    values_.assign(fn.arena_size(), 0);
+    vars_.clear();
+    steps_ = 0;
+    int from = -1;
+    for (int b = 0; b >= 0;) {
+        const SsaBlock & block = fn.block(b);
+        if (block.phis >= 0) {
+            int k = 0;
+            while (block.preds[k] != from)
+                ++k;
+            // read every argument before writing any phi
+            phi_values_.clear();
+            for (int v = block.phis; v >= 0; v = fn.instr(v).next) {
+                phi_values_.push_back(values_[fn.phi_arg(fn.instr(v), k)]);
+            }
+            size_t i = 0;
+            for (int v = block.phis; v >= 0; v = fn.instr(v).next) {
+                values_[v] = phi_values_[i++];
+                ++steps_;
+            }
+        }
+        from = b;
+        for (int v = block.first; v >= 0; v = fn.instr(v).next) {
+            const SsaInstr & in = fn.instr(v);
+            ++steps_;
+            // wrap around through unsigned arithmetic; a constant is no operand
+            unsigned a = in.op != SSA_CONST && in.a >= 0 ? values_[in.a] : 0;
+            unsigned c = in.b >= 0 ? values_[in.b] : 0;
+            switch (in.op) {
+                case SSA_CONST:
+                    values_[v] = in.a;
+                    break;
+                case SSA_ADD:
+                    values_[v] = a + c;
+                    break;
+                case SSA_SUB:
+                    values_[v] = a - c;
+                    break;
+                case SSA_MUL:
+                    values_[v] = a * c;
+                    break;
+                case SSA_DIV:
+                    if (c == 0) {
+                        report_division_by_zero(in.line_no);
+                        fflush(out_);
+                        return -1;
+                    }
+                    values_[v] = tiny_divide(a, c);
+                    break;
+                case SSA_LT:
+                    values_[v] = static_cast<int>(a) < static_cast<int>(c);
+                    break;
+                case SSA_EQ:
+                    values_[v] = a == c;
+                    break;
+                case SSA_READ: {
+                    int x = 0;
+                    if (fscanf(in_, "%d", &x) != 1)
+                        x = 0;
+                    values_[v] = x;
+                    break;
+                }
+                case SSA_WRITE:
+                    fprintf(out_, "%d\n", static_cast<int>(a));
+                    break;
+                case SSA_JUMP:
+                    b = block.succ[0];
+                    break;
+                case SSA_BRANCH:
+                    b = a ? block.succ[0] : block.succ[1];
+                    break;
+                case SSA_RETURN:
+                    b = -1;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    for (int32_t v : fn.exit_values()) {
+        vars_.push_back(values_[v]);
+    }
+    fflush(out_);
+    return 0;
+}
+
+} /* namespace tinylang */
@@ -0,0 +1,48 @@
+/*
+ * ssa_interpreter.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef SSA_INTERPRETER_H
+#define SSA_INTERPRETER_H
+
+#include "ssa.h"
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace tinylang {
+
+/**
+ * @brief Execute the SSA form directly, to test the IR and the passes over
+ *  it. Every value has a register; entering a block assigns its phis in
+ *  parallel from the arguments of the predecessor left. The semantics are
+ *  those of the Interpreter.
+ */
+class SsaInterpreter {
+public:
+    SsaInterpreter(FILE * in = stdin, FILE * out = stdout) : in_(in), out_(out) {}
+
+    //! @return 0 for success, -1 after a run-time error
+    int run(const SsaFunction & fn);
+
+    //! @brief The exit values of the function after the last run
+    const std::vector<int> & variables() const { return vars_; }
+
+    //! @brief Instructions executed by the last run, phis included
+    uint64_t steps() const { return steps_; }
+
+private:
+    FILE * in_;
+    FILE * out_;
+    std::vector<int> values_;
+    std::vector<int> phi_values_;
+    std::vector<int> vars_;
+    uint64_t steps_ = 0;
+};
+
+} /* namespace tinylang */
+
+#endif /* !SSA_INTERPRETER_H */
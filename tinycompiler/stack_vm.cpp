@@ -0,0 +1,156 @@
+/*
+ * stack_vm.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "stack_vm.h"
+#include "interpreter.h"
+#include "vm_dispatch.h"
+
+#define VM_FETCH() (*pc++)
+
+namespace tinylang {
+
+int StackVM::run(const BytecodeProgram & prog) {
+#ifdef TINY_VM_COMPUTED_GOTO
+    static void * const labels[] = {
+#define TINY_OPCODE_LABEL(op, bytes) &&L_##op,
+        TINY_STACK_OPCODES(TINY_OPCODE_LABEL)
+#undef TINY_OPCODE_LABEL
+    };
+#endif
+    vars_.assign(prog.slots, 0);
+    // one more for the empty top pushed first
+    stack_.assign(prog.max_stack + 1, 0);
+    const uint8_t * code = prog.code.data();
+    const uint8_t * pc = code;
+    int * vars = vars_.data();
+    int * sp = stack_.data(); // above the element under the top
+    int tos = 0;
+    unsigned a;
+
+    VM_SWITCH(VM_FETCH()) {
+        VM_CASE(OP_HALT)
+            fflush(out_);
+            return 0;
+        VM_CASE(OP_CONST)
+            *sp++ = tos;
+            tos = read_imm(pc);
+            pc += 4;
+            VM_NEXT();
+        VM_CASE(OP_LOAD)
+            *sp++ = tos;
+            tos = vars[read_imm(pc)];
+            pc += 4;
+            VM_NEXT();
+        VM_CASE(OP_STORE)
+            vars[read_imm(pc)] = tos;
+            tos = *--sp;
+            pc += 4;
+            VM_NEXT();
+        // wrap around through unsigned arithmetic
+        VM_CASE(OP_ADD)
+            a = *--sp;
+            tos = a + tos;
+            VM_NEXT();
+        VM_CASE(OP_SUB)
+            a = *--sp;
+            tos = a - tos;
+            VM_NEXT();
+        VM_CASE(OP_MUL)
+            a = *--sp;
+            tos = a * tos;
+            VM_NEXT();
+        VM_CASE(OP_DIV)
+            if (tos == 0) {
+                report_division_by_zero(prog.line_of(pc - 1 - code));
+                fflush(out_);
+                return -1;
+            }
+            tos = tiny_divide(*--sp, tos);
+            VM_NEXT();
+        VM_CASE(OP_LT)
+            tos = *--sp < tos;
+            VM_NEXT();
+        VM_CASE(OP_EQ)
+            tos = *--sp == tos;
+            VM_NEXT();
+        VM_CASE(OP_ADDK)
+            tos = static_cast<unsigned>(tos) + read_imm(pc);
+            pc += 4;
+            VM_NEXT();
+        VM_CASE(OP_SUBK)
+            tos = static_cast<unsigned>(tos) - read_imm(pc);
+            pc += 4;
+            VM_NEXT();
+        VM_CASE(OP_MULK)
+            tos = static_cast<unsigned>(tos) * read_imm(pc);
+            pc += 4;
+            VM_NEXT();
+        VM_CASE(OP_DIVK)
+            tos = tiny_divide(tos, read_imm(pc));
+            pc += 4;
+            VM_NEXT();
+        VM_CASE(OP_LTK)
+            tos = tos < read_imm(pc);
+            pc += 4;
+            VM_NEXT();
+        VM_CASE(OP_EQK)
+            tos = tos == read_imm(pc);
+            pc += 4;
+            VM_NEXT();
+        VM_CASE(OP_JUMP)
+            pc = code + read_imm(pc);
+            VM_NEXT();
+        VM_CASE(OP_JUMP_FALSE)
+            a = tos;
+            tos = *--sp;
+            pc = a ? pc + 4 : code + read_imm(pc);
+            VM_NEXT();
+        VM_CASE(OP_JUMP_GE)
+            a = *--sp;
+            pc = static_cast<int>(a) < tos ? pc + 4 : code + read_imm(pc);
+            tos = *--sp;
+            VM_NEXT();
+        VM_CASE(OP_JUMP_NE)
+            a = *--sp;
+            pc = static_cast<int>(a) == tos ? pc + 4 : code + read_imm(pc);
+            tos = *--sp;
+            VM_NEXT();
+        VM_CASE(OP_JUMP_GEK)
+            a = tos;
+            tos = *--sp;
+            pc = static_cast<int>(a) < read_imm(pc) ? pc + 8 : code + read_imm(pc + 4);
+            VM_NEXT();
+        VM_CASE(OP_JUMP_NEK)
+            a = tos;
+            tos = *--sp;
+            pc = static_cast<int>(a) == read_imm(pc) ? pc + 8 : code + read_imm(pc + 4);
+            VM_NEXT();
+        VM_CASE(OP_INCR)
+            vars[read_imm(pc)] += static_cast<unsigned>(read_imm(pc + 4));
+            pc += 8;
+            VM_NEXT();
+        VM_CASE(OP_READ) {
+            int v = 0;
+            if (fscanf(in_, "%d", &v) != 1)
+                v = 0;
+            vars[read_imm(pc)] = v;
+            pc += 4;
+            VM_NEXT();
+        }
+        VM_CASE(OP_WRITE)
+            fprintf(out_, "%d\n", tos);
+            tos = *--sp;
+            VM_NEXT();
+#ifndef TINY_VM_COMPUTED_GOTO
+        default:
+            return -1;
+#endif
+    }
+    return -1;
+}
+
+} /* namespace tinylang */
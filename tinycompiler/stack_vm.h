@@ -0,0 +1,43 @@
+/*
+ * stack_vm.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef STACK_VM_H
+#define STACK_VM_H
+
+#include "bytecode.h"
+#include <cstdio>
+#include <vector>
+
+namespace tinylang {
+
+/**
+ * @brief Virtual machine for the stack bytecode.
+ *  The top of the operand stack lives in a local variable, so most
+ *  instructions touch memory once at most. Dispatch is by computed goto
+ *  where available, see vm_dispatch.h. The semantics are those of the
+ *  Interpreter.
+ */
+class StackVM {
+public:
+    StackVM(FILE * in = stdin, FILE * out = stdout) : in_(in), out_(out) {}
+
+    //! @return 0 for success, -1 after a run-time error
+    int run(const BytecodeProgram & prog);
+
+    //! @brief Values of the variables after the last run, indexed by slot
+    const std::vector<int> & variables() const { return vars_; }
+
+private:
+    FILE * in_;
+    FILE * out_;
+    std::vector<int> vars_;
+    std::vector<int> stack_;
+};
+
+} /* namespace tinylang */
+
+#endif /* !STACK_VM_H */
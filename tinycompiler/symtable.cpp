@@ -11,34 +11,99 @@
 
 namespace tinylang {
 
-void SymTable::insert(const std::string & name, int line_no) {
-    if (records_.find(name) == records_.end()) {
-        auto & record = records_[name];
-        record.name = name;
-        record.lines.push_back(line_no);
-    } else {
-        auto & record = records_[name];
-        record.lines.push_back(line_no);
+void LineList::push_back(int line_no) {
+    int32_t delta = static_cast<int32_t>(static_cast<uint32_t>(line_no) -
+                                         static_cast<uint32_t>(last_));
+    uint32_t zigzag = (static_cast<uint32_t>(delta) << 1) ^
+                      static_cast<uint32_t>(delta >> 31);
+    while (zigzag >= 0x80) {
+        bytes_.push_back(static_cast<unsigned char>(zigzag | 0x80));
+        zigzag >>= 7;
     }
+    bytes_.push_back(static_cast<unsigned char>(zigzag));
+    last_ = line_no;
+    ++count_;
 }
 
-int SymTable::find(const std::string & name) {
-    auto iter = records_.find(name);
-    if (iter == records_.end()) {
+std::vector<int> LineList::to_vector() const {
+    std::vector<int> lines;
+    lines.reserve(count_);
+    this->for_each([&lines](int line_no) { lines.push_back(line_no); });
+    return lines;
+}
+
+uint32_t SymTable::hash(const char * name, size_t len) {
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= static_cast<unsigned char>(name[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+size_t SymTable::probe(const char * name, size_t len, uint32_t h) const {
+    size_t mask = slots_.size() - 1;
+    for (size_t i = h & mask; ; i = (i + 1) & mask) {
+        const Slot & slot = slots_[i];
+        if (slot.id < 0) {
+            return i;
+        }
+        if (slot.hash == h) {
+            const std::string & key = records_[slot.id].name;
+            if (key.size() == len && memcmp(key.data(), name, len) == 0) {
+                return i;
+            }
+        }
+    }
+}
+
+void SymTable::grow() {
+    std::vector<Slot> old_slots(slots_.empty() ? 16 : slots_.size() * 2,
+                                Slot{0, -1});
+    old_slots.swap(slots_);
+    size_t mask = slots_.size() - 1;
+    for (const Slot & slot : old_slots) {
+        if (slot.id < 0)
+            continue;
+        size_t i = slot.hash & mask;
+        while (slots_[i].id >= 0) {
+            i = (i + 1) & mask;
+        }
+        slots_[i] = slot;
+    }
+}
+
+int SymTable::insert(const char * name, size_t len, int line_no) {
+    // keep the load factor under 1/2
+    if ((records_.size() + 1) * 2 > slots_.size()) {
+        this->grow();
+    }
+    uint32_t h = hash(name, len);
+    Slot & slot = slots_[this->probe(name, len, h)];
+    if (slot.id < 0) {
+        slot.hash = h;
+        slot.id = records_.size();
+        records_.emplace_back();
+        records_.back().name.assign(name, len);
+    }
+    records_[slot.id].lines.push_back(line_no);
+    return slot.id;
+}
+
+int SymTable::lookup(const char * name, size_t len) const {
+    if (slots_.empty()) {
         return -1;
     }
-    return 0;
+    return slots_[this->probe(name, len, hash(name, len))].id;
 }
 
-void SymTable::print() {
+void SymTable::print() const {
     printf("SymbolName\tLines\n");
-    std::string buf;
-    for (const auto & p : records_) {
-        for (int i : p.second.lines) {
-            buf += std::to_string(i) + " ";
-        }
-        printf("%-10s\t%s\n", p.second.name.c_str(), buf.c_str());
-        buf.clear();
+    for (const auto & record : records_) {
+        printf("%-10s\t", record.name.c_str());
+        record.lines.for_each([](int i) { printf("%d ", i); });
+        printf("\n");
     }
 }
 
@@ -8,36 +8,129 @@
 #ifndef SYMTABLE_H
 #define SYMTABLE_H
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <string>
-#include <list>
-#include <unordered_map>
+#include <vector>
 
 namespace tinylang {
 
+/**
+ * @brief Compact list of line numbers.
+ *  Each line is stored as the zigzag varint of its delta to the previous
+ *  one, so the usual small forward steps take a single byte.
+ */
+class LineList {
+public:
+    void push_back(int line_no);
+
+    //! @brief Call f(line_no) for every line in insertion order
+    template <class F>
+    void for_each(F f) const {
+        uint32_t line_no = 0; // wraps like the encoder
+        size_t i = 0;
+        while (i < bytes_.size()) {
+            uint32_t zigzag = 0;
+            int shift = 0;
+            unsigned char byte;
+            do {
+                byte = bytes_[i++];
+                zigzag |= static_cast<uint32_t>(byte & 0x7f) << shift;
+                shift += 7;
+            } while (byte & 0x80);
+            line_no += (zigzag >> 1) ^ (0u - (zigzag & 1));
+            f(static_cast<int>(line_no));
+        }
+    }
+
+    std::vector<int> to_vector() const;
+
+    size_t size() const { return count_; }
+
+    //! @brief Encoded size of the lines
+    size_t bytes() const { return bytes_.size(); }
+
+private:
+    std::vector<unsigned char> bytes_;
+    int last_ = 0;
+    size_t count_ = 0;
+};
+
 //! @brief Struct that represents a record in symbol table.
 struct SymRecord {
     std::string name;
-    std::list<int> lines; // record the positions at which the name occur
+    LineList lines; // record the positions at which the name occur
 };
 
+/**
+ * @brief Symbol table keyed by interned symbol id.
+ *  Names are interned into dense ids by an open-addressing hash table;
+ *  the records are stored in an array indexed by id, in the order the
+ *  symbols were first inserted.
+ */
 class SymTable {
 public:
-    void insert(const std::string & name, int line_no);
+    /**
+     * @brief Record an occurrence of the name, with a single probe.
+     *
+     * @return the symbol id
+     */
+    int insert(const char * name, size_t len, int line_no);
 
-    void insert(const char * name, int line_no) {
-        return this->insert(std::string(name), line_no);
+    int insert(const std::string & name, int line_no) {
+        return this->insert(name.c_str(), name.size(), line_no);
     }
 
-    int find(const std::string & name);
+    int insert(const char * name, int line_no) {
+        return this->insert(name, strlen(name), line_no);
+    }
 
-    int find(const char * name) {
-        return this->find(std::string(name));
+    //! @brief Record another occurrence of a known symbol
+    void insert_line(int id, int line_no) {
+        records_[id].lines.push_back(line_no);
     }
 
-    void print();
+    //! @return the symbol id, or -1 if the name is not in the table
+    int lookup(const char * name, size_t len) const;
+
+    int lookup(const char * name) const {
+        return this->lookup(name, strlen(name));
+    }
+
+    //! @return 0 if the name is in the table, -1 otherwise
+    int find(const std::string & name) const {
+        return this->lookup(name.c_str(), name.size()) < 0 ? -1 : 0;
+    }
+
+    int find(const char * name) const {
+        return this->lookup(name) < 0 ? -1 : 0;
+    }
+
+    const SymRecord & record(int id) const { return records_[id]; }
+
+    //! @brief Number of symbols
+    size_t size() const { return records_.size(); }
+
+    void print() const;
+
+    //! @brief FNV-1a hash of the name
+    static uint32_t hash(const char * name, size_t len);
+
+private:
+    struct Slot {
+        uint32_t hash;
+        int id; // -1 for an empty slot
+    };
+
+    //! @brief Index of the slot holding the name, or of the empty slot to use
+    size_t probe(const char * name, size_t len, uint32_t h) const;
+
+    void grow();
 
 private:
-    std::unordered_map<std::string, SymRecord> records_;
+    std::vector<Slot> slots_; // size is zero or a power of two
+    std::vector<SymRecord> records_;
 };
 
 } /* namespace tinylang */
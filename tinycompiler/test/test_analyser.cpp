@@ -0,0 +1,146 @@
+/*
+ * test_analyser.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "catch.hpp"
+
+#include "../analyser.h"
+#include "../ast_visitor.h"
+#include <vector>
+
+using namespace tinylang;
+
+namespace {
+
+class OrderRecorder : public AstVisitor<OrderRecorder> {
+public:
+    int pre_visit(TreeNode * t) {
+        pre.push_back(t->line_no);
+        return 0;
+    }
+
+    int post_visit(TreeNode * t) {
+        post.push_back(t->line_no);
+        return t->node_type == NodeStmt && t->stmt == StmtWrite ? 1 : 0;
+    }
+
+    std::vector<int> pre;
+    std::vector<int> post;
+};
+
+//! @brief Extra pass that sees the types assigned by the built-in passes
+class BoolCounter : public AstVisitor<BoolCounter> {
+public:
+    int post_visit(TreeNode * t) {
+        if (t->node_type == NodeExpr && t->expr_type == ExpBool)
+            ++count;
+        return 0;
+    }
+
+    int count = 0;
+};
+
+} /* namespace */
+
+TEST_CASE( "AstVisitor::walk order", "[Analyser]" ) {
+    Parser parser;
+    std::string input_data;
+    input_data = "read x;\nif x < 1 then\nx := 2\nend;\nwrite x";
+    TreeNode * tree = parser.parse(input_data.c_str(), input_data.size());
+    OrderRecorder recorder;
+    REQUIRE(recorder.walk(tree) == 1);
+    // read, if, <, x, 1, :=, 2, write, x
+    REQUIRE(recorder.pre == std::vector<int>({1, 2, 2, 2, 2, 3, 4, 5, 5}));
+    REQUIRE(recorder.post == std::vector<int>({1, 2, 2, 2, 4, 3, 2, 5, 5}));
+
+    OrderRecorder single;
+    REQUIRE(single.walk_node(tree) == 0);
+    REQUIRE(single.pre.size() == 1);
+}
+
+TEST_CASE( "Analyser::analyse correctness", "[Analyser]" ) {
+    Parser parser;
+    std::string input_data;
+    input_data = "read x; y := x * 2; if y < x then write y end";
+    TreeNode * tree = parser.parse(input_data.c_str(), input_data.size());
+    Analyser analyser;
+    REQUIRE(analyser.analyse(tree) == 0);
+    REQUIRE(tree->neighbor->children[0]->expr_type == ExpInteger);
+    REQUIRE(tree->neighbor->neighbor->children[0]->expr_type == ExpBool);
+
+    input_data = "read x; y := z + x";
+    tree = parser.parse(input_data.c_str(), input_data.size());
+    Analyser undeclared;
+    REQUIRE(undeclared.analyse(tree) != 0);
+
+    input_data = "read x; if x then write x end";
+    tree = parser.parse(input_data.c_str(), input_data.size());
+    Analyser mistyped;
+    REQUIRE(mistyped.analyse(tree) != 0);
+}
+
+TEST_CASE( "Analyser::analyse_with fused passes", "[Analyser]" ) {
+    Parser parser;
+    std::string input_data;
+    input_data = "read x; repeat x := x - 1 until x < 1;\n"
+                 "if x = 0 then write x end";
+    TreeNode * tree = parser.parse(input_data.c_str(), input_data.size());
+    Analyser analyser;
+    BoolCounter counter;
+    OrderRecorder recorder;
+    REQUIRE(analyser.analyse_with(tree, counter, recorder) == -1);
+    REQUIRE(counter.count == 2);
+    REQUIRE(recorder.pre.size() == 15);
+    REQUIRE(recorder.post.size() == 15);
+}
+
+TEST_CASE( "Analyser parallel analysis matches sequential", "[Analyser]" ) {
+    // uses that cross chunk boundaries, undeclared names and type errors
+    std::string input_data = "read v0";
+    for (int i = 1; i < 6000; ++i) {
+        std::string v = "v" + std::to_string(i % 700);
+        std::string prev = "v" + std::to_string((i * 37) % 701);
+        if (i % 97 == 0) {
+            input_data += ";\nif " + v + " then write 1 end";
+        } else if (i % 13 == 0) {
+            input_data += ";\nwrite " + prev + " + " + v;
+        } else {
+            input_data += ";\n" + v + " := " + prev + " * 2";
+        }
+    }
+    Parser parser;
+    TreeNode * tree = parser.parse(input_data.c_str(), input_data.size());
+    REQUIRE(parser.error_count() == 0);
+
+    Analyser sequential;
+    int ret = sequential.analyse(tree);
+    REQUIRE(ret != 0);
+    for (unsigned threads : {2u, 4u}) {
+        Analyser parallel;
+        parallel.set_threads(threads);
+        REQUIRE(parallel.analyse(tree) == ret);
+        REQUIRE(parallel.diagnostics() == sequential.diagnostics());
+        REQUIRE(parallel.symtable().size() == sequential.symtable().size());
+        for (size_t id = 0; id < sequential.symtable().size(); ++id) {
+            const SymRecord & expected = sequential.symtable().record(id);
+            const SymRecord & actual = parallel.symtable().record(id);
+            REQUIRE(actual.name == expected.name);
+            REQUIRE(actual.lines.to_vector() == expected.lines.to_vector());
+        }
+    }
+}
+
+TEST_CASE( "Analyser diagnostics keep long identifiers", "[Analyser]" ) {
+    std::string name(300, 'a');
+    std::string input_data = "write " + name;
+    Parser parser;
+    TreeNode * tree = parser.parse(input_data.c_str(), input_data.size());
+    Analyser analyser;
+    REQUIRE(analyser.analyse(tree) != 0);
+    REQUIRE(analyser.diagnostics().size() == 1);
+    REQUIRE(analyser.diagnostics()[0] ==
+            "file:1: error: use of undeclared identifier '" + name + "'\n");
+}
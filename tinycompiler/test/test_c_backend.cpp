@@ -0,0 +1,95 @@
+/*
+ * test_c_backend.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "catch.hpp"
+#include "test_helpers.h"
+
+#include "../analyser.h"
+#include "../c_backend.h"
+#include "../range_analysis.h"
+#include <cstdlib>
+#include <string>
+
+using namespace tinylang;
+
+namespace {
+
+bool have_cc() {
+    static int found = system("cc --version > /dev/null 2>&1");
+    return found == 0;
+}
+
+//! @brief Build the emitted C with cc -O2 into the executable
+int build_c(const TestProgram & program, const std::string & path) {
+    const std::string c_path = "tiny_test_c_backend.c";
+    FILE * c_file = fopen(c_path.c_str(), "w");
+    REQUIRE(c_file != nullptr);
+    CEmitter emitter(c_file);
+    emitter.emit(program.tree, program.analyser.symtable());
+    fclose(c_file);
+    std::string cmd = "cc -O2 -Wall -Werror -o " + path + " " + c_path;
+    int ret = system(cmd.c_str());
+    remove(c_path.c_str());
+    return ret;
+}
+
+//! @brief build_c() after the range analysis flagged the safe operations
+int build_ranged_c(const TestProgram & program, const std::string & path) {
+    RangeAnalysis ranges;
+    ranges.run(program.tree);
+    return build_c(program, path);
+}
+
+} /* namespace */
+
+TEST_CASE( "Emitted C matches the interpreter", "[CEmitter]" ) {
+    if (!have_cc()) {
+        WARN("no C compiler, skipped");
+        return;
+    }
+    check_executable(build_c);
+    // names that are C keywords or library functions
+    check_executable("read int; printf := int * 2; write printf; main := 1; write main", "21",
+                     build_c);
+    check_executable("write 2147483648", "", build_c);
+    check_executable(build_ranged_c);
+}
+
+TEST_CASE( "Emitted C structure", "[CEmitter]" ) {
+    Parser parser;
+    std::string input_data = "read n; repeat n := n - 1 until n < 1";
+    TreeNode * tree = parser.parse(input_data.c_str(), input_data.size());
+    Analyser analyser;
+    REQUIRE(analyser.analyse(tree) == 0);
+    FILE * out = tmpfile();
+    CEmitter emitter(out);
+    emitter.emit(tree, analyser.symtable());
+    std::string c = read_all(out);
+    fclose(out);
+    REQUIRE(c.find("    int v_n = 0;\n") != std::string::npos);
+    REQUIRE(c.find("    v_n = tiny_read();\n"
+                   "    do {\n"
+                   "        v_n = tiny_sub(v_n, 1);\n"
+                   "    } while (!(v_n < 1));\n") != std::string::npos);
+}
+
+TEST_CASE( "Emitted C uses plain operators where they are safe", "[CEmitter]" ) {
+    Parser parser;
+    std::string input_data = "read a; b := 4; write a / b + 1; write b / a";
+    TreeNode * tree = parser.parse(input_data.c_str(), input_data.size());
+    Analyser analyser;
+    REQUIRE(analyser.analyse(tree) == 0);
+    RangeAnalysis ranges;
+    ranges.run(tree);
+    FILE * out = tmpfile();
+    CEmitter emitter(out);
+    emitter.emit(tree, analyser.symtable());
+    std::string c = read_all(out);
+    fclose(out);
+    REQUIRE(c.find("    printf(\"%d\\n\", ((v_a / v_b) + 1));\n") != std::string::npos);
+    REQUIRE(c.find("    printf(\"%d\\n\", tiny_div(v_b, v_a, 1));\n") != std::string::npos);
+}
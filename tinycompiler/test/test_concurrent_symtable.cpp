@@ -0,0 +1,86 @@
+/*
+ * test_concurrent_symtable.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "catch.hpp"
+
+#include "../concurrent_symtable.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace tinylang;
+
+TEST_CASE( "ConcurrentSymTable::insert and lookup", "[ConcurrentSymTable]" ) {
+    ConcurrentSymTable st(4);
+    REQUIRE(st.lookup("a") == nullptr);
+    ConcurrentSymTable::Symbol * a = st.insert("a", 1);
+    REQUIRE(a != nullptr);
+    REQUIRE(st.insert("bb", 2) != a);
+    REQUIRE(st.insert("a", 3) == a);
+    ConcurrentSymTable::insert_line(a, 2);
+    REQUIRE(st.lookup("a") == a);
+    REQUIRE(st.lookup("b") == nullptr);
+    REQUIRE(st.size() == 2);
+    REQUIRE(a->occurrences == 3);
+    REQUIRE(a->sorted_lines() == std::vector<int>({1, 2, 3}));
+
+    // a full table refuses new names but still finds the old ones
+    ConcurrentSymTable small(1);
+    int inserted = 0;
+    for (int i = 0; i < 100; ++i) {
+        if (small.insert(("n" + std::to_string(i)).c_str(), i) != nullptr)
+            ++inserted;
+    }
+    REQUIRE(inserted == static_cast<int>(small.size()));
+    REQUIRE(inserted < 100);
+    REQUIRE(small.lookup("n0") != nullptr);
+}
+
+TEST_CASE( "ConcurrentSymTable stress", "[ConcurrentSymTable]" ) {
+    const int threads = 8, names = 1000, rounds = 20;
+    ConcurrentSymTable st(names);
+    std::vector<std::string> keys;
+    for (int k = 0; k < names; ++k) {
+        keys.push_back("v" + std::to_string(k));
+    }
+    std::vector<int> missing(threads, 0);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t]() {
+            for (int r = 0; r < rounds; ++r) {
+                // every thread walks the names from a different start
+                for (int j = 0; j < names; ++j) {
+                    int k = (j + t * 131) % names;
+                    int line_no = (t * rounds + r) * names + k;
+                    st.insert(keys[k].c_str(), keys[k].size(), line_no);
+                    if (st.lookup(keys[(k + 1) % names].c_str()) == nullptr)
+                        ++missing[t];
+                }
+            }
+        });
+    }
+    for (std::thread & th : pool) {
+        th.join();
+    }
+    REQUIRE(st.size() == static_cast<size_t>(names));
+    size_t symbols = 0;
+    st.for_each([&](const ConcurrentSymTable::Symbol & sym) {
+        ++symbols;
+        REQUIRE(sym.occurrences == static_cast<size_t>(threads * rounds));
+        int k = std::stoi(sym.name.substr(1));
+        std::vector<int> expected;
+        for (int i = 0; i < threads * rounds; ++i) {
+            expected.push_back(i * names + k);
+        }
+        REQUIRE(sym.sorted_lines() == expected);
+    });
+    REQUIRE(symbols == static_cast<size_t>(names));
+    // a name looked up after it was inserted is always found
+    for (const std::string & key : keys) {
+        REQUIRE(st.lookup(key.c_str()) != nullptr);
+    }
+}
@@ -0,0 +1,148 @@
+/*
+ * test_constant_folding.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "catch.hpp"
+#include "test_helpers.h"
+
+#include "../analyser.h"
+#include "../constant_folding.h"
+#include "../interpreter.h"
+#include "../jit.h"
+#include "../register_vm.h"
+#include "../stack_vm.h"
+#include <string>
+
+using namespace tinylang;
+
+namespace {
+
+//! @brief Run the tree on one of the engines, the JIT only where supported
+int run_engine(TreeNode * tree, size_t slots, int engine, FILE * in, FILE * out,
+               std::vector<int> * vars) {
+    int ret = 0;
+    switch (engine) {
+        case 0: {
+            Interpreter interpreter(in, out);
+            ret = interpreter.run(tree, slots);
+            *vars = interpreter.variables();
+            break;
+        }
+        case 1: {
+            BytecodeCompiler compiler;
+            StackVM vm(in, out);
+            ret = vm.run(compiler.compile(tree, slots));
+            *vars = vm.variables();
+            break;
+        }
+        case 2: {
+            RegisterCompiler compiler;
+            RegisterVM vm(in, out);
+            ret = vm.run(compiler.compile(tree, slots));
+            *vars = vm.variables();
+            break;
+        }
+        default: {
+#ifdef TINY_JIT_SUPPORTED
+            JitCompiler compiler;
+            JitProgram prog = compiler.compile(tree, slots);
+            ret = prog.run(in, out);
+            *vars = prog.variables();
+#else
+            Interpreter interpreter(in, out);
+            ret = interpreter.run(tree, slots);
+            *vars = interpreter.variables();
+#endif
+            break;
+        }
+    }
+    return ret;
+}
+
+//! @brief Fold the constants of the program, then run it on an engine
+struct FoldedRun {
+    int operator()(const TestProgram & program, FILE * in, FILE * out,
+                   std::vector<int> * vars) const {
+        ConstantFolder folder;
+        TreeNode * tree = folder.run(program.tree);
+        return run_engine(tree, program.slots, engine, in, out, vars);
+    }
+
+    int engine;
+};
+
+const EngineCase FOLDING_CASES[] = {
+    {"read x; y := x * (3 - 2) + (4 - 4); write y; write (2 * 3) * x", "7"},
+    {"read x; write 0 * (10 / x); write (x - x) * (1 / 0)", "0"},
+    {"x := 2147483647 + 1; write x / (0 - 1); write (0 - 7) / 2", ""},
+    {"read x; if 2 < 1 then write 1 end; "
+     "repeat if x = x then x := x - 1 end until 1 = 1; write x", "5"},
+    // sequences that become empty
+    {"if 1 < 0 then write 1 end", ""},
+    {"read x; if x < 3 then if 1 = 0 then write 1 end else write 2 end; "
+     "repeat if 0 = 1 then write 3 end; x := x + 1 until 9 < x", "1"},
+};
+
+} /* namespace */
+
+TEST_CASE( "ConstantFolder folds expressions", "[ConstantFolder]" ) {
+    Parser parser;
+    std::string input_data = "x := (186 - 23) / 2; y := x * 1 + 0; z := (x - x) * y; "
+                             "w := 0 * (y / x); v := 7 / 0; u := (0 - 2147483647) - 1";
+    TreeNode * tree = parser.parse(input_data.c_str(), input_data.size());
+    Analyser analyser;
+    REQUIRE(analyser.analyse(tree) == 0);
+    ConstantFolder folder;
+    tree = folder.run(tree);
+    TreeNode * x = tree->children[0];
+    REQUIRE(x->expr == ExprConst);
+    REQUIRE(x->attr.val == 81);
+    TreeNode * y = tree->neighbor->children[0];
+    REQUIRE(y->expr == ExprIdentifier);
+    REQUIRE(y->slot == tree->slot);
+    TreeNode * z = tree->neighbor->neighbor->children[0];
+    REQUIRE(z->expr == ExprConst);
+    REQUIRE(z->attr.val == 0);
+    // y / x may fail, a division by the constant zero too
+    TreeNode * w = tree->neighbor->neighbor->neighbor;
+    REQUIRE(w->children[0]->expr == ExprOp);
+    REQUIRE(w->neighbor->children[0]->expr == ExprOp);
+    TreeNode * u = w->neighbor->neighbor->children[0];
+    REQUIRE(u->expr == ExprConst);
+    REQUIRE(u->attr.val == INT32_MIN);
+    REQUIRE(folder.removed() == 4 + 4 + 4 + 4);
+}
+
+TEST_CASE( "ConstantFolder folds conditions", "[ConstantFolder]" ) {
+    Parser parser;
+    std::string input_data = "read a; if 1 < 2 then write a else write 0 end; "
+                             "repeat a := a - 1 until 0 = 0; "
+                             "if a < a then write 1 end; if 3 = 4 then write 2 end";
+    TreeNode * tree = parser.parse(input_data.c_str(), input_data.size());
+    Analyser analyser;
+    REQUIRE(analyser.analyse(tree) == 0);
+    ConstantFolder folder;
+    tree = folder.run(tree);
+    REQUIRE(tree->stmt == StmtRead);
+    REQUIRE(tree->neighbor->stmt == StmtWrite);
+    REQUIRE(tree->neighbor->children[0]->expr == ExprIdentifier);
+    REQUIRE(tree->neighbor->neighbor->stmt == StmtAssign);
+    REQUIRE(tree->neighbor->neighbor->neighbor == nullptr);
+    // if: 1 + 3 + 2, repeat: 1 + 3, the two ifs: 6 each
+    REQUIRE(folder.removed() == 6 + 4 + 6 + 6);
+
+    input_data = "if 1 < 0 then x := 1 end";
+    tree = parser.parse(input_data.c_str(), input_data.size());
+    REQUIRE(analyser.analyse(tree) == 0);
+    REQUIRE(folder.run(tree) == nullptr);
+}
+
+TEST_CASE( "Folded programs behave the same", "[ConstantFolder]" ) {
+    for (int engine = 0; engine < 4; ++engine) {
+        check_engine(FoldedRun{engine});
+        check_engine(FOLDING_CASES, FoldedRun{engine});
+    }
+}
@@ -0,0 +1,110 @@
+/*
+ * test_dataflow.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "catch.hpp"
+
+#include "../cfg.h"
+#include "../dataflow.h"
+#include "../definite_assignment.h"
+#include <string>
+
+using namespace tinylang;
+
+TEST_CASE( "BitSet operations", "[Dataflow]" ) {
+    BitSet a(130), b(130, true);
+    REQUIRE(a.count() == 0);
+    REQUIRE(b.count() == 130);
+    a.set(0);
+    a.set(64);
+    a.set(129);
+    REQUIRE(a.test(64));
+    REQUIRE_FALSE(a.test(63));
+    REQUIRE_FALSE(b.intersect_with(BitSet(130, true)));
+    REQUIRE(b.intersect_with(a));
+    REQUIRE(b == a);
+    a.reset(64);
+    REQUIRE(a.count() == 2);
+    REQUIRE(a.union_with(b));
+    REQUIRE_FALSE(a.union_with(b));
+    a.fill(true);
+    REQUIRE(a == BitSet(130, true));
+}
+
+TEST_CASE( "ControlFlowGraph shape", "[Dataflow]" ) {
+    Parser parser;
+    std::string input_data = "read x;\n"
+                             "if x < 1 then x := 1 else x := 2 end;\n"
+                             "repeat x := x - 1 until x < 0;\n"
+                             "write x";
+    ControlFlowGraph cfg(parser.parse(input_data.c_str(), input_data.size()));
+    // entry, then, else, join, body, after
+    REQUIRE(cfg.size() == 6);
+    const BasicBlock & entry = cfg.block(cfg.entry());
+    REQUIRE(entry.stmts.size() == 1);
+    REQUIRE(entry.cond != nullptr);
+    REQUIRE(cfg.block(entry.succ[0]).succ[0] == cfg.block(entry.succ[1]).succ[0]);
+    const BasicBlock & body = cfg.block(4);
+    REQUIRE(body.succ[1] == 4);
+    REQUIRE(body.preds.size() == 2);
+    REQUIRE(cfg.exit() == 5);
+    REQUIRE(cfg.block(cfg.exit()).stmts.size() == 1);
+    REQUIRE(cfg.reverse_postorder().front() == cfg.entry());
+    REQUIRE(cfg.reverse_postorder().back() == cfg.exit());
+}
+
+TEST_CASE( "solve_dataflow backward union", "[Dataflow]" ) {
+    // liveness of a single variable around a loop
+    Parser parser;
+    std::string input_data = "read x; repeat write x; y := 1 until y < 1; write 2";
+    ControlFlowGraph cfg(parser.parse(input_data.c_str(), input_data.size()));
+    REQUIRE(cfg.size() == 3);
+    BitVectorProblem problem;
+    problem.direction = DataflowBackward;
+    problem.meet = MeetUnion;
+    problem.bits = 1;
+    problem.gen = {{}, {0}, {}};
+    problem.kill = {{0}, {}, {}};
+    problem.boundary = BitSet(1);
+    DataflowResult result = solve_dataflow(cfg, problem);
+    REQUIRE_FALSE(result.out[0].test(0));
+    REQUIRE(result.in[0].test(0));
+    REQUIRE(result.in[1].test(0));
+    REQUIRE_FALSE(result.in[2].test(0));
+}
+
+TEST_CASE( "DefiniteAssignment correctness", "[Dataflow]" ) {
+    Parser parser;
+    DefiniteAssignment checker;
+    std::string input_data = "read c;\nif c < 1 then x := 1 end;\nwrite x";
+    REQUIRE(checker.check(parser.parse(input_data.c_str(), input_data.size())) != 0);
+    REQUIRE(checker.diagnostics().size() == 1);
+    REQUIRE(checker.diagnostics()[0] ==
+            "file:3: error: 'x' may be used before it is assigned\n");
+
+    input_data = "read c;\nif c < 1 then x := 1 else read x end;\nwrite x";
+    REQUIRE(checker.check(parser.parse(input_data.c_str(), input_data.size())) == 0);
+
+    // a repeat body runs at least once
+    input_data = "read c; repeat x := c; c := c - 1 until x < 0; write x";
+    REQUIRE(checker.check(parser.parse(input_data.c_str(), input_data.size())) == 0);
+
+    Parser loop_parser;
+    input_data = "read c;\nrepeat\nwrite y;\ny := 1\nuntil c < y;\nx := x";
+    REQUIRE(checker.check(loop_parser.parse(input_data.c_str(), input_data.size())) != 0);
+    REQUIRE(checker.diagnostics().size() == 2);
+    REQUIRE(checker.diagnostics()[0] ==
+            "file:3: error: 'y' may be used before it is assigned\n");
+    REQUIRE(checker.variables() == 3);
+
+    // long names are not cut off
+    Parser long_parser;
+    std::string name(300, 'v');
+    input_data = "write " + name;
+    REQUIRE(checker.check(long_parser.parse(input_data.c_str(), input_data.size())) != 0);
+    REQUIRE(checker.diagnostics()[0] ==
+            "file:1: error: '" + name + "' may be used before it is assigned\n");
+}
@@ -0,0 +1,73 @@
+/*
+ * test_driver.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "catch.hpp"
+#include "test_helpers.h"
+
+#include <string>
+
+namespace {
+
+//! @brief Run tiny with the options on the source, written to a file
+ExecResult run_tiny(const std::string & options, const std::string & source,
+                    const std::string & input = "") {
+    const std::string path = "tiny_test_driver.tny";
+    FILE * fp = fopen(path.c_str(), "w");
+    REQUIRE(fp != nullptr);
+    fputs(source.c_str(), fp);
+    fclose(fp);
+    ExecResult result = run_executable(std::string(TINY_BINARY) + " " + options + " " + path,
+                                       input);
+    remove(path.c_str());
+    return result;
+}
+
+} /* namespace */
+
+TEST_CASE( "tiny analyses with several threads", "[Driver]" ) {
+    // enough statements for the chunked analysis, with errors in several chunks
+    std::string source = "read v0";
+    for (int i = 1; i < 6000; ++i) {
+        source += ";\nv" + std::to_string(i % 500) + " := v" + std::to_string(i * 7 % 500) +
+                  " + 1";
+    }
+    source += ";\nwrite v3";
+    ExecResult sequential = run_tiny("", source, "1");
+    ExecResult parallel = run_tiny("-j 4", source, "1");
+    REQUIRE(sequential.status == 255);
+    REQUIRE(parallel.status == sequential.status);
+    REQUIRE(parallel.output == sequential.output);
+    REQUIRE(parallel.output.find("use of undeclared identifier") != std::string::npos);
+
+    REQUIRE(run_tiny("-j 0", FACT_SOURCE, "5").output == "120\n");
+    REQUIRE(run_tiny("-j", FACT_SOURCE).status == 255);
+}
+
+TEST_CASE( "tiny checks definite assignment", "[Driver]" ) {
+    std::string source = "read c;\nif c < 1 then x := 1 end;\nwrite x";
+    ExecResult checked = run_tiny("--check-assigned", source, "5");
+    REQUIRE(checked.status == 255);
+    REQUIRE(checked.output == "file:3: error: 'x' may be used before it is assigned\n");
+    // without the check x starts at 0
+    REQUIRE(run_tiny("", source, "5").output == "0\n");
+
+    ExecResult fine = run_tiny("--check-assigned", FACT_SOURCE, "4");
+    REQUIRE(fine.status == 0);
+    REQUIRE(fine.output == "24\n");
+}
+
+TEST_CASE( "tiny drops the checks the range analysis proved", "[Driver]" ) {
+    std::string source = "read a; b := 4; write a / b; write b / a";
+    std::string c = run_tiny("--emit-c", source).output;
+    REQUIRE(c.find("printf(\"%d\\n\", (v_a / v_b));") != std::string::npos);
+    REQUIRE(c.find("printf(\"%d\\n\", tiny_div(v_b, v_a, 1));") != std::string::npos);
+
+    ExecResult run = run_tiny("", source, "0");
+    REQUIRE(run.output == "0\n");
+    REQUIRE(run.err == "file:1: runtime error: division by zero\n");
+    REQUIRE(run.status == 255);
+}
@@ -0,0 +1,73 @@
+/*
+ * test_elf.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "catch.hpp"
+#include "test_helpers.h"
+
+#include "../analyser.h"
+#include "../elf_writer.h"
+#include <cstring>
+#include <string>
+
+using namespace tinylang;
+
+#if defined(__x86_64__) && defined(__linux__)
+
+namespace {
+
+//! @brief Write the program as a static executable
+int build_elf(const TestProgram & program, const std::string & path) {
+    ElfWriter writer;
+    writer.build(program.tree, program.slots);
+    return writer.write(path.c_str());
+}
+
+} /* namespace */
+
+TEST_CASE( "ELF executable matches the interpreter", "[ElfWriter]" ) {
+    check_executable(build_elf);
+
+    // more input and output than the buffers of the runtime hold
+    std::string numbers;
+    for (int i = 0; i < 3000; ++i) {
+        numbers += std::to_string(i * 7919 - 1000000) + (i % 10 == 9 ? "\n" : " ");
+    }
+    check_executable("n := 3000; repeat read x; write x * 3; write 0 - x; n := n - 1 "
+                     "until n = 0",
+                     numbers, build_elf);
+}
+
+#endif
+
+TEST_CASE( "ELF image layout", "[ElfWriter]" ) {
+    Parser parser;
+    std::string input_data = "read n; write n * 2";
+    TreeNode * tree = parser.parse(input_data.c_str(), input_data.size());
+    Analyser analyser;
+    REQUIRE(analyser.analyse(tree) == 0);
+    ElfWriter writer;
+    const std::vector<uint8_t> & image = writer.build(tree, analyser.symtable().size());
+    REQUIRE(image.size() > 64 + 2 * 56);
+    REQUIRE(memcmp(image.data(), "\x7f" "ELF\x02\x01\x01", 7) == 0);
+    uint16_t type, machine, phnum;
+    uint64_t entry;
+    memcpy(&type, &image[16], sizeof(type));
+    memcpy(&machine, &image[18], sizeof(machine));
+    memcpy(&entry, &image[24], sizeof(entry));
+    memcpy(&phnum, &image[56], sizeof(phnum));
+    REQUIRE(type == 2);
+    REQUIRE(machine == 0x3e);
+    REQUIRE(phnum == 2);
+    // _start is the first code after the headers
+    REQUIRE(entry == 0x400000 + 64 + 2 * 56);
+    // the data segment is not part of the file
+    uint64_t data_filesz, data_memsz;
+    memcpy(&data_filesz, &image[64 + 56 + 32], sizeof(data_filesz));
+    memcpy(&data_memsz, &image[64 + 56 + 40], sizeof(data_memsz));
+    REQUIRE(data_filesz == 0);
+    REQUIRE(data_memsz > 2 * 4096);
+}
@@ -0,0 +1,161 @@
+/*
+ * test_gvn.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "catch.hpp"
+#include "test_helpers.h"
+
+#include "../analyser.h"
+#include "../gvn.h"
+#include "../ssa_interpreter.h"
+#include <string>
+
+using namespace tinylang;
+
+namespace {
+
+SsaFunction build(const std::string & source, bool exit_values = false) {
+    TestProgram program(source);
+    SsaBuilder builder;
+    return builder.build(program.tree, program.slots, exit_values);
+}
+
+std::string dump(const SsaFunction & fn) {
+    FILE * out = tmpfile();
+    fn.print(out);
+    std::string result = read_all(out);
+    fclose(out);
+    return result;
+}
+
+//! @brief Run the numbered SSA form, expect it to execute no more
+//!  instructions than before the numbering
+int run_gvn(const TestProgram & program, FILE * in, FILE * out, std::vector<int> * vars) {
+    SsaBuilder builder;
+    SsaFunction fn = builder.build(program.tree, program.slots, true);
+    FILE * before_out = tmpfile();
+    SsaInterpreter before(in, before_out);
+    before.run(fn);
+    fclose(before_out);
+
+    GlobalValueNumbering gvn;
+    gvn.run(&fn);
+    rewind(in);
+    SsaInterpreter after(in, out);
+    int ret = after.run(fn);
+    if (ret == 0) {
+        *vars = after.variables();
+    }
+    REQUIRE(after.steps() <= before.steps());
+    return ret;
+}
+
+} /* namespace */
+
+TEST_CASE( "Dominator tree", "[GVN]" ) {
+    SsaFunction fn = build("read x;\n"
+                           "if 0 < x then\n"
+                           "  repeat x := x - 1 until x = 0;\n"
+                           "  write x\n"
+                           "else write 1 end");
+    // 0: head, 1: then, 2: loop, 3: after the loop, 4: else, 5: join
+    DominatorTree dom(fn);
+    REQUIRE(dom.idom(0) == -1);
+    REQUIRE(dom.idom(1) == 0);
+    REQUIRE(dom.idom(2) == 1);
+    REQUIRE(dom.idom(3) == 2);
+    REQUIRE(dom.idom(4) == 0);
+    REQUIRE(dom.idom(5) == 0);
+    REQUIRE(dom.dominates(1, 3));
+    REQUIRE(!dom.dominates(1, 5));
+    REQUIRE(!dom.dominates(4, 5));
+    REQUIRE(dom.children(0).size() == 3);
+}
+
+TEST_CASE( "GVN eliminates dominated recomputations", "[GVN]" ) {
+    SsaFunction fn = build("read a; read b; x := a + b; y := b + a; write x * y;\n"
+                           "if a < b then write (a + b) / 2 else write a - b end;\n"
+                           "write (b + a) / 2");
+    GlobalValueNumbering gvn;
+    gvn.run(&fn);
+    // y, the a + b of the then branch and the b + a after the join, but
+    // not the const 2 of the branch, which does not dominate the join
+    REQUIRE(dump(fn) ==
+            "b0:\n"
+            "  v0 = read\n"
+            "  v1 = read\n"
+            "  v2 = add v0, v1\n"
+            "  v3 = mul v2, v2\n"
+            "  write v3\n"
+            "  v4 = lt v0, v1\n"
+            "  branch v4, b1, b2\n"
+            "b1: <- b0\n"
+            "  v5 = const 2\n"
+            "  v6 = div v2, v5\n"
+            "  write v6\n"
+            "  jump b3\n"
+            "b2: <- b0\n"
+            "  v7 = sub v0, v1\n"
+            "  write v7\n"
+            "  jump b3\n"
+            "b3: <- b1, b2\n"
+            "  v8 = const 2\n"
+            "  v9 = div v2, v8\n"
+            "  write v9\n"
+            "  return\n");
+    REQUIRE(gvn.removed() == 3);
+
+    // x and y are merged by phis of the same arguments
+    fn = build("read a; if a < 1 then x := 1; y := 1 else x := 2; y := 2 end;\n"
+               "write x - y");
+    gvn.run(&fn);
+    std::string ir = dump(fn);
+    REQUIRE(ir.find("phi") != std::string::npos);
+    REQUIRE(ir.find("phi") == ir.rfind("phi"));
+    REQUIRE(ir.find("sub v4, v4") != std::string::npos);
+}
+
+TEST_CASE( "GVN in loops", "[GVN]" ) {
+    SsaFunction fn = build("i := 0; j := 0; repeat i := i + 1; j := j + 1 until 9 < i;\n"
+                           "write i - j");
+    GlobalValueNumbering gvn;
+    gvn.run(&fn);
+    // the constants are merged; i and j always hold the same value, but the
+    // phis see unnumbered values along the back edge and stay apart
+    REQUIRE(dump(fn) ==
+            "b0:\n"
+            "  v0 = const 0\n"
+            "  jump b1\n"
+            "b1: <- b0, b1\n"
+            "  v1 = phi [v0, b0], [v5, b1]\n"
+            "  v2 = phi [v0, b0], [v4, b1]\n"
+            "  v3 = const 1\n"
+            "  v4 = add v2, v3\n"
+            "  v5 = add v1, v3\n"
+            "  v6 = const 9\n"
+            "  v7 = lt v6, v4\n"
+            "  branch v7, b2, b1\n"
+            "b2: <- b1\n"
+            "  v8 = sub v4, v5\n"
+            "  write v8\n"
+            "  return\n");
+    REQUIRE(gvn.removed() == 2);
+}
+
+TEST_CASE( "Numbered SSA form matches the interpreter", "[GVN]" ) {
+    check_engine(run_gvn);
+    // the same product on both branches and after the join
+    check_engine("read a; read b; if a < b then x := a * b else x := a * b + 1 end;\n"
+                 "write a * b; write x", "3 4", run_gvn);
+    // redundant expressions inside nested loops
+    check_engine("read n; i := 0;\n"
+                 "repeat\n"
+                 "  j := 0; repeat s := s + i * 3; j := j + 1 until 3 < j;\n"
+                 "  i := i + 1; k := i * 3 + 1; m := 1 + 3 * i\n"
+                 "until n < i + 1;\n"
+                 "write s; write k - m",
+                 "20", run_gvn);
+}
@@ -0,0 +1,244 @@
+/*
+ * test_helpers.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef TEST_HELPERS_H
+#define TEST_HELPERS_H
+
+#include "catch.hpp"
+
+#include "../analyser.h"
+#include "../interpreter.h"
+#include <cstdio>
+#include <string>
+#include <sys/wait.h>
+#include <vector>
+
+//! @brief Factorial of the input, the program every engine test starts with
+static const char FACT_SOURCE[] =
+    "read x;\n"
+    "if 0 < x then\n"
+    "  fact := 1;\n"
+    "  repeat fact := fact * x; x := x - 1 until x = 0;\n"
+    "  write fact\n"
+    "end";
+
+//! @brief Source of a program and the input it runs on
+struct EngineCase {
+    const char * source;
+    const char * input;
+};
+
+/**
+ * @brief Programs every engine runs against the interpreter: the end of
+ *  the input, division by zero after some output, 32-bit wrapping, nested
+ *  control flow, values swapped through temporaries and loops carrying
+ *  several variables.
+ */
+static const EngineCase ENGINE_CASES[] = {
+    {FACT_SOURCE, "5"},
+    {FACT_SOURCE, "0"},
+    {FACT_SOURCE, "-1"},
+    {"read a; read b; write a / b; write (a - b) * (a + b); write b / 0 - 1", "-7 2"},
+    {"read a; read b; write a / b; write 7 / b; write a / (b - 3)", "9 3"},
+    {"read a; read b; write b / a; write a / b", "0 3"},
+    {"x := 2147483647 + 1; write x / (0 - 1); write x * x; write x / 3; y := x - 1; "
+     "z := 0 - 1; write x / z; write x * z; write y",
+     ""},
+    // a - b overflows in these comparisons
+    {"read a; read b; if a < b then write 1 else write 0 end;"
+     "if b < a then write 1 else write 0 end",
+     "-2147483648 2147483647"},
+    {"read a; if a < 3 then if a = 1 then write 1 else write 2 end "
+     "else repeat a := a - 1; write a until a < 5 end",
+     "9"},
+    {"if 1 < 2 then if 2 < 1 then x := 1 else x := 2 end end; write x", ""},
+    // the destination of an assignment is also an operand
+    {"read a; read b; a := (a + b) * (a - b); b := b / (a - 1); "
+     "c := a; a := b; b := c; write a; write b",
+     "9 4"},
+    {"read a; repeat b := a; a := b; c := c + 1 until 3 < c; write a + c", "4"},
+    {"read n; a := 0; b := 1; i := 0;\n"
+     "repeat\n"
+     "  t := a; a := b; b := t + b;\n"
+     "  j := 0; repeat if j < 2 then s := s + a else s := s - 1 end; j := j + 1"
+     "  until 3 < j;\n"
+     "  i := i + 1\n"
+     "until n < i + 1;\n"
+     "write a; write b; write s",
+     "20"},
+    // signs, whitespace, a bad number and the end of the input
+    {"read a; read b; read c; read d; write a; write b; write c; write d",
+     " +12\t\n-0034\r\n 7"},
+    {"read a; read b; write a; write b", "12x 5"},
+};
+
+//! @brief Whole content of the file, from its start
+inline std::string read_all(FILE * fp) {
+    std::string result;
+    rewind(fp);
+    for (int c = fgetc(fp); c != EOF; c = fgetc(fp)) {
+        result += static_cast<char>(c);
+    }
+    return result;
+}
+
+/**
+ * @brief Source parsed and analysed without errors, as every engine
+ *  expects it. The tree belongs to the parser and lives as long as this.
+ */
+struct TestProgram {
+    explicit TestProgram(const std::string & source) {
+        tree = parser.parse(source.c_str(), source.size());
+        REQUIRE(analyser.analyse(tree) == 0);
+        slots = analyser.symtable().size();
+    }
+
+    tinylang::Parser parser;
+    tinylang::Analyser analyser;
+    tinylang::TreeNode * tree = nullptr;
+    size_t slots = 0;
+};
+
+//! @brief Return value, output and final variables of one run
+struct RunResult {
+    int ret = 0;
+    std::string output;
+    std::vector<int> vars;
+};
+
+/**
+ * @brief Run engine(in, out, &vars) with the input in a temporary file.
+ *  An engine that cannot tell its variables leaves them empty.
+ */
+template <typename Engine>
+RunResult run_with_input(const std::string & input, Engine engine) {
+    FILE * in = tmpfile();
+    FILE * out = tmpfile();
+    fputs(input.c_str(), in);
+    rewind(in);
+    RunResult result;
+    result.ret = engine(in, out, &result.vars);
+    result.output = read_all(out);
+    fclose(in);
+    fclose(out);
+    return result;
+}
+
+//! @brief Run the program on the interpreter, the reference of all engines
+inline RunResult run_reference(const TestProgram & program, const std::string & input) {
+    return run_with_input(input, [&](FILE * in, FILE * out, std::vector<int> * vars) {
+        tinylang::Interpreter interpreter(in, out);
+        int ret = interpreter.run(program.tree, program.slots);
+        *vars = interpreter.variables();
+        return ret;
+    });
+}
+
+/**
+ * @brief Run the source on the interpreter and on
+ *  engine(program, in, out, &vars), expect the same return value and
+ *  output, and the same variables unless the engine left them empty.
+ */
+template <typename Engine>
+void check_engine(const std::string & source, const std::string & input, Engine engine) {
+    TestProgram program(source);
+    RunResult expected = run_reference(program, input);
+    RunResult actual = run_with_input(input, [&](FILE * in, FILE * out, std::vector<int> * vars) {
+        return engine(program, in, out, vars);
+    });
+    REQUIRE(actual.ret == expected.ret);
+    REQUIRE(actual.output == expected.output);
+    if (!actual.vars.empty()) {
+        REQUIRE(actual.vars == expected.vars);
+    }
+}
+
+//! @brief check_engine() on each of the cases
+template <size_t N, typename Engine>
+void check_engine(const EngineCase (&cases)[N], Engine engine) {
+    for (const EngineCase & c : cases) {
+        check_engine(c.source, c.input, engine);
+    }
+}
+
+//! @brief check_engine() on every program of ENGINE_CASES
+template <typename Engine>
+void check_engine(Engine engine) {
+    check_engine(ENGINE_CASES, engine);
+}
+
+//! @brief Exit status, standard output and standard error of a process
+struct ExecResult {
+    int status = -1; // -1 when it did not exit normally
+    std::string output;
+    std::string err;
+};
+
+/**
+ * @brief Run the command, a path and its arguments, with the input on its
+ *  standard input.
+ */
+inline ExecResult run_executable(const std::string & path, const std::string & input) {
+    const std::string base = "tiny_test_run";
+    FILE * input_file = fopen((base + ".in").c_str(), "w");
+    REQUIRE(input_file != nullptr);
+    fputs(input.c_str(), input_file);
+    fclose(input_file);
+
+    ExecResult result;
+    std::string cmd = path + " < " + base + ".in 2> " + base + ".err";
+    FILE * pipe = popen(cmd.c_str(), "r");
+    REQUIRE(pipe != nullptr);
+    char buf[256];
+    for (size_t n; (n = fread(buf, 1, sizeof(buf), pipe)) > 0;) {
+        result.output.append(buf, n);
+    }
+    int status = pclose(pipe);
+    if (status != -1 && WIFEXITED(status)) {
+        result.status = WEXITSTATUS(status);
+    }
+    FILE * err_file = fopen((base + ".err").c_str(), "r");
+    REQUIRE(err_file != nullptr);
+    result.err = read_all(err_file);
+    fclose(err_file);
+    remove((base + ".in").c_str());
+    remove((base + ".err").c_str());
+    return result;
+}
+
+/**
+ * @brief Write the source as an executable with build(program, path),
+ *  run it and expect the output of the interpreter. A runtime error goes
+ *  to stderr and exits with 255, as on every engine.
+ */
+template <typename Build>
+void check_executable(const std::string & source, const std::string & input, Build build) {
+    TestProgram program(source);
+    RunResult expected = run_reference(program, input);
+    const std::string path = "./tiny_test_executable";
+    REQUIRE(build(program, path) == 0);
+    ExecResult actual = run_executable(path, input);
+    remove(path.c_str());
+    REQUIRE(actual.output == expected.output);
+    if (expected.ret == 0) {
+        REQUIRE(actual.err == "");
+        REQUIRE(actual.status == 0);
+    } else {
+        REQUIRE(actual.err.find("runtime error: division by zero\n") != std::string::npos);
+        REQUIRE(actual.status == 255);
+    }
+}
+
+//! @brief check_executable() on every program of ENGINE_CASES
+template <typename Build>
+void check_executable(Build build) {
+    for (const EngineCase & c : ENGINE_CASES) {
+        check_executable(c.source, c.input, build);
+    }
+}
+
+#endif /* !TEST_HELPERS_H */
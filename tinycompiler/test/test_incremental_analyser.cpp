@@ -0,0 +1,121 @@
+/*
+ * test_incremental_analyser.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "catch.hpp"
+
+#include "../incremental_analyser.h"
+#include <random>
+#include <string>
+
+using namespace tinylang;
+
+namespace {
+
+std::string random_statements(std::mt19937 & rng, int count) {
+    std::string code;
+    for (int i = 0; i < count; ++i) {
+        std::string a = "v" + std::to_string(rng() % 12);
+        std::string b = "v" + std::to_string(rng() % 12);
+        if (i > 0)
+            code += ";\n";
+        switch (rng() % 6) {
+            case 0: code += "read " + a; break;
+            case 1: code += "write " + a + " * 2"; break;
+            case 2: code += "if " + a + " then write 1 end"; break;
+            case 3: code += "if " + b + " < 1 then " + a + " := 2 end"; break;
+            case 4: code += "repeat " + a + " := " + a + " - 1 until " + a + " < 0"; break;
+            default: code += a + " := " + b + " + 1"; break;
+        }
+    }
+    return code;
+}
+
+void require_same_as_full(IncrementalAnalyser & incremental, int ret) {
+    Analyser full;
+    REQUIRE(full.analyse(incremental.tree()) == ret);
+    REQUIRE(incremental.diagnostics() == full.diagnostics());
+    SymTable st = incremental.symtable();
+    REQUIRE(st.size() == full.symtable().size());
+    for (size_t id = 0; id < st.size(); ++id) {
+        REQUIRE(st.record(id).name == full.symtable().record(id).name);
+        REQUIRE(st.record(id).lines.to_vector() ==
+                full.symtable().record(id).lines.to_vector());
+    }
+}
+
+} /* namespace */
+
+TEST_CASE( "IncrementalAnalyser::replace correctness", "[IncrementalAnalyser]" ) {
+    Parser parser;
+    std::string input_data = "read x;\ny := x + 1;\nwrite y;\nwrite z";
+    IncrementalAnalyser analyser;
+    REQUIRE(analyser.analyse(parser.parse(input_data.c_str(), input_data.size())) != 0);
+    REQUIRE(analyser.diagnostics().size() == 1);
+    REQUIRE(analyser.lines("x") == std::vector<int>({1, 2}));
+
+    // defining z up front fixes the last statement and nothing else
+    std::string edit = "read z";
+    REQUIRE(analyser.replace(0, 0, parser.parse(edit.c_str(), edit.size())) == 0);
+    REQUIRE(analyser.size() == 5);
+    REQUIRE(analyser.last_checked() == 2);
+    REQUIRE(analyser.diagnostics().empty());
+    require_same_as_full(analyser, 0);
+
+    // removing the definition of x breaks its use
+    REQUIRE(analyser.replace(1, 1, nullptr) != 0);
+    REQUIRE(analyser.last_checked() == 1);
+    REQUIRE(analyser.lines("x").empty());
+    require_same_as_full(analyser, -1);
+}
+
+TEST_CASE( "IncrementalAnalyser::replace at the end", "[IncrementalAnalyser]" ) {
+    Parser parser;
+    std::string input_data = "read x;\nwrite x";
+    IncrementalAnalyser analyser;
+    REQUIRE(analyser.analyse(parser.parse(input_data.c_str(), input_data.size())) == 0);
+
+    // append after the last statement
+    std::string edit = "write y;\nwrite x + 1";
+    REQUIRE(analyser.replace(2, 0, parser.parse(edit.c_str(), edit.size())) != 0);
+    REQUIRE(analyser.size() == 4);
+    require_same_as_full(analyser, -1);
+
+    // replace the last two statements
+    edit = "y := x";
+    REQUIRE(analyser.replace(2, 2, parser.parse(edit.c_str(), edit.size())) == 0);
+    REQUIRE(analyser.size() == 3);
+    require_same_as_full(analyser, 0);
+
+    // ranges past the end change nothing
+    REQUIRE(analyser.replace(4, 0, nullptr) == -1);
+    REQUIRE(analyser.replace(2, 2, nullptr) == -1);
+    REQUIRE(analyser.replace(1, static_cast<size_t>(-1), nullptr) == -1);
+    REQUIRE(analyser.size() == 3);
+    require_same_as_full(analyser, 0);
+
+    // remove the last statement
+    REQUIRE(analyser.replace(2, 1, nullptr) == 0);
+    REQUIRE(analyser.size() == 2);
+    require_same_as_full(analyser, 0);
+}
+
+TEST_CASE( "IncrementalAnalyser matches full analysis", "[IncrementalAnalyser]" ) {
+    std::mt19937 rng(20180704);
+    Parser parser;
+    std::string input_data = random_statements(rng, 150);
+    IncrementalAnalyser analyser;
+    int ret = analyser.analyse(parser.parse(input_data.c_str(), input_data.size()));
+    require_same_as_full(analyser, ret);
+    for (int round = 0; round < 60; ++round) {
+        size_t first = rng() % (analyser.size() + 1);
+        size_t count = std::min<size_t>(rng() % 4, analyser.size() - first);
+        std::string edit = random_statements(rng, rng() % 4);
+        TreeNode * stmts = edit.empty() ? nullptr : parser.parse(edit.c_str(), edit.size());
+        ret = analyser.replace(first, count, stmts);
+        require_same_as_full(analyser, ret);
+    }
+}
@@ -0,0 +1,117 @@
+/*
+ * test_interpreter.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "catch.hpp"
+#include "test_helpers.h"
+
+#include "../analyser.h"
+#include "../interpreter.h"
+#include <cstring>
+#include <string>
+
+using namespace tinylang;
+
+namespace {
+
+//! @brief Run the analysed tree on the input
+RunResult run_tree(TreeNode * tree, size_t slots, const std::string & input) {
+    return run_with_input(input, [&](FILE * in, FILE * out, std::vector<int> * vars) {
+        Interpreter interpreter(in, out);
+        int ret = interpreter.run(tree, slots);
+        *vars = interpreter.variables();
+        return ret;
+    });
+}
+
+//! @brief Analyse and run the program, return its output or "error"
+std::string run_program(const std::string & source, const std::string & input,
+                        unsigned threads = 1) {
+    Parser parser;
+    TreeNode * tree = parser.parse(source.c_str(), source.size());
+    Analyser analyser;
+    analyser.set_threads(threads);
+    if (parser.error_count() != 0 || analyser.analyse(tree) != 0)
+        return "error";
+    RunResult result = run_tree(tree, analyser.symtable().size(), input);
+    return result.ret == 0 ? result.output : result.output + "error";
+}
+
+} /* namespace */
+
+TEST_CASE( "Interpreter runs the factorial sample", "[Interpreter]" ) {
+    std::string fact =
+        "read x; { input an integer }\n"
+        "if 0 < x then { don't compute if x <= 0 }\n"
+        "  fact := 1;\n"
+        "  repeat\n"
+        "    fact := fact * x;\n"
+        "    x := x - 1\n"
+        "  until x = 0;\n"
+        "  write fact { output factorial of x }\n"
+        "end";
+    REQUIRE(run_program(fact, "5") == "120\n");
+    REQUIRE(run_program(fact, "10") == "3628800\n");
+    REQUIRE(run_program(fact, "0") == "");
+    // at the end of the input read yields 0
+    REQUIRE(run_program(fact, "") == "");
+}
+
+TEST_CASE( "Interpreter arithmetic", "[Interpreter]" ) {
+    REQUIRE(run_program("write 7 / 2; write (0 - 7) / 2; write 2 * 3 - 4", "") ==
+            "3\n-3\n2\n");
+    REQUIRE(run_program("if 1 < 2 then write 1 end; if 2 < 1 then write 2 end;"
+                        "if 3 = 3 then write 3 else write 4 end", "") == "1\n3\n");
+    // 32-bit wrap around
+    REQUIRE(run_program("x := 2147483647 + 1; write x; write x / (0 - 1)", "") ==
+            "-2147483648\n-2147483648\n");
+    REQUIRE(run_program("read a; read b; write a * b", "65536 65536") == "0\n");
+    REQUIRE(run_program("read a; write 1; write 10 / a; write 2", "0") ==
+            "1\nerror");
+    REQUIRE(run_program("write y", "") == "error");
+}
+
+TEST_CASE( "Interpreter stops at a failing condition", "[Interpreter]" ) {
+    REQUIRE(run_program("if 1 / 0 < 1 then write 1 else write 2 end; write 3", "") ==
+            "error");
+    REQUIRE(run_program("read a; if 1 < 1 / a then write 1 end; read b; write b", "0 5") ==
+            "error");
+    // the body runs once, then the condition fails before a second round
+    REQUIRE(run_program("read a; repeat write a; a := a - 1 until 1 / a = 0; write 9", "1") ==
+            "1\nerror");
+
+    // no branch runs, and the variables are left as before the failure
+    const char * sources[] = {
+        "x := 4; if x / (x - 4) < 1 then y := 1 else y := 2 end",
+        "x := 4; y := x / (x - 4)",
+        "x := 4; repeat y := 1 until x / (y - 1) = 0; x := 5",
+    };
+    const int expected_y[] = {0, 0, 1};
+    for (int i = 0; i < 3; ++i) {
+        Parser parser;
+        TreeNode * tree = parser.parse(sources[i], strlen(sources[i]));
+        Analyser analyser;
+        REQUIRE(analyser.analyse(tree) == 0);
+        RunResult result = run_tree(tree, analyser.symtable().size(), "");
+        REQUIRE(result.ret == -1);
+        REQUIRE(result.vars == (std::vector<int>{4, expected_y[i]}));
+    }
+}
+
+TEST_CASE( "Interpreter uses the slots of the parallel analysis", "[Interpreter]" ) {
+    // enough statements for several chunks; a use in a late chunk refers to
+    // a variable defined in an early one
+    std::string source = "read a";
+    for (int i = 0; i < 6000; ++i) {
+        source += "; v" + std::to_string(i % 97) + " := a + " + std::to_string(i);
+        if (i % 1000 == 999)
+            source += "; a := a + v" + std::to_string(i % 97);
+    }
+    source += "; write a; write v5";
+    std::string expected = run_program(source, "3");
+    REQUIRE(expected != "error");
+    REQUIRE(run_program(source, "3", 4) == expected);
+}
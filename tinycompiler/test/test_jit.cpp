@@ -0,0 +1,47 @@
+/*
+ * test_jit.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "catch.hpp"
+#include "test_helpers.h"
+
+#include "../analyser.h"
+#include "../jit.h"
+#include <string>
+
+using namespace tinylang;
+
+#ifdef TINY_JIT_SUPPORTED
+
+namespace {
+
+//! @brief Compile the program to native code and run it
+int run_jit(const TestProgram & program, FILE * in, FILE * out, std::vector<int> * vars) {
+    JitCompiler compiler;
+    JitProgram prog = compiler.compile(program.tree, program.slots);
+    REQUIRE(prog.valid());
+    int ret = prog.run(in, out);
+    *vars = prog.variables();
+    return ret;
+}
+
+} /* namespace */
+
+TEST_CASE( "JIT matches the interpreter", "[JIT]" ) {
+    check_engine(run_jit);
+}
+
+TEST_CASE( "JIT spills deeply nested expressions", "[JIT]" ) {
+    // every right operand is a subexpression, so each level needs a register
+    std::string e = "a";
+    for (int i = 0; i < 12; ++i) {
+        e = "(" + std::to_string(i + 2) + " - (a * " + e + "))";
+    }
+    check_engine("read a; write " + e + "; write 100 / " + e, "3", run_jit);
+    check_engine("read a; write 100 / (" + e + " - " + e + ")", "3", run_jit);
+}
+
+#endif
@@ -0,0 +1,73 @@
+/*
+ * test_ll1parser.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "catch.hpp"
+#include <cstring>
+
+#include "../ll1parser.h"
+
+using namespace tinylang;
+
+static bool same_tree(const TreeNode *a, const TreeNode *b) {
+    for (; a != nullptr && b != nullptr; a = a->neighbor, b = b->neighbor) {
+        if (a->node_type != b->node_type || a->line_no != b->line_no)
+            return false;
+        if (a->node_type == NodeStmt) {
+            if (a->stmt != b->stmt)
+                return false;
+            if ((a->stmt == StmtAssign || a->stmt == StmtRead) &&
+                strcmp(a->attr.name, b->attr.name) != 0)
+                return false;
+        } else {
+            if (a->expr != b->expr)
+                return false;
+            if (a->expr == ExprOp && a->attr.op != b->attr.op)
+                return false;
+            if (a->expr == ExprConst && a->attr.val != b->attr.val)
+                return false;
+            if (a->expr == ExprIdentifier &&
+                strcmp(a->attr.name, b->attr.name) != 0)
+                return false;
+        }
+        for (int i = 0; i < TreeNode::MAX_CHILDREN; ++i) {
+            if (!same_tree(a->children[i], b->children[i]))
+                return false;
+        }
+    }
+    return a == nullptr && b == nullptr;
+}
+
+TEST_CASE( "LL1Parser::parse matches Parser::parse", "[LL1Parser]" ) {
+    const char *programs[] = {
+        "a := 1024 + 42; b := 9 * a;\nc := b - 23",
+        "if (a < 0) then\nbar := a + 233\nend",
+        "read x;\nif 0 < x then\n  fact := 1;\n  repeat\n    fact := fact * x;\n"
+        "    x := x - 1\n  until x = 0;\n  write fact\nelse write 0 - x end",
+        "a2 := a1 * 5 / (a + a1) { comment }; write (186 - 23) / 2",
+    };
+    Parser parser;
+    LL1Parser ll1_parser;
+    for (const char *program : programs) {
+        TreeNode *expected = parser.parse(program, strlen(program));
+        TreeNode *tree = ll1_parser.parse(program, strlen(program));
+        REQUIRE(ll1_parser.error_count() == 0);
+        REQUIRE(tree != nullptr);
+        REQUIRE(same_tree(tree, expected));
+    }
+}
+
+TEST_CASE( "LL1Parser::parse error correctness", "[LL1Parser]" ) {
+    LL1Parser parser;
+    std::string input_data;
+    input_data = "if (a < 0)\na := 0 - a\n end";
+    REQUIRE(parser.parse(input_data.c_str(), input_data.size()) == nullptr);
+    REQUIRE(parser.error_count() == 1);
+
+    input_data = "a := 1; end";
+    REQUIRE(parser.parse(input_data.c_str(), input_data.size()) == nullptr);
+    REQUIRE(parser.error_count() == 1);
+}
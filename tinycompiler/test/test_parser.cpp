@@ -6,6 +6,7 @@
  */
 
 #include "catch.hpp"
+#include <cstring>
 
 // To test private methods
 #define private public
@@ -22,18 +23,17 @@ TEST_CASE( "Parser::term correctness", "[Parser]" ) {
     input_data = "1 * 1";
     TreeNode *tree = nullptr;
     parser.init_scanner(input_data.c_str(), input_data.size());
-    REQUIRE(parser.token_ == TokenType::NUM);
-    REQUIRE(parser.token_str_ == "1");
+    REQUIRE(parser.token() == TokenType::NUM);
+    REQUIRE(parser.peek(0).str() == "1");
     tree = parser.term();
     REQUIRE(tree != nullptr);
     REQUIRE(tree->node_type == NodeExpr);
     REQUIRE(tree->attr.op == TokenType::TIMES);
-    destroyTreeNode(tree);
 
     input_data = "(1 + 2) * rhs";
     parser.init_scanner(input_data.c_str(), input_data.size());
-    REQUIRE(parser.token_ == TokenType::LPAREN);
-    REQUIRE(parser.token_str_ == "(");
+    REQUIRE(parser.token() == TokenType::LPAREN);
+    REQUIRE(parser.peek(0).str() == "(");
     tree = parser.term();
     REQUIRE(tree != nullptr);
     REQUIRE(tree->node_type == NodeExpr);
@@ -44,7 +44,6 @@ TEST_CASE( "Parser::term correctness", "[Parser]" ) {
     node = tree->children[1];
     REQUIRE(node->expr == ExprIdentifier);
     REQUIRE(strcmp(node->attr.name, "rhs") == 0);
-    destroyTreeNode(tree);
 }
 
 TEST_CASE( "Parser::stmt_sequence correctness", "[Parser]" ) {
@@ -53,8 +52,10 @@ TEST_CASE( "Parser::stmt_sequence correctness", "[Parser]" ) {
     input_data = "a := 1024 + 42; b := 9 * a;\nc := b - 23";
     TreeNode *tree = nullptr;
     parser.init_scanner(input_data.c_str(), input_data.size());
-    REQUIRE(parser.token_ == TokenType::ID);
-    REQUIRE(parser.token_str_ == "a");
+    REQUIRE(parser.token() == TokenType::ID);
+    REQUIRE(parser.peek(0).str() == "a");
+    REQUIRE(parser.peek(1).type == TokenType::ASSIGN);
+    REQUIRE(parser.peek(2).str() == "1024");
     tree = parser.stmt_sequence();
     REQUIRE(tree != nullptr);
     REQUIRE(tree->node_type == NodeStmt);
@@ -105,7 +106,6 @@ TEST_CASE( "Parser::stmt_sequence correctness", "[Parser]" ) {
     REQUIRE(node->children[1]->attr.val == 23);
 
     REQUIRE(node->neighbor == nullptr);
-    destroyTreeNode(tree);
 }
 
 TEST_CASE( "Parser::parse correctness", "[Parser]" ) {
@@ -138,7 +138,6 @@ TEST_CASE( "Parser::parse correctness", "[Parser]" ) {
     REQUIRE(node->attr.op == TokenType::PLUS);
     REQUIRE_STRCMP(node->children[0]->attr.name, "a");
     REQUIRE(node->children[1]->attr.val == 233);
-    destroyTreeNode(tree);
 }
 
 TEST_CASE( "Parser::parse error correctness", "[Parser]") {
@@ -146,5 +145,89 @@ TEST_CASE( "Parser::parse error correctness", "[Parser]") {
     std::string input_data;
     input_data = "if (a < 0)\na := 0 - a\n end";
     TreeNode * tree = parser.parse(input_data.c_str(), input_data.size());
-    destroyTreeNode(tree);
-}
\ No newline at end of file
+    REQUIRE(tree != nullptr);
+}
+
+TEST_CASE( "Parser::parse empty program", "[Parser]") {
+    Parser parser;
+    std::string input_data;
+    REQUIRE(parser.parse(input_data.c_str(), input_data.size()) == nullptr);
+    REQUIRE(parser.error_count() == 0);
+    input_data = "  { nothing here }\n";
+    REQUIRE(parser.parse(input_data.c_str(), input_data.size()) == nullptr);
+    REQUIRE(parser.error_count() == 0);
+}
+
+TEST_CASE( "Parser syntax-only mode", "[Parser]") {
+    Parser parser(ParseSyntaxOnly);
+    std::string input_data;
+    input_data = "read x;\nrepeat x := x - 1; write x until x < 1";
+    REQUIRE(parser.parse(input_data.c_str(), input_data.size()) == nullptr);
+    REQUIRE(parser.error_count() == 0);
+
+    input_data = "if (a < 0)\na := 0 - a\n end";
+    REQUIRE(parser.parse(input_data.c_str(), input_data.size()) == nullptr);
+    REQUIRE(parser.error_count() > 0);
+
+    Parser full_parser;
+    TreeNode * tree = full_parser.parse(input_data.c_str(), input_data.size());
+    REQUIRE(tree != nullptr);
+    REQUIRE(full_parser.error_count() == parser.error_count());
+}
+
+TEST_CASE( "Parser::parse error recovery", "[Parser]") {
+    Parser parser;
+    std::string input_data;
+    input_data = "a := (1 + ;\n"
+                 "if a < 0 then b := 1 else c := end;\n"
+                 "repeat a := a - 1 until ;\n"
+                 "write a\n"
+                 "read b then;\n"
+                 "write b";
+    TreeNode * tree = parser.parse(input_data.c_str(), input_data.size());
+    // ( 1 + ;   else c := end   until ;   missing ';'   then
+    REQUIRE(parser.error_count() == 5);
+    REQUIRE(tree != nullptr);
+    REQUIRE(tree->stmt == StmtAssign);
+    REQUIRE(tree->children[0]->children[1]->node_type == NodeError);
+    TreeNode * node = tree->neighbor;
+    REQUIRE(node->stmt == StmtIf);
+    REQUIRE(node->children[2]->children[0]->node_type == NodeError);
+    node = node->neighbor;
+    REQUIRE(node->stmt == StmtRepeat);
+    node = node->neighbor;
+    REQUIRE(node->stmt == StmtWrite);
+    node = node->neighbor;
+    REQUIRE(node->stmt == StmtRead);
+    node = node->neighbor;
+    REQUIRE(node->stmt == StmtWrite);
+    REQUIRE(node->neighbor == nullptr);
+
+    input_data = "a := 1; end; b := 2 else";
+    tree = parser.parse(input_data.c_str(), input_data.size());
+    REQUIRE(parser.error_count() == 2);
+    REQUIRE(tree->neighbor->node_type == NodeError);
+    REQUIRE(tree->neighbor->neighbor != nullptr);
+    REQUIRE_STRCMP(tree->neighbor->neighbor->attr.name, "b");
+
+    input_data = "a := ; b := ; c := ; d := ; e := 1";
+    parser.set_max_errors(3);
+    tree = parser.parse(input_data.c_str(), input_data.size());
+    REQUIRE(parser.error_count() == 3);
+}
+
+TEST_CASE( "Parser::reset recycles nodes", "[Parser]") {
+    Parser parser;
+    std::string input_data = "read x; y := x * (x + 1); write y";
+    TreeNode * first = parser.parse(input_data.c_str(), input_data.size());
+    TreeNode * second = parser.parse(input_data.c_str(), input_data.size());
+    REQUIRE(first != second);
+    REQUIRE_STRCMP(first->attr.name, "x");
+    REQUIRE_STRCMP(second->attr.name, "x");
+
+    parser.reset();
+    SyntaxTree tree = parser.parse(input_data.c_str(), input_data.size());
+    REQUIRE(tree.root() == first);
+    REQUIRE(tree->stmt == StmtRead);
+    REQUIRE_STRCMP(tree->neighbor->attr.name, "y");
+}
@@ -0,0 +1,74 @@
+/*
+ * test_range_analysis.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "catch.hpp"
+
+#include "../range_analysis.h"
+#include <string>
+
+using namespace tinylang;
+
+TEST_CASE( "RangeAnalysis straight-line code", "[RangeAnalysis]" ) {
+    Parser parser;
+    std::string input_data = "x := 10; y := 100 / x; z := y * y - 1; read w; v := w / x";
+    TreeNode * tree = parser.parse(input_data.c_str(), input_data.size());
+    RangeAnalysis ranges;
+    ranges.run(tree);
+    REQUIRE(ranges.exit_range("y") == Interval::constant(10));
+    REQUIRE(ranges.exit_range("z") == Interval::constant(99));
+    REQUIRE(ranges.exit_range("v") == (Interval{-214748364, 214748364}));
+    TreeNode * over = tree->neighbor->children[0];
+    REQUIRE(over->safety == (SafeNoDivZero | SafeNoOverflow));
+    REQUIRE(tree->neighbor->neighbor->children[0]->safety == SafeNoOverflow);
+    // 4 operators, 2 of them divisions, all proven
+    REQUIRE(ranges.checks() == 6);
+    REQUIRE(ranges.proven() == 6);
+
+    input_data = "read x; y := 100 / x; z := x * x; w := ((0 - 2147483647) - 1) / x";
+    tree = parser.parse(input_data.c_str(), input_data.size());
+    ranges.run(tree);
+    REQUIRE(tree->neighbor->children[0]->safety == SafeNoOverflow);
+    REQUIRE(tree->neighbor->neighbor->children[0]->safety == 0);
+    // INT_MIN / -1 overflows
+    REQUIRE(tree->neighbor->neighbor->neighbor->children[0]->safety == 0);
+    REQUIRE(ranges.exit_range("z") == Interval::top());
+}
+
+TEST_CASE( "RangeAnalysis branches and loops", "[RangeAnalysis]" ) {
+    Parser parser;
+    std::string input_data = "read x; if 0 < x then y := 100 / x else y := 0 end";
+    TreeNode * tree = parser.parse(input_data.c_str(), input_data.size());
+    RangeAnalysis ranges;
+    ranges.run(tree);
+    REQUIRE(tree->neighbor->children[1]->children[0]->safety ==
+            (SafeNoDivZero | SafeNoOverflow));
+    REQUIRE(ranges.exit_range("y") == (Interval{0, 100}));
+
+    // the counter is widened to the loop bound, not to INT_MAX
+    input_data = "i := 0; repeat i := i + 1 until 10 < i; y := 1000 / i";
+    tree = parser.parse(input_data.c_str(), input_data.size());
+    ranges.run(tree);
+    REQUIRE(tree->neighbor->children[0]->children[0]->safety == SafeNoOverflow);
+    REQUIRE(tree->neighbor->neighbor->children[0]->safety ==
+            (SafeNoDivZero | SafeNoOverflow));
+    REQUIRE(ranges.exit_range("i") == Interval::constant(11));
+    REQUIRE(ranges.exit_range("y") == Interval::constant(90));
+
+    // an unbounded loop reaches the full range
+    input_data = "read n; s := 0; repeat s := s + n; n := n - 1 until n = 0";
+    tree = parser.parse(input_data.c_str(), input_data.size());
+    ranges.run(tree);
+    REQUIRE(tree->neighbor->neighbor->children[0]->children[0]->safety == 0);
+    REQUIRE(ranges.exit_range("n") == Interval::constant(0));
+
+    // the else branch is dead
+    input_data = "x := 1; if x < 2 then y := 1 else y := 1 / 0 end";
+    tree = parser.parse(input_data.c_str(), input_data.size());
+    ranges.run(tree);
+    REQUIRE(ranges.exit_range("y") == Interval::constant(1));
+    REQUIRE(tree->neighbor->children[2]->children[0]->safety == 0);
+}
@@ -0,0 +1,88 @@
+/*
+ * test_register_vm.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "catch.hpp"
+#include "test_helpers.h"
+
+#include "../analyser.h"
+#include "../range_analysis.h"
+#include "../register_vm.h"
+#include <string>
+
+using namespace tinylang;
+
+namespace {
+
+//! @brief Compile the program to register code and run it on the VM
+int run_register_vm(const TestProgram & program, FILE * in, FILE * out,
+                    std::vector<int> * vars) {
+    RegisterVM vm(in, out);
+    RegisterCompiler compiler;
+    int ret = vm.run(compiler.compile(program.tree, program.slots));
+    *vars = vm.variables();
+    return ret;
+}
+
+//! @brief run_register_vm() after the range analysis flagged the safe divisions
+int run_ranged_register_vm(const TestProgram & program, FILE * in, FILE * out,
+                           std::vector<int> * vars) {
+    RangeAnalysis ranges;
+    ranges.run(program.tree);
+    return run_register_vm(program, in, out, vars);
+}
+
+} /* namespace */
+
+TEST_CASE( "RegisterVM matches the interpreter", "[RegisterVM]" ) {
+    check_engine(run_register_vm);
+    check_engine(run_ranged_register_vm);
+}
+
+TEST_CASE( "RegisterCompiler output", "[RegisterVM]" ) {
+    Parser parser;
+    std::string input_data = "read b; read c; read d; a := b * c + d; write a * 2";
+    TreeNode * tree = parser.parse(input_data.c_str(), input_data.size());
+    Analyser analyser;
+    REQUIRE(analyser.analyse(tree) == 0);
+    RegisterCompiler compiler;
+    RegisterProgram prog = compiler.compile(tree, analyser.symtable().size());
+    REQUIRE(prog.constants == std::vector<int>{2});
+    REQUIRE(prog.temps == 1);
+    REQUIRE(prog.registers() == 4 + 1 + 1);
+    REQUIRE(prog.code.size() == 3 + 2 + 2 + 1);
+    // a := b * c + d computes into a temporary, then into a
+    const RegInstr & mul = prog.code[3];
+    const RegInstr & add = prog.code[4];
+    REQUIRE(mul.op == ROP_MUL);
+    REQUIRE(mul.a == 5);
+    REQUIRE(add.op == ROP_ADD);
+    REQUIRE(add.a == 3);
+    REQUIRE(add.b == 5);
+    REQUIRE(prog.code[5].op == ROP_MUL);
+    REQUIRE(prog.code[5].c == 4);
+    REQUIRE(prog.code[6].op == ROP_WRITE);
+}
+
+TEST_CASE( "RegisterCompiler drops proven division checks", "[RegisterVM]" ) {
+    Parser parser;
+    std::string input_data = "read a; b := 4; write a / b; write b / a";
+    TreeNode * tree = parser.parse(input_data.c_str(), input_data.size());
+    Analyser analyser;
+    REQUIRE(analyser.analyse(tree) == 0);
+    RangeAnalysis ranges;
+    ranges.run(tree);
+    RegisterCompiler compiler;
+    RegisterProgram prog = compiler.compile(tree, analyser.symtable().size());
+    std::vector<RegOpcode> divisions;
+    for (const RegInstr & ins : prog.code) {
+        if (ins.op == ROP_DIV || ins.op == ROP_DIV_NZ)
+            divisions.push_back(ins.op);
+    }
+    REQUIRE(divisions == (std::vector<RegOpcode>{ROP_DIV_NZ, ROP_DIV}));
+    // only the checked division has a line to report
+    REQUIRE(prog.div_lines.size() == 1);
+}
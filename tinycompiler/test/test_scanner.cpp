@@ -7,7 +7,7 @@
 
 #include "catch.hpp"
 
-#include "../scanner.h"
+#include "../token_buffer.h"
 
 using namespace tinylang;
 
@@ -83,3 +83,51 @@ TEST_CASE( "Scanner::getToken multi-line correctness", "[Scanner]" ) {
     REQUIRE(scanner.getToken() == TokenType::END);
     REQUIRE(scanner.getToken() == TokenType::ENDFILE);
 }
+
+TEST_CASE( "Scanner::scan zero-copy tokens", "[Scanner]" ) {
+    Scanner scanner;
+    std::string input_data;
+    input_data = "{ comment }\nread x1;\nx1 := 42";
+    scanner.setInput(input_data.c_str(), input_data.size());
+    Token token = scanner.scan();
+    REQUIRE(token.type == TokenType::READ);
+    REQUIRE(token.text == input_data.c_str() + 12);
+    REQUIRE(token.str() == "read");
+    REQUIRE(token.line_no == 2);
+    token = scanner.scan();
+    REQUIRE(token.type == TokenType::ID);
+    REQUIRE(token.str() == "x1");
+    scanner.scan();
+    scanner.scan();
+    scanner.scan();
+    token = scanner.scan();
+    REQUIRE(token.type == TokenType::NUM);
+    REQUIRE(tokenToInt(token) == 42);
+    REQUIRE(token.line_no == 3);
+    REQUIRE(scanner.scan().type == TokenType::ENDFILE);
+}
+
+TEST_CASE( "TokenBuffer::peek correctness", "[Scanner]" ) {
+    Scanner scanner;
+    TokenBuffer tokens;
+    std::string input_data;
+    for (int i = 0; i < 100; ++i) {
+        input_data += "x" + std::to_string(i) + " ";
+    }
+    scanner.setInput(input_data.c_str(), input_data.size());
+    tokens.reset(&scanner);
+    REQUIRE(tokens.peek(0).str() == "x0");
+    REQUIRE(tokens.peek(TokenBuffer::CAPACITY - 1).str() == "x63");
+    for (int i = 0; i < 90; ++i) {
+        REQUIRE(tokens.peek(3).str() == "x" + std::to_string(i + 3));
+        REQUIRE(tokens.peek().str() == "x" + std::to_string(i));
+        tokens.advance();
+    }
+    REQUIRE(tokens.peek(9).type == TokenType::ID);
+    REQUIRE(tokens.peek(10).type == TokenType::ENDFILE);
+    REQUIRE(tokens.peek(20).type == TokenType::ENDFILE);
+    for (int i = 0; i < 20; ++i) {
+        tokens.advance();
+    }
+    REQUIRE(tokens.peek().type == TokenType::ENDFILE);
+}
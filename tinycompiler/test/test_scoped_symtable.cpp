@@ -0,0 +1,57 @@
+/*
+ * test_scoped_symtable.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "catch.hpp"
+
+#include "../scoped_symtable.h"
+
+using namespace tinylang;
+
+TEST_CASE( "ScopedSymTable global scope", "[ScopedSymTable]" ) {
+    ScopedSymTable st;
+    REQUIRE(st.lookup("a") == -1);
+    REQUIRE(st.insert("a", 1) == 0);
+    REQUIRE(st.insert("b", 2) == 1);
+    REQUIRE(st.insert("a", 3) == 0);
+    REQUIRE(st.lookup("a") == 0);
+    REQUIRE(st.record(0).lines.to_vector() == std::vector<int>({1, 3}));
+    st.exit_scope(); // the global scope stays
+    REQUIRE(st.depth() == 0);
+    REQUIRE(st.lookup("b") == 1);
+}
+
+TEST_CASE( "ScopedSymTable shadowing", "[ScopedSymTable]" ) {
+    ScopedSymTable st;
+    int outer = st.insert("x", 1);
+    st.enter_scope();
+    REQUIRE(st.insert("x", 2) == outer);
+    int inner = st.declare("x", 3);
+    REQUIRE(inner != outer);
+    REQUIRE(st.declare("x", 4) == inner);
+    REQUIRE(st.lookup("x") == inner);
+    REQUIRE(st.scope(inner) == 1);
+
+    st.enter_scope();
+    int innermost = st.declare("x", 5);
+    int y = st.declare("y", 5);
+    // undeclared names still become globals
+    int g = st.insert("g", 6);
+    REQUIRE(st.scope(g) == 0);
+    REQUIRE(st.lookup("x") == innermost);
+    st.exit_scope();
+
+    REQUIRE(st.lookup("x") == inner);
+    REQUIRE(st.lookup("y") == -1);
+    REQUIRE(st.lookup("g") == g);
+    st.exit_scope();
+    REQUIRE(st.lookup("x") == outer);
+    REQUIRE(st.lookup("g") == g);
+    REQUIRE(st.record(outer).lines.to_vector() == std::vector<int>({1, 2}));
+    REQUIRE(st.record(inner).lines.to_vector() == std::vector<int>({3, 4}));
+    REQUIRE(st.record(y).name == "y");
+    REQUIRE(st.size() == 5);
+}
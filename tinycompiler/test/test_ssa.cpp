@@ -0,0 +1,95 @@
+/*
+ * test_ssa.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "catch.hpp"
+#include "test_helpers.h"
+
+#include "../analyser.h"
+#include "../ssa_interpreter.h"
+#include <string>
+
+using namespace tinylang;
+
+namespace {
+
+std::string dump(const std::string & source) {
+    TestProgram program(source);
+    SsaBuilder builder;
+    SsaFunction fn = builder.build(program.tree, program.slots);
+    FILE * out = tmpfile();
+    fn.print(out);
+    std::string result = read_all(out);
+    fclose(out);
+    return result;
+}
+
+//! @brief Build the SSA form of the program and interpret it
+int run_ssa(const TestProgram & program, FILE * in, FILE * out, std::vector<int> * vars) {
+    SsaBuilder builder;
+    SsaFunction fn = builder.build(program.tree, program.slots, true);
+    SsaInterpreter ssa(in, out);
+    int ret = ssa.run(fn);
+    // the exit values are only known when the program reaches its end
+    if (ret == 0) {
+        *vars = ssa.variables();
+    }
+    return ret;
+}
+
+} /* namespace */
+
+TEST_CASE( "SSA construction", "[SSA]" ) {
+    REQUIRE(dump(FACT_SOURCE) ==
+            "b0:\n"
+            "  v0 = read\n"
+            "  v1 = const 0\n"
+            "  v2 = lt v1, v0\n"
+            "  branch v2, b1, b4\n"
+            "b1: <- b0\n"
+            "  v3 = const 1\n"
+            "  jump b2\n"
+            "b2: <- b1, b2\n"
+            "  v4 = phi [v0, b1], [v8, b2]\n"
+            "  v5 = phi [v3, b1], [v6, b2]\n"
+            "  v6 = mul v5, v4\n"
+            "  v7 = const 1\n"
+            "  v8 = sub v4, v7\n"
+            "  v9 = const 0\n"
+            "  v10 = eq v8, v9\n"
+            "  branch v10, b3, b2\n"
+            "b3: <- b2\n"
+            "  write v6\n"
+            "  jump b4\n"
+            "b4: <- b3, b0\n"
+            "  return\n");
+
+    // x is not changed by the loop and needs no phi; y starts at zero
+    REQUIRE(dump("x := 1; repeat write x; y := y + 1 until 3 < y; write y") ==
+            "b0:\n"
+            "  v0 = const 0\n"
+            "  v1 = const 1\n"
+            "  jump b1\n"
+            "b1: <- b0, b1\n"
+            "  v2 = phi [v0, b0], [v4, b1]\n"
+            "  write v1\n"
+            "  v3 = const 1\n"
+            "  v4 = add v2, v3\n"
+            "  v5 = const 3\n"
+            "  v6 = lt v5, v4\n"
+            "  branch v6, b2, b1\n"
+            "b2: <- b1\n"
+            "  write v4\n"
+            "  return\n");
+
+    // the same value on both branches needs no phi either
+    REQUIRE(dump("read a; b := a; if a < 1 then c := 2 end; write b").find("phi") ==
+            std::string::npos);
+}
+
+TEST_CASE( "SSA form matches the interpreter", "[SSA]" ) {
+    check_engine(run_ssa);
+}
@@ -0,0 +1,82 @@
+/*
+ * test_stack_vm.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "catch.hpp"
+#include "test_helpers.h"
+
+#include "../analyser.h"
+#include "../stack_vm.h"
+#include <string>
+
+using namespace tinylang;
+
+namespace {
+
+//! @brief Compile the program to bytecode and run it on the stack VM
+int run_stack_vm(const TestProgram & program, FILE * in, FILE * out,
+                 std::vector<int> * vars) {
+    StackVM vm(in, out);
+    BytecodeCompiler compiler;
+    int ret = vm.run(compiler.compile(program.tree, program.slots));
+    *vars = vm.variables();
+    return ret;
+}
+
+} /* namespace */
+
+TEST_CASE( "StackVM matches the interpreter", "[StackVM]" ) {
+    check_engine(run_stack_vm);
+}
+
+TEST_CASE( "BytecodeCompiler output", "[StackVM]" ) {
+    Parser parser;
+    std::string input_data = "read x; y := (x + 1) * x; if y < 10 then write y end";
+    TreeNode * tree = parser.parse(input_data.c_str(), input_data.size());
+    Analyser analyser;
+    REQUIRE(analyser.analyse(tree) == 0);
+    BytecodeCompiler compiler;
+    BytecodeProgram prog = compiler.compile(tree, analyser.symtable().size());
+    const uint8_t expected[] = {OP_READ, OP_LOAD, OP_ADDK, OP_LOAD, OP_MUL,
+                                OP_STORE, OP_LOAD, OP_JUMP_GEK, OP_LOAD,
+                                OP_WRITE, OP_HALT};
+    std::vector<uint8_t> ops;
+    for (size_t pc = 0; pc < prog.code.size();
+         pc += instruction_size(static_cast<Opcode>(prog.code[pc]))) {
+        ops.push_back(prog.code[pc]);
+    }
+    REQUIRE(ops == std::vector<uint8_t>(expected, expected + sizeof(expected)));
+    REQUIRE(prog.max_stack == 2);
+    // 7 opcodes with an immediate, one with two and 3 without
+    REQUIRE(prog.code.size() == 7 * 5 + 9 + 3);
+
+    input_data = "read i; repeat i := i - 1 until i = 0";
+    tree = parser.parse(input_data.c_str(), input_data.size());
+    REQUIRE(analyser.analyse(tree) == 0);
+    prog = compiler.compile(tree, analyser.symtable().size());
+    REQUIRE(prog.code[5] == OP_INCR);
+    REQUIRE(read_imm(&prog.code[10]) == -1);
+    REQUIRE(prog.code[14] == OP_LOAD);
+    REQUIRE(prog.code[19] == OP_JUMP_NEK);
+    REQUIRE(read_imm(&prog.code[24]) == 5);
+}
+
+TEST_CASE( "StackVM reports the line of a division by zero", "[StackVM]" ) {
+    Parser parser;
+    std::string input_data = "x := 0;\ny := 1;\nwrite y / x";
+    TreeNode * tree = parser.parse(input_data.c_str(), input_data.size());
+    Analyser analyser;
+    REQUIRE(analyser.analyse(tree) == 0);
+    BytecodeCompiler compiler;
+    BytecodeProgram prog = compiler.compile(tree, analyser.symtable().size());
+    REQUIRE(prog.div_lines.size() == 1);
+    REQUIRE(prog.line_of(prog.div_lines[0].first) == 3);
+    FILE * out = tmpfile();
+    StackVM vm(stdin, out);
+    REQUIRE(vm.run(prog) == -1);
+    REQUIRE(read_all(out) == "");
+    fclose(out);
+}
@@ -0,0 +1,55 @@
+/*
+ * test_symtable.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "catch.hpp"
+
+#include "../symtable.h"
+
+using namespace tinylang;
+
+TEST_CASE( "LineList round trip", "[SymTable]" ) {
+    LineList lines;
+    std::vector<int> expected = {1, 1, 2, 200, 3, 70000, 0, -5, 2147483647};
+    for (int line_no : expected) {
+        lines.push_back(line_no);
+    }
+    REQUIRE(lines.size() == expected.size());
+    REQUIRE(lines.to_vector() == expected);
+
+    LineList forward;
+    for (int i = 1; i <= 1000; ++i) {
+        forward.push_back(i / 3 + 1);
+    }
+    // one byte per occurrence for small forward steps
+    REQUIRE(forward.bytes() == 1000);
+}
+
+TEST_CASE( "SymTable::insert and lookup", "[SymTable]" ) {
+    SymTable st;
+    REQUIRE(st.find("a") == -1);
+    REQUIRE(st.insert("a", 1) == 0);
+    REQUIRE(st.insert(std::string("bb"), 2) == 1);
+    REQUIRE(st.insert("a", 3) == 0);
+    st.insert_line(1, 4);
+    REQUIRE(st.find("a") == 0);
+    REQUIRE(st.find(std::string("bb")) == 0);
+    REQUIRE(st.lookup("b") == -1);
+    REQUIRE(st.lookup("bb", 2) == 1);
+    REQUIRE(st.size() == 2);
+    REQUIRE(st.record(0).name == "a");
+    REQUIRE(st.record(0).lines.to_vector() == std::vector<int>({1, 3}));
+    REQUIRE(st.record(1).lines.to_vector() == std::vector<int>({2, 4}));
+
+    // grow the table
+    for (int i = 0; i < 10000; ++i) {
+        REQUIRE(st.insert("v" + std::to_string(i), i) == i + 2);
+    }
+    for (int i = 0; i < 10000; ++i) {
+        REQUIRE(st.lookup(("v" + std::to_string(i)).c_str()) == i + 2);
+    }
+    REQUIRE(st.lookup("a") == 0);
+}
@@ -0,0 +1,117 @@
+/*
+ * test_tm.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "catch.hpp"
+#include "test_helpers.h"
+
+#include "../analyser.h"
+#include "../tm_codegen.h"
+#include "../tm_simulator.h"
+#include <string>
+
+using namespace tinylang;
+
+namespace {
+
+//! @brief Load the TM code into a simulator and run it on the input file
+int run_tm_file(FILE * code, FILE * in, FILE * out, size_t data_size) {
+    rewind(code);
+    TmSimulator sim(in, out);
+    REQUIRE(sim.load(code) == 0);
+    return sim.run(data_size);
+}
+
+//! @brief Run the TM program text on the simulator, return the output
+std::string run_tm(const std::string & tm_code, const std::string & input,
+                   int * ret, size_t data_size = 1024) {
+    RunResult result = run_with_input(input, [&](FILE * in, FILE * out, std::vector<int> *) {
+        FILE * code = tmpfile();
+        fputs(tm_code.c_str(), code);
+        int code_ret = run_tm_file(code, in, out, data_size);
+        fclose(code);
+        return code_ret;
+    });
+    *ret = result.ret;
+    return result.output;
+}
+
+//! @brief Generate TM code for the program and run it on the simulator
+int run_tm_codegen(const TestProgram & program, FILE * in, FILE * out,
+                   std::vector<int> *) {
+    FILE * code = tmpfile();
+    TmCodeGenerator codegen(code);
+    codegen.generate(program.tree, program.slots);
+    int ret = run_tm_file(code, in, out, codegen.data_size());
+    fclose(code);
+    return ret;
+}
+
+} /* namespace */
+
+TEST_CASE( "TM code matches the interpreter", "[TM]" ) {
+    check_engine(run_tm_codegen);
+}
+
+TEST_CASE( "TmCodeGenerator layout", "[TM]" ) {
+    Parser parser;
+    std::string input_data = "read x; write x + 1";
+    TreeNode * tree = parser.parse(input_data.c_str(), input_data.size());
+    Analyser analyser;
+    REQUIRE(analyser.analyse(tree) == 0);
+    FILE * tm = tmpfile();
+    TmCodeGenerator codegen(tm);
+    codegen.generate(tree, analyser.symtable().size());
+    std::string tm_code = read_all(tm);
+    fclose(tm);
+    REQUIRE(tm_code.find("* Standard prelude:\n"
+                         "  0:     LD  6,0(0) \tload maxaddress from location 0\n"
+                         "  1:     ST  0,0(0) \tclear location 0\n") != std::string::npos);
+    REQUIRE(tm_code.find("  2:     IN  0,0,0 \tread integer value\n"
+                         "  3:     ST  0,0(5) \tread: store value\n") != std::string::npos);
+    REQUIRE(tm_code.find("   HALT  0,0,0 ") != std::string::npos);
+    REQUIRE(codegen.size() == 11);
+    REQUIRE(codegen.data_size() == 1 + 1 + 1);
+}
+
+TEST_CASE( "TmSimulator runs classic TM code", "[TM]" ) {
+    // hand written, with a computed jump through a register and a return
+    // address in data memory, which take the exact path for register 7
+    std::string code =
+        "* sum 1..n with a subroutine\n"
+        "  0:     IN  1,0,0\n"
+        "  1:    LDC  2,0(0)     sum\n"
+        "  2:    LDA  3,2(7)     return address = 5\n"
+        "  3:     ST  3,10(0)\n"
+        "  4:    LDC  7,8(0)     call\n"
+        "  5:    OUT  2,0,0\n"
+        "  6:   HALT  0,0,0\n"
+        "  8:    ADD  2,2,1\n"
+        "  9:    LDC  4,1(0)\n"
+        " 10:    SUB  1,1,4\n"
+        " 11:    JGT  1,-4(7)\n"
+        " 12:     LD  7,10(0)    return\n";
+    int ret = -1;
+    REQUIRE(run_tm(code, "10", &ret) == "55\n");
+    REQUIRE(ret == 0);
+
+    REQUIRE(run_tm("0: LDC 1,0(0)\n1: DIV 0,0,1\n", "", &ret) == "");
+    REQUIRE(ret == -1);
+    REQUIRE(run_tm("0: LD 0,5(0)\n", "", &ret, 4) == "");
+    REQUIRE(ret == -1);
+    REQUIRE(run_tm("0: LDA 7,-5(7)\n", "", &ret) == "");
+    REQUIRE(ret == -1);
+    // falls through the unloaded locations, which hold HALT
+    REQUIRE(run_tm("0: LDC 0,7(0)\n1: OUT 0,0,0\n", "", &ret) == "7\n");
+    REQUIRE(ret == 0);
+
+    FILE * bad = tmpfile();
+    fputs("0: FOO 1,2,3\n", bad);
+    rewind(bad);
+    TmSimulator sim;
+    REQUIRE(sim.load(bad) == -1);
+    fclose(bad);
+}
@@ -0,0 +1,117 @@
+/*
+ * test_xref.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "catch.hpp"
+
+#include "../analyser.h"
+#include "../xref.h"
+#include <cstdio>
+#include <string>
+
+using namespace tinylang;
+
+TEST_CASE( "XrefIndex queries", "[Xref]" ) {
+    //                        0         1         2         3
+    //                        0123456789012345678901234567890123456
+    std::string input_data = "read xx; y := xx * 2; write y + zz";
+    Parser parser;
+    TreeNode * tree = parser.parse(input_data.c_str(), input_data.size());
+    Analyser analyser;
+    XrefIndex index;
+    XrefBuilder builder(&index, analyser.symtable(), index.add_file("a.tny"));
+    analyser.analyse_with(tree, builder);
+    index.finish();
+
+    REQUIRE(index.size() == 2);
+    int xx = index.lookup("xx");
+    REQUIRE(xx >= 0);
+    REQUIRE(index.defs(xx) == std::vector<XrefSite>({{0, 5}}));
+    REQUIRE(index.uses(xx) == std::vector<XrefSite>({{0, 14}}));
+    int y = index.lookup("y");
+    REQUIRE(index.defs(y) == std::vector<XrefSite>({{0, 9}}));
+    REQUIRE(index.uses(y) == std::vector<XrefSite>({{0, 28}}));
+    // undeclared names are not indexed
+    REQUIRE(index.lookup("zz") == -1);
+
+    REQUIRE(index.symbol_at(0, 5) == xx);
+    REQUIRE(index.symbol_at(0, 6) == xx);
+    REQUIRE(index.symbol_at(0, 7) == -1);
+    REQUIRE(index.symbol_at(0, 15) == xx);
+    REQUIRE(index.symbol_at(0, 28) == y);
+    REQUIRE(index.symbol_at(0, 0) == -1);
+    REQUIRE(index.symbol_at(1, 5) == -1);
+}
+
+TEST_CASE( "XrefIndex save and load", "[Xref]" ) {
+    XrefIndex index;
+    int a = index.add_file("a.tny");
+    int b = index.add_file("b.tny");
+    Parser parser;
+    std::string first = "read n; m := n";
+    std::string second = "read m; write m";
+    Analyser analyser_a, analyser_b;
+    XrefBuilder builder_a(&index, analyser_a.symtable(), a);
+    analyser_a.analyse_with(parser.parse(first.c_str(), first.size()), builder_a);
+    XrefBuilder builder_b(&index, analyser_b.symtable(), b);
+    analyser_b.analyse_with(parser.parse(second.c_str(), second.size()), builder_b);
+    index.finish();
+    // one symbol per name across files
+    REQUIRE(index.size() == 2);
+    REQUIRE(index.defs(index.lookup("m")).size() == 2);
+
+    const char * path = "test_xref.idx";
+    REQUIRE(index.save(path) == 0);
+    XrefIndex loaded;
+    REQUIRE(loaded.load(path) == 0);
+    std::remove(path);
+    REQUIRE(loaded.file_count() == 2);
+    REQUIRE(loaded.file(b) == "b.tny");
+    REQUIRE(loaded.size() == index.size());
+    for (size_t id = 0; id < index.size(); ++id) {
+        int other = loaded.lookup(index.symbol(id).name.c_str());
+        REQUIRE(loaded.defs(other) == index.defs(id));
+        REQUIRE(loaded.uses(other) == index.uses(id));
+    }
+    REQUIRE(loaded.symbol_at(b, 14) == loaded.lookup("m"));
+    REQUIRE(loaded.load("no/such/index") != 0);
+}
+
+TEST_CASE( "XrefIndex rejects counts larger than the file", "[Xref]" ) {
+    const char * path = "test_xref_bad.idx";
+    // files, a file name length, symbols and a site count out of range
+    const uint32_t cases[][7] = {
+        {0x46525854, 1, 0xffffffff, 0, 0, 0, 0},
+        {0x46525854, 1, 1, 0x7fffffff, 0, 0, 0},
+        {0x46525854, 1, 0, 0xffffffff, 0, 0, 0},
+        {0x46525854, 1, 0, 1, 0, 0x20000000, 0},
+    };
+    for (const auto & words : cases) {
+        FILE * fp = fopen(path, "wb");
+        REQUIRE(fp != nullptr);
+        fwrite(words, sizeof(words), 1, fp);
+        fclose(fp);
+        XrefIndex index;
+        REQUIRE(index.load(path) == -1);
+        REQUIRE(index.size() == 0);
+    }
+    std::remove(path);
+}
+
+TEST_CASE( "XrefIndex rejects sites in unknown files", "[Xref]" ) {
+    const char * path = "test_xref_bad.idx";
+    XrefIndex index;
+    int file = index.add_file("a.tny");
+    int x = index.add_symbol("x");
+    index.add_def(x, file, 0);
+    index.add_use(x, file + 1, 5); // the file index is corrupted
+    REQUIRE(index.save(path) == 0);
+    XrefIndex loaded;
+    REQUIRE(loaded.load(path) == -1);
+    REQUIRE(loaded.size() == 0);
+    REQUIRE(loaded.file_count() == 0);
+    std::remove(path);
+}
@@ -0,0 +1,164 @@
+/*
+ * tm_codegen.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "tm_codegen.h"
+#include <algorithm>
+
+namespace tinylang {
+
+// registers of the TM conventions
+static const int ac = 0;
+static const int ac1 = 1;
+static const int gp = 5;
+static const int mp = 6;
+static const int pc = 7;
+
+void TmCodeGenerator::emit_comment(const char * c) {
+    fprintf(out_, "* %s\n", c);
+}
+
+void TmCodeGenerator::emit_ro(const char * op, int r, int s, int t, const char * c) {
+    fprintf(out_, "%3d:  %5s  %d,%d,%d \t%s\n", emit_loc_++, op, r, s, t, c);
+    high_loc_ = std::max(high_loc_, emit_loc_);
+}
+
+void TmCodeGenerator::emit_rm(const char * op, int r, int d, int s, const char * c) {
+    fprintf(out_, "%3d:  %5s  %d,%d(%d) \t%s\n", emit_loc_++, op, r, d, s, c);
+    high_loc_ = std::max(high_loc_, emit_loc_);
+}
+
+void TmCodeGenerator::emit_rm_abs(const char * op, int r, int a, const char * c) {
+    this->emit_rm(op, r, a - (emit_loc_ + 1), pc, c);
+}
+
+int TmCodeGenerator::emit_skip(int count) {
+    int loc = emit_loc_;
+    emit_loc_ += count;
+    high_loc_ = std::max(high_loc_, emit_loc_);
+    return loc;
+}
+
+void TmCodeGenerator::generate(TreeNode * tree, size_t slots) {
+    emit_loc_ = high_loc_ = tmp_offset_ = 0;
+    max_temps_ = 0;
+    slots_ = slots;
+    this->emit_comment("TINY Compilation to TM Code");
+    this->emit_comment("Standard prelude:");
+    this->emit_rm("LD", mp, 0, ac, "load maxaddress from location 0");
+    this->emit_rm("ST", ac, 0, ac, "clear location 0");
+    this->emit_comment("End of standard prelude.");
+    this->stmt_sequence(tree);
+    this->emit_comment("End of execution.");
+    this->emit_ro("HALT", 0, 0, 0, "");
+}
+
+void TmCodeGenerator::stmt_sequence(TreeNode * t) {
+    for (; t != nullptr; t = t->neighbor) {
+        switch (t->stmt) {
+            case StmtIf: {
+                this->emit_comment("-> if");
+                this->expr(t->children[0]);
+                int to_else = this->emit_skip(1);
+                this->emit_comment("if: jump to else belongs here");
+                this->stmt_sequence(t->children[1]);
+                int to_end = this->emit_skip(1);
+                this->emit_comment("if: jump to end belongs here");
+                int loc = this->emit_skip(0);
+                this->emit_backup(to_else);
+                this->emit_rm_abs("JEQ", ac, loc, "if: jmp to else");
+                this->emit_restore();
+                this->stmt_sequence(t->children[2]);
+                loc = this->emit_skip(0);
+                this->emit_backup(to_end);
+                this->emit_rm_abs("LDA", pc, loc, "jmp to end");
+                this->emit_restore();
+                this->emit_comment("<- if");
+                break;
+            }
+            case StmtRepeat: {
+                this->emit_comment("-> repeat");
+                int body = this->emit_skip(0);
+                this->emit_comment("repeat: jump after body comes back here");
+                this->stmt_sequence(t->children[0]);
+                this->expr(t->children[1]);
+                this->emit_rm_abs("JEQ", ac, body, "repeat: jmp back to body");
+                this->emit_comment("<- repeat");
+                break;
+            }
+            case StmtAssign:
+                this->emit_comment("-> assign");
+                this->expr(t->children[0]);
+                this->emit_rm("ST", ac, t->slot, gp, "assign: store value");
+                this->emit_comment("<- assign");
+                break;
+            case StmtRead:
+                this->emit_ro("IN", ac, 0, 0, "read integer value");
+                this->emit_rm("ST", ac, t->slot, gp, "read: store value");
+                break;
+            case StmtWrite:
+                this->expr(t->children[0]);
+                this->emit_ro("OUT", ac, 0, 0, "write ac");
+                break;
+        }
+    }
+}
+
+void TmCodeGenerator::expr(TreeNode * e) {
+    if (e->expr == ExprConst) {
+        this->emit_rm("LDC", ac, e->attr.val, 0, "load const");
+        return;
+    }
+    if (e->expr == ExprIdentifier) {
+        this->emit_rm("LD", ac, e->slot, gp, "load id value");
+        return;
+    }
+    this->emit_comment("-> Op");
+    this->expr(e->children[0]);
+    this->emit_rm("ST", ac, tmp_offset_--, mp, "op: push left");
+    max_temps_ = std::max(max_temps_, static_cast<size_t>(-tmp_offset_));
+    this->expr(e->children[1]);
+    this->emit_rm("LD", ac1, ++tmp_offset_, mp, "op: load left");
+    switch (e->attr.op) {
+        case TokenType::PLUS:
+            this->emit_ro("ADD", ac, ac1, ac, "op +");
+            break;
+        case TokenType::MINUS:
+            this->emit_ro("SUB", ac, ac1, ac, "op -");
+            break;
+        case TokenType::TIMES:
+            this->emit_ro("MUL", ac, ac1, ac, "op *");
+            break;
+        case TokenType::OVER:
+            this->emit_ro("DIV", ac, ac1, ac, "op /");
+            break;
+        case TokenType::LT:
+            // by the signs unless they are the same, where ac1 - ac can
+            // not overflow
+            this->emit_rm("JGE", ac1, 2, pc, "left >= 0: compare signs");
+            this->emit_rm("JGE", ac, 6, pc, "left < 0 <= right: true");
+            this->emit_rm("LDA", pc, 1, pc, "both < 0: subtract");
+            this->emit_rm("JLT", ac, 2, pc, "right < 0 <= left: false");
+            this->emit_ro("SUB", ac, ac1, ac, "op <");
+            this->emit_rm("JLT", ac, 2, pc, "br if true");
+            this->emit_rm("LDC", ac, 0, ac, "false case");
+            this->emit_rm("LDA", pc, 1, pc, "unconditional jmp");
+            this->emit_rm("LDC", ac, 1, ac, "true case");
+            break;
+        case TokenType::EQ:
+            this->emit_ro("SUB", ac, ac1, ac, "op ==");
+            this->emit_rm("JEQ", ac, 2, pc, "br if true");
+            this->emit_rm("LDC", ac, 0, ac, "false case");
+            this->emit_rm("LDA", pc, 1, pc, "unconditional jmp");
+            this->emit_rm("LDC", ac, 1, ac, "true case");
+            break;
+        default:
+            break;
+    }
+    this->emit_comment("<- Op");
+}
+
+} /* namespace tinylang */
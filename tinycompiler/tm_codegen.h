@@ -0,0 +1,66 @@
+/*
+ * tm_codegen.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef TM_CODEGEN_H
+#define TM_CODEGEN_H
+
+#include "parser.h"
+#include <cstdio>
+
+namespace tinylang {
+
+/**
+ * @brief Generate code for the TM (Tiny Machine) of Louden's book.
+ *  The output is TM assembly in the classic layout and with the classic
+ *  register conventions: ac = 0, ac1 = 1, gp = 5, mp = 6, pc = 7. The
+ *  variable of slot s lives at s(gp), temporaries are pushed below mp.
+ *  Backpatched jumps are written when their target is known, so the
+ *  instructions are not in address order, as with the original cgen.
+ *
+ *  Unlike the original, LT compares the signs before subtracting, so
+ *  a < b is right even when a - b overflows.
+ */
+class TmCodeGenerator {
+public:
+    explicit TmCodeGenerator(FILE * out = stdout) : out_(out) {}
+
+    void generate(TreeNode * tree, size_t slots);
+
+    //! @brief Data memory the generated code needs, in words
+    size_t data_size() const { return slots_ + max_temps_ + 1; }
+
+    //! @brief Number of instructions generated
+    int size() const { return high_loc_; }
+
+private:
+    void stmt_sequence(TreeNode * t);
+    void expr(TreeNode * e);
+
+    void emit_comment(const char * c);
+    void emit_ro(const char * op, int r, int s, int t, const char * c);
+    void emit_rm(const char * op, int r, int d, int s, const char * c);
+    //! @brief emit_rm with pc relative addressing of an absolute location
+    void emit_rm_abs(const char * op, int r, int a, const char * c);
+
+    //! @brief Leave room for the given number of instructions
+    //! @return the location before skipping
+    int emit_skip(int count);
+    void emit_backup(int loc) { emit_loc_ = loc; }
+    void emit_restore() { emit_loc_ = high_loc_; }
+
+private:
+    FILE * out_;
+    int emit_loc_ = 0;
+    int high_loc_ = 0;
+    int tmp_offset_ = 0; // of the next temporary from mp, zero or negative
+    size_t max_temps_ = 0;
+    size_t slots_ = 0;
+};
+
+} /* namespace tinylang */
+
+#endif /* !TM_CODEGEN_H */
@@ -0,0 +1,355 @@
+/*
+ * tm_simulator.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "tm_simulator.h"
+#include "interpreter.h"
+#include "vm_dispatch.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#define VM_FETCH() (++steps, (pc++)->op)
+
+namespace tinylang {
+
+/**
+ * Predecoded operations. D_JUMP and the conditional jumps have an absolute
+ * target in d; D_SLOW runs the instruction at its location exactly and
+ * D_IMEM_ERR is the sentinel for locations out of the instruction memory.
+ */
+#define TINY_TM_DECODED(X)                                          \
+    X(D_HALT) X(D_IN) X(D_OUT) X(D_ADD) X(D_SUB) X(D_MUL) X(D_DIV)  \
+    X(D_LD) X(D_ST) X(D_LDA) X(D_LDC) X(D_JUMP)                     \
+    X(D_JLT) X(D_JLE) X(D_JGE) X(D_JGT) X(D_JEQ) X(D_JNE)           \
+    X(D_SLOW) X(D_IMEM_ERR)
+
+enum DecodedOp : uint8_t {
+#define TINY_TM_DECODED_ENUM(op) op,
+    TINY_TM_DECODED(TINY_TM_DECODED_ENUM)
+#undef TINY_TM_DECODED_ENUM
+};
+
+static const char * const TM_OPCODE_NAMES[TM_OPCODE_COUNT] = {
+    "HALT", "IN", "OUT", "ADD", "SUB", "MUL", "DIV",
+    "LD", "ST", "LDA", "LDC",
+    "JLT", "JLE", "JGE", "JGT", "JEQ", "JNE"
+};
+
+// the classic instruction memory size, filled with HALT
+static const size_t IADDR_SIZE = 1024;
+static const int PC_REG = 7;
+
+int TmSimulator::load(FILE * fp) {
+    imem_.assign(IADDR_SIZE, TmInstruction{TM_HALT, 0, 0, 0, 0});
+    code_.clear();
+    char line[1024];
+    for (int line_no = 1; fgets(line, sizeof(line), fp) != nullptr; ++line_no) {
+        if (strchr(line, '\n') == nullptr && !feof(fp)) {
+            // skip the rest of an overlong line, a comment in practice
+            for (int c = fgetc(fp); c != EOF && c != '\n'; c = fgetc(fp)) {}
+        }
+        const char * p = line;
+        while (isspace(static_cast<unsigned char>(*p)))
+            ++p;
+        if (*p == '\0' || *p == '*')
+            continue;
+        int loc = 0, n = 0;
+        char name[16];
+        if (sscanf(p, "%d : %15[A-Za-z] %n", &loc, name, &n) < 2 || loc < 0) {
+            printf("error: line %d: expect location and opcode\n", line_no);
+            return -1;
+        }
+        int op = 0;
+        while (op < TM_OPCODE_COUNT && strcmp(name, TM_OPCODE_NAMES[op]) != 0)
+            ++op;
+        if (op == TM_OPCODE_COUNT) {
+            printf("error: line %d: unknown opcode %s\n", line_no, name);
+            return -1;
+        }
+        TmInstruction ins = {static_cast<TmOpcode>(op), 0, 0, 0, 0};
+        bool ok = op <= TM_DIV
+                      ? sscanf(p + n, "%d , %d , %d", &ins.r, &ins.s, &ins.t) == 3
+                      : sscanf(p + n, "%d , %d ( %d )", &ins.r, &ins.d, &ins.s) == 3;
+        if (!ok || ins.r < 0 || ins.r > 7 || ins.s < 0 || ins.s > 7 ||
+            ins.t < 0 || ins.t > 7) {
+            printf("error: line %d: bad operands\n", line_no);
+            return -1;
+        }
+        this->set_instruction(loc, ins);
+    }
+    return 0;
+}
+
+void TmSimulator::set_instruction(int loc, const TmInstruction & ins) {
+    if (static_cast<size_t>(loc) >= imem_.size())
+        imem_.resize(std::max<size_t>(loc + 1, IADDR_SIZE),
+                     TmInstruction{TM_HALT, 0, 0, 0, 0});
+    imem_[loc] = ins;
+    code_.clear();
+}
+
+void TmSimulator::predecode() {
+    int n = imem_.size();
+    code_.resize(n + 1);
+    // a target out of the instruction memory goes to the sentinel
+    auto target = [n](int64_t loc) {
+        return loc >= 0 && loc < n ? static_cast<int32_t>(loc) : n;
+    };
+    for (int loc = 0; loc < n; ++loc) {
+        const TmInstruction & ins = imem_[loc];
+        Decoded & dec = code_[loc];
+        dec = Decoded{D_SLOW, static_cast<uint8_t>(ins.r), static_cast<uint8_t>(ins.s),
+                      static_cast<uint8_t>(ins.t), ins.d};
+        bool uses_pc = ins.r == PC_REG || ins.s == PC_REG || ins.t == PC_REG;
+        switch (ins.op) {
+            case TM_HALT:
+                dec.op = D_HALT;
+                break;
+            case TM_IN:
+            case TM_OUT:
+                if (ins.r != PC_REG)
+                    dec.op = ins.op == TM_IN ? D_IN : D_OUT;
+                break;
+            case TM_ADD: case TM_SUB: case TM_MUL: case TM_DIV:
+                if (!uses_pc)
+                    dec.op = D_ADD + (ins.op - TM_ADD);
+                break;
+            case TM_LD: case TM_ST: case TM_LDA:
+                if (!uses_pc) {
+                    dec.op = D_LD + (ins.op - TM_LD);
+                } else if (ins.op == TM_LDA && ins.r == PC_REG && ins.s == PC_REG) {
+                    dec.op = D_JUMP;
+                    dec.d = target(static_cast<int64_t>(loc) + 1 + ins.d);
+                }
+                break;
+            case TM_LDC:
+                if (ins.r != PC_REG) {
+                    dec.op = D_LDC;
+                } else {
+                    dec.op = D_JUMP;
+                    dec.d = target(ins.d);
+                }
+                break;
+            default: // conditional jumps
+                if (ins.r != PC_REG && ins.s == PC_REG) {
+                    dec.op = D_JLT + (ins.op - TM_JLT);
+                    dec.d = target(static_cast<int64_t>(loc) + 1 + ins.d);
+                }
+                break;
+        }
+    }
+    code_[n] = Decoded{D_IMEM_ERR, 0, 0, 0, 0};
+}
+
+void TmSimulator::error(const char * msg, int loc) {
+    runtime_error("tm:%d: runtime error: %s\n", loc, msg);
+}
+
+int TmSimulator::step_slow(int loc) {
+    const TmInstruction & ins = imem_[loc];
+    int * reg = reg_;
+    reg[PC_REG] = loc + 1;
+    int m = static_cast<unsigned>(reg[ins.s]) + ins.d;
+    bool in_data = m >= 0 && static_cast<size_t>(m) < data_.size();
+    switch (ins.op) {
+        case TM_HALT:
+            break;
+        case TM_IN: {
+            int v = 0;
+            if (fscanf(in_, "%d", &v) != 1)
+                v = 0;
+            reg[ins.r] = v;
+            break;
+        }
+        case TM_OUT:
+            fprintf(out_, "%d\n", reg[ins.r]);
+            break;
+        case TM_ADD:
+            reg[ins.r] = static_cast<unsigned>(reg[ins.s]) + reg[ins.t];
+            break;
+        case TM_SUB:
+            reg[ins.r] = static_cast<unsigned>(reg[ins.s]) - reg[ins.t];
+            break;
+        case TM_MUL:
+            reg[ins.r] = static_cast<unsigned>(reg[ins.s]) * reg[ins.t];
+            break;
+        case TM_DIV:
+            if (reg[ins.t] == 0) {
+                this->error("division by zero", loc);
+                return -1;
+            }
+            reg[ins.r] = tiny_divide(reg[ins.s], reg[ins.t]);
+            break;
+        case TM_LD:
+        case TM_ST:
+            if (!in_data) {
+                this->error("data memory out of range", loc);
+                return -1;
+            }
+            if (ins.op == TM_LD) {
+                reg[ins.r] = data_[m];
+            } else {
+                data_[m] = reg[ins.r];
+            }
+            break;
+        case TM_LDA:
+            reg[ins.r] = m;
+            break;
+        case TM_LDC:
+            reg[ins.r] = ins.d;
+            break;
+        case TM_JLT: if (reg[ins.r] < 0) reg[PC_REG] = m; break;
+        case TM_JLE: if (reg[ins.r] <= 0) reg[PC_REG] = m; break;
+        case TM_JGE: if (reg[ins.r] >= 0) reg[PC_REG] = m; break;
+        case TM_JGT: if (reg[ins.r] > 0) reg[PC_REG] = m; break;
+        case TM_JEQ: if (reg[ins.r] == 0) reg[PC_REG] = m; break;
+        case TM_JNE: if (reg[ins.r] != 0) reg[PC_REG] = m; break;
+        default:
+            break;
+    }
+    int next = reg[PC_REG];
+    return next >= 0 && static_cast<size_t>(next) < imem_.size()
+               ? next : static_cast<int>(imem_.size());
+}
+
+int TmSimulator::run(size_t data_size) {
+#ifdef TINY_VM_COMPUTED_GOTO
+    static void * const labels[] = {
+#define TINY_TM_DECODED_LABEL(op) &&L_##op,
+        TINY_TM_DECODED(TINY_TM_DECODED_LABEL)
+#undef TINY_TM_DECODED_LABEL
+    };
+#endif
+    if (imem_.empty())
+        imem_.assign(IADDR_SIZE, TmInstruction{TM_HALT, 0, 0, 0, 0});
+    if (code_.empty())
+        this->predecode();
+    data_.assign(std::max<size_t>(data_size, 1), 0);
+    data_[0] = data_.size() - 1;
+    memset(reg_, 0, sizeof(reg_));
+    const Decoded * code = code_.data();
+    const Decoded * pc = code;
+    int * reg = reg_;
+    int * mem = data_.data();
+    const int64_t mem_size = data_.size();
+    size_t steps = 0;
+    int ret = 0;
+    int64_t m;
+
+// fields of the instruction being executed
+#define IR pc[-1].r
+#define IS pc[-1].s
+#define IT pc[-1].t
+#define ID pc[-1].d
+#define LOC static_cast<int>(pc - 1 - code)
+
+    VM_SWITCH(VM_FETCH()) {
+        VM_CASE(D_HALT)
+            goto done;
+        VM_CASE(D_IN) {
+            int v = 0;
+            if (fscanf(in_, "%d", &v) != 1)
+                v = 0;
+            reg[IR] = v;
+            VM_NEXT();
+        }
+        VM_CASE(D_OUT)
+            fprintf(out_, "%d\n", reg[IR]);
+            VM_NEXT();
+        // wrap around through unsigned arithmetic
+        VM_CASE(D_ADD)
+            reg[IR] = static_cast<unsigned>(reg[IS]) + reg[IT];
+            VM_NEXT();
+        VM_CASE(D_SUB)
+            reg[IR] = static_cast<unsigned>(reg[IS]) - reg[IT];
+            VM_NEXT();
+        VM_CASE(D_MUL)
+            reg[IR] = static_cast<unsigned>(reg[IS]) * reg[IT];
+            VM_NEXT();
+        VM_CASE(D_DIV)
+            if (reg[IT] == 0) {
+                this->error("division by zero", LOC);
+                ret = -1;
+                goto done;
+            }
+            reg[IR] = tiny_divide(reg[IS], reg[IT]);
+            VM_NEXT();
+        VM_CASE(D_LD)
+            m = static_cast<int64_t>(reg[IS]) + ID;
+            if (m < 0 || m >= mem_size)
+                goto data_error;
+            reg[IR] = mem[m];
+            VM_NEXT();
+        VM_CASE(D_ST)
+            m = static_cast<int64_t>(reg[IS]) + ID;
+            if (m < 0 || m >= mem_size)
+                goto data_error;
+            mem[m] = reg[IR];
+            VM_NEXT();
+        VM_CASE(D_LDA)
+            reg[IR] = static_cast<unsigned>(reg[IS]) + ID;
+            VM_NEXT();
+        VM_CASE(D_LDC)
+            reg[IR] = ID;
+            VM_NEXT();
+        VM_CASE(D_JUMP)
+            pc = code + ID;
+            VM_NEXT();
+        VM_CASE(D_JLT)
+            if (reg[IR] < 0) pc = code + ID;
+            VM_NEXT();
+        VM_CASE(D_JLE)
+            if (reg[IR] <= 0) pc = code + ID;
+            VM_NEXT();
+        VM_CASE(D_JGE)
+            if (reg[IR] >= 0) pc = code + ID;
+            VM_NEXT();
+        VM_CASE(D_JGT)
+            if (reg[IR] > 0) pc = code + ID;
+            VM_NEXT();
+        VM_CASE(D_JEQ)
+            if (reg[IR] == 0) pc = code + ID;
+            VM_NEXT();
+        VM_CASE(D_JNE)
+            if (reg[IR] != 0) pc = code + ID;
+            VM_NEXT();
+        VM_CASE(D_SLOW) {
+            int next = this->step_slow(LOC);
+            if (next < 0) {
+                ret = -1;
+                goto done;
+            }
+            pc = code + next;
+            VM_NEXT();
+        }
+        VM_CASE(D_IMEM_ERR)
+            runtime_error("tm: runtime error: jump out of instruction memory\n");
+            ret = -1;
+            goto done;
+#ifndef TINY_VM_COMPUTED_GOTO
+        default:
+            ret = -1;
+            goto done;
+#endif
+    }
+
+data_error:
+    this->error("data memory out of range", LOC);
+    ret = -1;
+#undef IR
+#undef IS
+#undef IT
+#undef ID
+#undef LOC
+
+done:
+    steps_ = steps;
+    fflush(out_);
+    return ret;
+}
+
+} /* namespace tinylang */
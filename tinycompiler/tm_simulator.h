@@ -0,0 +1,99 @@
+/*
+ * tm_simulator.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef TM_SIMULATOR_H
+#define TM_SIMULATOR_H
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace tinylang {
+
+//! @brief Instructions of the TM
+enum TmOpcode {
+    TM_HALT, TM_IN, TM_OUT, TM_ADD, TM_SUB, TM_MUL, TM_DIV, // RO: r,s,t
+    TM_LD, TM_ST, TM_LDA, TM_LDC,                           // RM: r,d(s)
+    TM_JLT, TM_JLE, TM_JGE, TM_JGT, TM_JEQ, TM_JNE,
+    TM_OPCODE_COUNT
+};
+
+struct TmInstruction {
+    TmOpcode op;
+    int r;
+    int s; // base register of RM instructions
+    int t;
+    int d;
+};
+
+/**
+ * @brief Simulator of the TM (Tiny Machine) of Louden's book.
+ *  It loads the classic TM assembly, then predecodes the instructions into
+ *  a dense array where the pc relative jumps have absolute targets and
+ *  dispatches them by computed goto (see vm_dispatch.h). Register 7 is
+ *  the pc; an instruction that reads or writes it in any other way runs
+ *  on a slower path that keeps it exact.
+ *
+ *  Unloaded locations hold HALT, as in the original. IN reads an integer,
+ *  0 at the end of the input, and OUT prints one per line, without the
+ *  prompts of the interactive original. Arithmetic wraps in 32 bits.
+ */
+class TmSimulator {
+public:
+    TmSimulator(FILE * in = stdin, FILE * out = stdout) : in_(in), out_(out) {}
+
+    /**
+     * @brief Load a TM program, replacing the previous one.
+     * @return 0 for success, -1 after reporting a malformed line
+     */
+    int load(FILE * fp);
+
+    //! @brief Location of an instruction, replacing the one there
+    void set_instruction(int loc, const TmInstruction & ins);
+
+    /**
+     * @brief Run from location 0 with the given words of data memory.
+     * @return 0 after HALT, -1 after a run-time error
+     */
+    int run(size_t data_size = 1024);
+
+    //! @brief Instructions executed by the last run
+    size_t steps() const { return steps_; }
+
+    int reg(int r) const { return reg_[r]; }
+    const std::vector<int> & data() const { return data_; }
+
+private:
+    struct Decoded {
+        uint8_t op; // of TINY_TM_DECODED
+        uint8_t r;
+        uint8_t s;
+        uint8_t t;
+        int32_t d; // displacement, constant or absolute target
+    };
+
+    void predecode();
+
+    //! @brief Execute an instruction exactly, with reg 7 = loc + 1
+    //! @return the next location, or -1 after a run-time error
+    int step_slow(int loc);
+
+    void error(const char * msg, int loc);
+
+private:
+    FILE * in_;
+    FILE * out_;
+    std::vector<TmInstruction> imem_;
+    std::vector<Decoded> code_; // predecoded imem_, then an error sentinel
+    std::vector<int> data_;
+    int reg_[8] = {0};
+    size_t steps_ = 0;
+};
+
+} /* namespace tinylang */
+
+#endif /* !TM_SIMULATOR_H */
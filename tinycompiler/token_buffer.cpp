@@ -0,0 +1,32 @@
+/*
+ * token_buffer.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "token_buffer.h"
+
+namespace tinylang {
+
+constexpr size_t TokenBuffer::CAPACITY;
+constexpr size_t TokenBuffer::MASK;
+
+void TokenBuffer::fill() {
+    while (count_ < CAPACITY && !at_end_) {
+        Token &token = ring_[(head_ + count_) & MASK];
+        token = scanner_->scan();
+        ++count_;
+        at_end_ = token.type == TokenType::ENDFILE;
+    }
+}
+
+void TokenBuffer::finish() {
+    Token &token = ring_[head_];
+    token.type = TokenType::ENDFILE;
+    token.len = 0;
+    count_ = 1;
+    at_end_ = true;
+}
+
+} /* namespace tinylang */
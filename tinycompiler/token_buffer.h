@@ -0,0 +1,75 @@
+/*
+ * token_buffer.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef TOKEN_BUFFER_H
+#define TOKEN_BUFFER_H
+
+#include "scanner.h"
+
+namespace tinylang {
+
+/**
+ * @brief Fixed-size ring buffer of lookahead tokens.
+ *  Tokens are pulled from the scanner in batches, and any of the next
+ *  CAPACITY tokens can be inspected with peek() without rescanning.
+ *  Once the end of file is reached it is returned forever.
+ */
+class TokenBuffer {
+public:
+    static constexpr size_t CAPACITY = 64; // must be a power of two
+
+    //! @brief Start reading tokens from the scanner
+    void reset(Scanner *scanner) {
+        scanner_ = scanner;
+        head_ = 0;
+        count_ = 0;
+        at_end_ = false;
+    }
+
+    /**
+     * @brief Get the k-th token after the current one, peek(0) is the
+     *  current lookahead. k must be less than CAPACITY.
+     */
+    const Token &peek(size_t k = 0) {
+        if (k >= count_) {
+            this->fill();
+            if (k >= count_) {
+                k = count_ - 1; // at most the end of file
+            }
+        }
+        return ring_[(head_ + k) & MASK];
+    }
+
+    //! @brief Consume the current token
+    void advance() {
+        if (count_ == 0) {
+            this->fill();
+        }
+        if (count_ > 1 || !at_end_) {
+            head_ = (head_ + 1) & MASK;
+            --count_;
+        }
+    }
+
+    //! @brief Drop the remaining input, only the end of file is left
+    void finish();
+
+private:
+    void fill();
+
+private:
+    static constexpr size_t MASK = CAPACITY - 1;
+    Scanner *scanner_ = nullptr;
+    Token ring_[CAPACITY];
+    size_t head_ = 0;
+    size_t count_ = 0;
+    bool at_end_ = false; // the end of file is in the buffer
+};
+
+} /* namespace tinylang */
+
+#endif /* !TOKEN_BUFFER_H */
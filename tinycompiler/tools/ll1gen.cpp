@@ -0,0 +1,368 @@
+/*
+ * ll1gen.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+/*
+ * Build-time LL(1) table generator.
+ *
+ * Usage: ll1gen <grammar file> <output header>
+ *
+ * Reads a grammar in the format documented in tiny.grammar, computes the
+ * FIRST / FOLLOW sets and writes the predictive parsing table used by
+ * LL1Parser. Any LL(1) conflict fails the build.
+ */
+
+#include "../scanner.h"
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace tinylang;
+
+static const int TOKEN_COUNT = static_cast<int>(TokenType::TOKEN_TYPE_END_FLAG);
+static const int NT_BASE = 0x100;
+static const int ACT_BASE = 0x200;
+
+struct Production {
+    int lhs;
+    std::vector<int> rhs; // encoded symbols
+    int line_no;
+};
+
+struct Grammar {
+    std::vector<std::string> nonterminals;
+    std::vector<std::string> actions;
+    std::vector<Production> productions;
+    std::vector<int> nonterminal_lines; // line of definition, 0 if undefined
+    std::map<std::string, int> terminal_ids;
+};
+
+static bool is_terminal(int sym) { return sym < NT_BASE; }
+static bool is_nonterminal(int sym) { return sym >= NT_BASE && sym < ACT_BASE; }
+
+static int error(const std::string & msg, int line_no = 0) {
+    if (line_no > 0) {
+        fprintf(stderr, "tiny.grammar:%d: error: %s\n", line_no, msg.c_str());
+    } else {
+        fprintf(stderr, "ll1gen: error: %s\n", msg.c_str());
+    }
+    return -1;
+}
+
+static int intern(std::vector<std::string> & names, const std::string & name) {
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (names[i] == name)
+            return i;
+    }
+    names.push_back(name);
+    return names.size() - 1;
+}
+
+static int nonterminal_id(Grammar & g, const std::string & name) {
+    int id = intern(g.nonterminals, name);
+    g.nonterminal_lines.resize(g.nonterminals.size(), 0);
+    return id;
+}
+
+/**
+ * @brief Split the grammar source into words, keeping line numbers.
+ *  Quoted terminals keep their quotes so they can be told apart from ';'.
+ */
+static void tokenize(const std::string & src,
+                     std::vector<std::pair<std::string, int>> & words) {
+    int line_no = 1;
+    size_t i = 0;
+    while (i < src.size()) {
+        char c = src[i];
+        if (c == '\n') {
+            ++line_no;
+            ++i;
+        } else if (isspace(static_cast<unsigned char>(c))) {
+            ++i;
+        } else if (c == '#') {
+            while (i < src.size() && src[i] != '\n')
+                ++i;
+        } else if (c == '\'') {
+            size_t end = src.find('\'', i + 1);
+            if (end == std::string::npos)
+                end = src.size() - 1;
+            words.emplace_back(src.substr(i, end - i + 1), line_no);
+            i = end + 1;
+        } else if (c == '-' && i + 1 < src.size() && src[i + 1] == '>') {
+            words.emplace_back("->", line_no);
+            i += 2;
+        } else if (c == '|' || c == ';') {
+            words.emplace_back(std::string(1, c), line_no);
+            ++i;
+        } else {
+            size_t start = i;
+            while (i < src.size() && (isalnum(static_cast<unsigned char>(src[i])) ||
+                                      src[i] == '_' || src[i] == '@'))
+                ++i;
+            if (i == start) {
+                words.emplace_back(std::string(1, c), line_no);
+                ++i;
+            } else {
+                words.emplace_back(src.substr(start, i - start), line_no);
+            }
+        }
+    }
+}
+
+static int read_grammar(const std::string & src, Grammar & g) {
+    for (int t = 0; t < TOKEN_COUNT; ++t) {
+        std::string name = getTokenTypeName(static_cast<TokenType>(t));
+        if (!name.empty())
+            g.terminal_ids["'" + name + "'"] = t;
+    }
+
+    std::vector<std::pair<std::string, int>> words;
+    tokenize(src, words);
+    size_t i = 0;
+    while (i < words.size()) {
+        const std::string & lhs = words[i].first;
+        int line_no = words[i].second;
+        if (i + 1 >= words.size() || words[i + 1].first != "->" ||
+            !(isalpha(static_cast<unsigned char>(lhs[0])) || lhs[0] == '_')) {
+            return error("expect 'nonterminal ->'", line_no);
+        }
+        int lhs_id = nonterminal_id(g, lhs);
+        if (g.nonterminal_lines[lhs_id] != 0) {
+            return error("nonterminal '" + lhs + "' defined twice", line_no);
+        }
+        g.nonterminal_lines[lhs_id] = line_no;
+        i += 2;
+        Production prod{lhs_id, {}, line_no};
+        for (; i < words.size(); ++i) {
+            const std::string & w = words[i].first;
+            if (w == "|" || w == ";") {
+                g.productions.push_back(prod);
+                prod.rhs.clear();
+                prod.line_no = words[i].second;
+                if (w == ";") {
+                    ++i;
+                    break;
+                }
+            } else if (w[0] == '\'') {
+                auto iter = g.terminal_ids.find(w);
+                if (iter == g.terminal_ids.end()) {
+                    return error("unknown terminal " + w, words[i].second);
+                }
+                prod.rhs.push_back(iter->second);
+            } else if (w[0] == '@') {
+                prod.rhs.push_back(ACT_BASE + intern(g.actions, w.substr(1)));
+            } else if (isalpha(static_cast<unsigned char>(w[0])) || w[0] == '_') {
+                prod.rhs.push_back(NT_BASE + nonterminal_id(g, w));
+            } else {
+                return error("unexpected '" + w + "'", words[i].second);
+            }
+        }
+    }
+    if (g.productions.empty()) {
+        return error("empty grammar");
+    }
+    for (size_t n = 0; n < g.nonterminals.size(); ++n) {
+        if (g.nonterminal_lines[n] == 0) {
+            return error("nonterminal '" + g.nonterminals[n] + "' is never defined");
+        }
+    }
+    return 0;
+}
+
+using TerminalSet = std::vector<bool>;
+
+static bool merge(TerminalSet & dst, const TerminalSet & src) {
+    bool changed = false;
+    for (int t = 0; t < TOKEN_COUNT; ++t) {
+        if (src[t] && !dst[t]) {
+            dst[t] = true;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+/**
+ * @brief FIRST set of a symbol string. Actions derive epsilon.
+ *
+ * @return true if the whole string is nullable
+ */
+static bool first_of(const std::vector<int> & syms, size_t from,
+                     const std::vector<TerminalSet> & first,
+                     const std::vector<bool> & nullable, TerminalSet & out) {
+    for (size_t i = from; i < syms.size(); ++i) {
+        int sym = syms[i];
+        if (is_terminal(sym)) {
+            out[sym] = true;
+            return false;
+        } else if (is_nonterminal(sym)) {
+            merge(out, first[sym - NT_BASE]);
+            if (!nullable[sym - NT_BASE])
+                return false;
+        }
+    }
+    return true;
+}
+
+static int build_table(const Grammar & g, std::vector<std::vector<int>> & table) {
+    size_t nt_count = g.nonterminals.size();
+    std::vector<TerminalSet> first(nt_count, TerminalSet(TOKEN_COUNT, false));
+    std::vector<TerminalSet> follow(nt_count, TerminalSet(TOKEN_COUNT, false));
+    std::vector<bool> nullable(nt_count, false);
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const auto & p : g.productions) {
+            TerminalSet set(TOKEN_COUNT, false);
+            bool eps = first_of(p.rhs, 0, first, nullable, set);
+            changed |= merge(first[p.lhs], set);
+            if (eps && !nullable[p.lhs]) {
+                nullable[p.lhs] = true;
+                changed = true;
+            }
+        }
+    }
+
+    follow[0][static_cast<int>(TokenType::ENDFILE)] = true;
+    changed = true;
+    while (changed) {
+        changed = false;
+        for (const auto & p : g.productions) {
+            for (size_t i = 0; i < p.rhs.size(); ++i) {
+                if (!is_nonterminal(p.rhs[i]))
+                    continue;
+                int b = p.rhs[i] - NT_BASE;
+                TerminalSet set(TOKEN_COUNT, false);
+                bool eps = first_of(p.rhs, i + 1, first, nullable, set);
+                changed |= merge(follow[b], set);
+                if (eps)
+                    changed |= merge(follow[b], follow[p.lhs]);
+            }
+        }
+    }
+
+    int ret = 0;
+    table.assign(nt_count, std::vector<int>(TOKEN_COUNT, -1));
+    for (size_t n = 0; n < g.productions.size(); ++n) {
+        const auto & p = g.productions[n];
+        TerminalSet predict(TOKEN_COUNT, false);
+        if (first_of(p.rhs, 0, first, nullable, predict))
+            merge(predict, follow[p.lhs]);
+        for (int t = 0; t < TOKEN_COUNT; ++t) {
+            if (!predict[t])
+                continue;
+            int & cell = table[p.lhs][t];
+            if (cell >= 0) {
+                std::string token_name = getTokenTypeName(static_cast<TokenType>(t));
+                ret = error("LL(1) conflict for '" + g.nonterminals[p.lhs] +
+                            "' on '" + (token_name.empty() ? "$" : token_name) +
+                            "' with the rule at line " +
+                            std::to_string(g.productions[cell].line_no), p.line_no);
+            } else {
+                cell = n;
+            }
+        }
+    }
+    return ret;
+}
+
+static void write_header(const Grammar & g, const std::vector<std::vector<int>> & table,
+                         std::ostream & os) {
+    os << "/*\n * ll1_table.h\n"
+       << " * Generated by ll1gen from tiny.grammar, do not edit.\n */\n\n"
+       << "#ifndef LL1_TABLE_H\n#define LL1_TABLE_H\n\n"
+       << "#include \"scanner.h\"\n\n"
+       << "namespace tinylang {\nnamespace ll1 {\n\n";
+
+    os << "enum NonTerminal {\n";
+    for (const auto & name : g.nonterminals)
+        os << "    NT_" << name << ",\n";
+    os << "    NT_COUNT\n};\n\n";
+
+    os << "enum Action {\n";
+    for (const auto & name : g.actions)
+        os << "    ACT_" << name << ",\n";
+    os << "    ACT_COUNT\n};\n\n";
+
+    os << "// Symbols on the parse stack: terminals are TokenType values,\n"
+       << "// nonterminals are NT_BASE + NonTerminal, actions ACT_BASE + Action.\n"
+       << "static const int NT_BASE = " << NT_BASE << ";\n"
+       << "static const int ACT_BASE = " << ACT_BASE << ";\n"
+       << "static const int TOKEN_COUNT = " << TOKEN_COUNT << ";\n"
+       << "static const int START_SYMBOL = NT_BASE + NT_"
+       << g.nonterminals[0] << ";\n\n";
+
+    os << "// Right hand sides in push order (reversed); production p spans\n"
+       << "// rhs_symbols[rhs_offset[p]] .. rhs_symbols[rhs_offset[p + 1] - 1]\n"
+       << "static const short rhs_symbols[] = {\n";
+    std::vector<int> offsets;
+    int offset = 0;
+    for (const auto & p : g.productions) {
+        offsets.push_back(offset);
+        os << "    ";
+        for (auto it = p.rhs.rbegin(); it != p.rhs.rend(); ++it)
+            os << *it << ", ";
+        os << "// " << g.nonterminals[p.lhs] << "\n";
+        offset += p.rhs.size();
+    }
+    offsets.push_back(offset);
+    os << "    0\n};\n\n";
+
+    os << "static const short rhs_offset[] = {\n   ";
+    for (int off : offsets)
+        os << " " << off << ",";
+    os << "\n};\n\n";
+
+    os << "// Production to expand for (nonterminal, lookahead), -1 for error\n"
+       << "static const short parse_table[NT_COUNT][TOKEN_COUNT] = {\n";
+    for (size_t n = 0; n < table.size(); ++n) {
+        os << "    {";
+        for (int cell : table[n])
+            os << " " << cell << ",";
+        os << " }, // " << g.nonterminals[n] << "\n";
+    }
+    os << "};\n\n";
+
+    os << "static const char * const nonterminal_names[NT_COUNT] = {\n";
+    for (const auto & name : g.nonterminals)
+        os << "    \"" << name << "\",\n";
+    os << "};\n\n";
+
+    os << "} /* namespace ll1 */\n} /* namespace tinylang */\n\n"
+       << "#endif /* !LL1_TABLE_H */\n";
+}
+
+int main(int argc, char * argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <grammar> <output header>\n", argv[0]);
+        return 1;
+    }
+    std::ifstream ifs(argv[1]);
+    if (!ifs) {
+        return error(std::string("cannot open ") + argv[1]) ? 1 : 0;
+    }
+    std::stringstream strbuf;
+    strbuf << ifs.rdbuf();
+
+    Grammar g;
+    std::vector<std::vector<int>> table;
+    if (read_grammar(strbuf.str(), g) != 0 || build_table(g, table) != 0) {
+        return 1;
+    }
+    std::ostringstream out;
+    write_header(g, table, out);
+    std::ofstream ofs(argv[2]);
+    if (!ofs) {
+        return error(std::string("cannot write ") + argv[2]) ? 1 : 0;
+    }
+    ofs << out.str();
+    return 0;
+}
@@ -0,0 +1,37 @@
+/*
+ * vm_dispatch.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef VM_DISPATCH_H
+#define VM_DISPATCH_H
+
+/**
+ * Instruction dispatch shared by the virtual machines. With GCC or Clang
+ * every handler jumps straight to the next one through a table of label
+ * addresses `labels`; other compilers, or a build with TINY_VM_SWITCH
+ * defined, loop over a switch. VM_FETCH() is the opcode of the next
+ * instruction, advancing the program counter.
+ *
+ *     VM_SWITCH(VM_FETCH()) {
+ *         VM_CASE(OP_X) ... VM_NEXT();
+ *     }
+ */
+
+#if defined(__GNUC__) && !defined(TINY_VM_SWITCH)
+#define TINY_VM_COMPUTED_GOTO
+#endif
+
+#ifdef TINY_VM_COMPUTED_GOTO
+#define VM_SWITCH(fetch) goto *labels[fetch];
+#define VM_CASE(op) L_##op:
+#define VM_NEXT() goto *labels[VM_FETCH()]
+#else
+#define VM_SWITCH(fetch) for (;;) switch (fetch)
+#define VM_CASE(op) case op:
+#define VM_NEXT() continue
+#endif
+
+#endif /* !VM_DISPATCH_H */
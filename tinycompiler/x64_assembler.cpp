@@ -0,0 +1,281 @@
+/*
+ * x64_assembler.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "x64_assembler.h"
+#include <cassert>
+#include <cstring>
+
+namespace tinylang {
+
+void X64Assembler::emit32(uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        code_.push_back((v >> (8 * i)) & 0xff);
+    }
+}
+
+void X64Assembler::rex(bool w, int reg, int base, bool force) {
+    uint8_t prefix = 0x40 | (w << 3) | ((reg >> 3) << 2) | (base >> 3);
+    if (prefix != 0x40 || force)
+        this->emit8(prefix);
+}
+
+void X64Assembler::modrm_reg(int reg, int rm) {
+    this->emit8(0xc0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+void X64Assembler::modrm_mem(int reg, int base, int32_t disp) {
+    assert((base & 7) != RSP);
+    this->emit8(0x80 | ((reg & 7) << 3) | (base & 7));
+    this->emit32(disp);
+}
+
+void X64Assembler::bind(Label & label) {
+    this->bind(label, code_.size());
+}
+
+void X64Assembler::bind(Label & label, long pos) {
+    label.pos = pos;
+    for (size_t at : label.fixups) {
+        uint32_t rel = label.pos - (at + 4);
+        memcpy(&code_[at], &rel, sizeof(rel));
+    }
+    label.fixups.clear();
+}
+
+void X64Assembler::rel32(Label & label) {
+    if (label.pos >= 0) {
+        this->emit32(label.pos - (code_.size() + 4));
+    } else {
+        label.fixups.push_back(code_.size());
+        this->emit32(0);
+    }
+}
+
+void X64Assembler::mov(X64Reg dst, X64Reg src) {
+    this->rex(false, src, dst);
+    this->emit8(0x89);
+    this->modrm_reg(src, dst);
+}
+
+void X64Assembler::mov(X64Reg dst, int32_t imm) {
+    this->rex(false, 0, dst);
+    this->emit8(0xb8 + (dst & 7));
+    this->emit32(imm);
+}
+
+void X64Assembler::mov64(X64Reg dst, X64Reg src) {
+    this->rex(true, src, dst);
+    this->emit8(0x89);
+    this->modrm_reg(src, dst);
+}
+
+void X64Assembler::mov64(X64Reg dst, uint64_t imm) {
+    this->rex(true, 0, dst);
+    this->emit8(0xb8 + (dst & 7));
+    this->emit32(imm);
+    this->emit32(imm >> 32);
+}
+
+void X64Assembler::load(X64Reg dst, X64Reg base, int32_t disp) {
+    this->rex(false, dst, base);
+    this->emit8(0x8b);
+    this->modrm_mem(dst, base, disp);
+}
+
+void X64Assembler::store(X64Reg base, int32_t disp, X64Reg src) {
+    this->rex(false, src, base);
+    this->emit8(0x89);
+    this->modrm_mem(src, base, disp);
+}
+
+void X64Assembler::store(X64Reg base, int32_t disp, int32_t imm) {
+    this->rex(false, 0, base);
+    this->emit8(0xc7);
+    this->modrm_mem(0, base, disp);
+    this->emit32(imm);
+}
+
+void X64Assembler::lea64(X64Reg dst, X64Reg base, int32_t disp) {
+    this->rex(true, dst, base);
+    this->emit8(0x8d);
+    this->modrm_mem(dst, base, disp);
+}
+
+void X64Assembler::lea64(X64Reg dst, Label & label) {
+    this->rex(true, dst, 0);
+    this->emit8(0x8d);
+    this->emit8(0x05 | ((dst & 7) << 3)); // [rip + rel32]
+    this->rel32(label);
+}
+
+void X64Assembler::load64(X64Reg dst, X64Reg base, int32_t disp) {
+    this->rex(true, dst, base);
+    this->emit8(0x8b);
+    this->modrm_mem(dst, base, disp);
+}
+
+void X64Assembler::store64(X64Reg base, int32_t disp, X64Reg src) {
+    this->rex(true, src, base);
+    this->emit8(0x89);
+    this->modrm_mem(src, base, disp);
+}
+
+void X64Assembler::load8(X64Reg dst, X64Reg base, int32_t disp) {
+    this->rex(false, dst, base);
+    this->emit8(0x0f);
+    this->emit8(0xb6);
+    this->modrm_mem(dst, base, disp);
+}
+
+void X64Assembler::store8(X64Reg base, int32_t disp, X64Reg src) {
+    // a REX prefix selects SIL / DIL rather than DH / BH
+    this->rex(false, src, base, src >= RSP);
+    this->emit8(0x88);
+    this->modrm_mem(src, base, disp);
+}
+
+void X64Assembler::alu(X64Alu op, X64Reg dst, X64Reg src) {
+    this->rex(false, src, dst);
+    this->emit8(op * 8 + 1);
+    this->modrm_reg(src, dst);
+}
+
+void X64Assembler::alu(X64Alu op, X64Reg dst, int32_t imm) {
+    this->rex(false, 0, dst);
+    this->emit8(0x81);
+    this->modrm_reg(op, dst);
+    this->emit32(imm);
+}
+
+void X64Assembler::alu(X64Alu op, X64Reg dst, X64Reg base, int32_t disp) {
+    this->rex(false, dst, base);
+    this->emit8(op * 8 + 3);
+    this->modrm_mem(dst, base, disp);
+}
+
+void X64Assembler::alu_store(X64Alu op, X64Reg base, int32_t disp, int32_t imm) {
+    this->rex(false, 0, base);
+    this->emit8(0x81);
+    this->modrm_mem(op, base, disp);
+    this->emit32(imm);
+}
+
+void X64Assembler::alu64(X64Alu op, X64Reg dst, X64Reg src) {
+    this->rex(true, src, dst);
+    this->emit8(op * 8 + 1);
+    this->modrm_reg(src, dst);
+}
+
+void X64Assembler::alu64(X64Alu op, X64Reg dst, int32_t imm) {
+    this->rex(true, 0, dst);
+    this->emit8(0x81);
+    this->modrm_reg(op, dst);
+    this->emit32(imm);
+}
+
+void X64Assembler::imul(X64Reg dst, X64Reg src) {
+    this->rex(false, dst, src);
+    this->emit8(0x0f);
+    this->emit8(0xaf);
+    this->modrm_reg(dst, src);
+}
+
+void X64Assembler::imul(X64Reg dst, X64Reg src, int32_t imm) {
+    this->rex(false, dst, src);
+    this->emit8(0x69);
+    this->modrm_reg(dst, src);
+    this->emit32(imm);
+}
+
+void X64Assembler::imul_mem(X64Reg dst, X64Reg base, int32_t disp) {
+    this->rex(false, dst, base);
+    this->emit8(0x0f);
+    this->emit8(0xaf);
+    this->modrm_mem(dst, base, disp);
+}
+
+void X64Assembler::test(X64Reg a, X64Reg b) {
+    this->rex(false, b, a);
+    this->emit8(0x85);
+    this->modrm_reg(b, a);
+}
+
+void X64Assembler::neg(X64Reg reg) {
+    this->rex(false, 0, reg);
+    this->emit8(0xf7);
+    this->modrm_reg(3, reg);
+}
+
+void X64Assembler::cdq() {
+    this->emit8(0x99);
+}
+
+void X64Assembler::idiv(X64Reg divisor) {
+    this->rex(false, 0, divisor);
+    this->emit8(0xf7);
+    this->modrm_reg(7, divisor);
+}
+
+void X64Assembler::div(X64Reg divisor) {
+    this->rex(false, 0, divisor);
+    this->emit8(0xf7);
+    this->modrm_reg(6, divisor);
+}
+
+void X64Assembler::setcc(X64Cond cond, X64Reg dst) {
+    // setcc al; movzx dst, al
+    this->emit8(0x0f);
+    this->emit8(0x90 + cond);
+    this->modrm_reg(0, RAX);
+    this->rex(false, dst, RAX);
+    this->emit8(0x0f);
+    this->emit8(0xb6);
+    this->modrm_reg(dst, RAX);
+}
+
+void X64Assembler::push64(X64Reg reg) {
+    this->rex(false, 0, reg);
+    this->emit8(0x50 + (reg & 7));
+}
+
+void X64Assembler::pop64(X64Reg reg) {
+    this->rex(false, 0, reg);
+    this->emit8(0x58 + (reg & 7));
+}
+
+void X64Assembler::jmp(Label & label) {
+    this->emit8(0xe9);
+    this->rel32(label);
+}
+
+void X64Assembler::jcc(X64Cond cond, Label & label) {
+    this->emit8(0x0f);
+    this->emit8(0x80 + cond);
+    this->rel32(label);
+}
+
+void X64Assembler::call(const void * target) {
+    this->mov64(RAX, reinterpret_cast<uint64_t>(target));
+    this->emit8(0xff);
+    this->modrm_reg(2, RAX);
+}
+
+void X64Assembler::call(Label & label) {
+    this->emit8(0xe8);
+    this->rel32(label);
+}
+
+void X64Assembler::ret() {
+    this->emit8(0xc3);
+}
+
+void X64Assembler::syscall() {
+    this->emit8(0x0f);
+    this->emit8(0x05);
+}
+
+} /* namespace tinylang */
@@ -0,0 +1,124 @@
+/*
+ * x64_assembler.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef X64_ASSEMBLER_H
+#define X64_ASSEMBLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tinylang {
+
+enum X64Reg {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15
+};
+
+//! @brief Condition codes of jcc / setcc
+enum X64Cond {
+    CondE = 0x4,
+    CondNE = 0x5,
+    CondBE = 0x6, // unsigned
+    CondA = 0x7,  // unsigned
+    CondL = 0xc,
+    CondGE = 0xd,
+    CondLE = 0xe
+};
+
+//! @brief Arithmetic operations sharing the classic ALU encodings
+enum X64Alu {
+    AluAdd = 0,
+    AluSub = 5,
+    AluCmp = 7
+};
+
+/**
+ * @brief Minimal x86-64 machine code emitter for the code generators.
+ *  Operations are on 32-bit registers unless the name ends in 64. A memory
+ *  operand is [base + disp32]; the base can not be RSP or R12, which need
+ *  a SIB byte. Code refers to positions by Label and is position
+ *  independent except for absolute calls.
+ */
+class X64Assembler {
+public:
+    struct Label {
+        long pos = -1;
+        std::vector<size_t> fixups; // rel32 fields waiting for the position
+    };
+
+    const std::vector<uint8_t> & code() const { return code_; }
+    size_t size() const { return code_.size(); }
+
+    //! @brief Place the label at the current position
+    void bind(Label & label);
+    //! @brief Place the label at a position relative to the start of the
+    //!  code, which may lie past its end, e.g. in data loaded after it
+    void bind(Label & label, long pos);
+
+    void mov(X64Reg dst, X64Reg src);
+    void mov(X64Reg dst, int32_t imm);
+    void mov64(X64Reg dst, X64Reg src);
+    void mov64(X64Reg dst, uint64_t imm);
+    void load(X64Reg dst, X64Reg base, int32_t disp);
+    void store(X64Reg base, int32_t disp, X64Reg src);
+    void store(X64Reg base, int32_t disp, int32_t imm);
+    void lea64(X64Reg dst, X64Reg base, int32_t disp);
+    //! @brief dst = address of the label, RIP-relative
+    void lea64(X64Reg dst, Label & label);
+    void load64(X64Reg dst, X64Reg base, int32_t disp);
+    void store64(X64Reg base, int32_t disp, X64Reg src);
+    //! @brief Zero-extending byte load
+    void load8(X64Reg dst, X64Reg base, int32_t disp);
+    //! @brief Store the low byte of src
+    void store8(X64Reg base, int32_t disp, X64Reg src);
+
+    void alu(X64Alu op, X64Reg dst, X64Reg src);
+    void alu(X64Alu op, X64Reg dst, int32_t imm);
+    void alu(X64Alu op, X64Reg dst, X64Reg base, int32_t disp);
+    //! @brief op [base + disp], imm
+    void alu_store(X64Alu op, X64Reg base, int32_t disp, int32_t imm);
+    void alu64(X64Alu op, X64Reg dst, X64Reg src);
+    void alu64(X64Alu op, X64Reg dst, int32_t imm);
+    void imul(X64Reg dst, X64Reg src);
+    void imul(X64Reg dst, X64Reg src, int32_t imm);
+    void imul_mem(X64Reg dst, X64Reg base, int32_t disp);
+    void test(X64Reg a, X64Reg b);
+    void neg(X64Reg reg);
+    void cdq();
+    void idiv(X64Reg divisor);
+    //! @brief Unsigned EDX:EAX / divisor
+    void div(X64Reg divisor);
+    //! @brief dst = cond ? 1 : 0, clobbers RAX
+    void setcc(X64Cond cond, X64Reg dst);
+
+    void push64(X64Reg reg);
+    void pop64(X64Reg reg);
+    void jmp(Label & label);
+    void jcc(X64Cond cond, Label & label);
+    //! @brief Call an absolute address through RAX
+    void call(const void * target);
+    void call(Label & label);
+    void ret();
+    void syscall();
+
+    void emit8(uint8_t byte) { code_.push_back(byte); }
+    void emit32(uint32_t v);
+
+private:
+    void rex(bool w, int reg, int base, bool force = false);
+    void modrm_reg(int reg, int rm);
+    void modrm_mem(int reg, int base, int32_t disp);
+    void rel32(Label & label);
+
+private:
+    std::vector<uint8_t> code_;
+};
+
+} /* namespace tinylang */
+
+#endif /* !X64_ASSEMBLER_H */
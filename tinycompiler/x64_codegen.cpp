@@ -0,0 +1,257 @@
+/*
+ * x64_codegen.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "x64_codegen.h"
+
+namespace tinylang {
+
+namespace {
+
+// expression temporaries by depth; RAX, RCX and RDX are kept for division
+// and spills, RBX holds the frame and R12 the runtime
+const X64Reg SCRATCH[] = {R8, R9, R10, R11, RSI, RDI};
+const int SCRATCH_COUNT = sizeof(SCRATCH) / sizeof(SCRATCH[0]);
+
+int32_t frame_offset(const TreeNode * t) {
+    return t->slot * static_cast<int32_t>(sizeof(int));
+}
+
+bool is_const(const TreeNode * e) {
+    return e->expr == ExprConst;
+}
+
+bool is_var(const TreeNode * e) {
+    return e->expr == ExprIdentifier;
+}
+
+} /* namespace */
+
+void X64CodeGenerator::generate(TreeNode * tree) {
+    div_checks_.clear();
+    fail_ = X64Assembler::Label();
+    X64Assembler::Label epilogue;
+
+    // the stack is 16-byte aligned after the three pushes
+    as_->push64(RBP);
+    as_->mov64(RBP, RSP);
+    as_->push64(RBX);
+    as_->push64(R12);
+    as_->mov64(R12, RDI);
+    as_->mov64(RBX, RSI);
+    this->stmt_sequence(tree);
+    as_->mov(RAX, 0);
+    as_->bind(epilogue);
+    as_->pop64(R12);
+    as_->pop64(RBX);
+    as_->pop64(RBP);
+    as_->ret();
+
+    for (DivCheck & check : div_checks_) {
+        as_->bind(check.label);
+        as_->mov(RSI, check.line_no);
+        as_->jmp(fail_);
+    }
+    if (!div_checks_.empty()) {
+        // drop the spills of the expression, realigning the stack for the call
+        as_->bind(fail_);
+        as_->lea64(RSP, RBP, -16);
+        this->call(CallDivZero);
+        as_->mov(RAX, -1);
+        as_->jmp(epilogue);
+    }
+}
+
+void X64CodeGenerator::call(RuntimeCall call) {
+    as_->mov64(RDI, R12);
+    if (targets_[call] != nullptr) {
+        as_->call(targets_[call]);
+    } else {
+        as_->call(labels_[call]);
+    }
+}
+
+void X64CodeGenerator::stmt_sequence(TreeNode * t) {
+    for (; t != nullptr; t = t->neighbor) {
+        switch (t->stmt) {
+            case StmtIf: {
+                X64Assembler::Label to_else, to_end;
+                this->jump_unless(t->children[0], to_else);
+                this->stmt_sequence(t->children[1]);
+                if (t->children[2] != nullptr) {
+                    as_->jmp(to_end);
+                    as_->bind(to_else);
+                    this->stmt_sequence(t->children[2]);
+                    as_->bind(to_end);
+                } else {
+                    as_->bind(to_else);
+                }
+                break;
+            }
+            case StmtRepeat: {
+                X64Assembler::Label body;
+                as_->bind(body);
+                this->stmt_sequence(t->children[0]);
+                this->jump_unless(t->children[1], body);
+                break;
+            }
+            case StmtAssign: {
+                TreeNode * e = t->children[0];
+                if (is_const(e)) {
+                    as_->store(RBX, frame_offset(t), e->attr.val);
+                } else if (e->expr == ExprOp &&
+                           (e->attr.op == TokenType::PLUS ||
+                            e->attr.op == TokenType::MINUS) &&
+                           is_var(e->children[0]) && e->children[0]->slot == t->slot &&
+                           is_const(e->children[1])) {
+                    // x := x + k updates the frame in place
+                    as_->alu_store(e->attr.op == TokenType::PLUS ? AluAdd : AluSub,
+                                RBX, frame_offset(t), e->children[1]->attr.val);
+                } else {
+                    this->expr(e, 0);
+                    as_->store(RBX, frame_offset(t), SCRATCH[0]);
+                }
+                break;
+            }
+            case StmtRead:
+                this->call(CallRead);
+                as_->store(RBX, frame_offset(t), RAX);
+                break;
+            case StmtWrite:
+                this->expr(t->children[0], 0);
+                as_->mov(RSI, SCRATCH[0]);
+                this->call(CallWrite);
+                break;
+        }
+    }
+}
+
+void X64CodeGenerator::expr(TreeNode * e, int depth) {
+    X64Reg dst = SCRATCH[depth];
+    if (is_const(e)) {
+        as_->mov(dst, e->attr.val);
+    } else if (is_var(e)) {
+        as_->load(dst, RBX, frame_offset(e));
+    } else {
+        this->expr(e->children[0], depth);
+        this->binary(e, depth);
+    }
+}
+
+void X64CodeGenerator::binary(TreeNode * e, int depth) {
+    X64Reg dst = SCRATCH[depth];
+    TreeNode * r = e->children[1];
+    TokenType op = e->attr.op;
+    X64Cond cond = op == TokenType::LT ? CondL : CondE;
+
+    if (is_const(r) || is_var(r)) {
+        if (op == TokenType::OVER) {
+            if (is_const(r) && r->attr.val == -1) {
+                as_->neg(dst); // wraps INT_MIN, where idiv would trap
+                return;
+            }
+            if (is_const(r)) {
+                as_->mov(RCX, r->attr.val);
+            } else {
+                as_->load(RCX, RBX, frame_offset(r));
+            }
+            this->divide(e, dst, RCX);
+            return;
+        }
+        // the right operand as an immediate or a frame slot
+        switch (op) {
+            case TokenType::PLUS:
+                is_const(r) ? as_->alu(AluAdd, dst, r->attr.val)
+                            : as_->alu(AluAdd, dst, RBX, frame_offset(r));
+                break;
+            case TokenType::MINUS:
+                is_const(r) ? as_->alu(AluSub, dst, r->attr.val)
+                            : as_->alu(AluSub, dst, RBX, frame_offset(r));
+                break;
+            case TokenType::TIMES:
+                is_const(r) ? as_->imul(dst, dst, r->attr.val)
+                            : as_->imul_mem(dst, RBX, frame_offset(r));
+                break;
+            default:
+                is_const(r) ? as_->alu(AluCmp, dst, r->attr.val)
+                            : as_->alu(AluCmp, dst, RBX, frame_offset(r));
+                as_->setcc(cond, dst);
+                break;
+        }
+        return;
+    }
+
+    X64Reg src;
+    if (depth + 1 < SCRATCH_COUNT) {
+        this->expr(r, depth + 1);
+        src = SCRATCH[depth + 1];
+    } else {
+        // out of registers: keep the left operand on the stack
+        as_->push64(dst);
+        this->expr(r, depth);
+        as_->mov(RCX, dst);
+        as_->pop64(dst);
+        src = RCX;
+    }
+    switch (op) {
+        case TokenType::PLUS:
+            as_->alu(AluAdd, dst, src);
+            break;
+        case TokenType::MINUS:
+            as_->alu(AluSub, dst, src);
+            break;
+        case TokenType::TIMES:
+            as_->imul(dst, src);
+            break;
+        case TokenType::OVER:
+            this->divide(e, dst, src);
+            break;
+        default:
+            as_->alu(AluCmp, dst, src);
+            as_->setcc(cond, dst);
+            break;
+    }
+}
+
+void X64CodeGenerator::divide(TreeNode * e, X64Reg dst, X64Reg divisor) {
+    div_checks_.push_back(DivCheck{X64Assembler::Label(), e->line_no});
+    as_->test(divisor, divisor);
+    as_->jcc(CondE, div_checks_.back().label);
+    X64Assembler::Label general, done;
+    as_->alu(AluCmp, divisor, -1);
+    as_->jcc(CondNE, general);
+    as_->neg(dst);
+    as_->jmp(done);
+    as_->bind(general);
+    as_->mov(RAX, dst);
+    as_->cdq();
+    as_->idiv(divisor);
+    as_->mov(dst, RAX);
+    as_->bind(done);
+}
+
+void X64CodeGenerator::jump_unless(TreeNode * cond, X64Assembler::Label & target) {
+    if (cond->expr != ExprOp ||
+        (cond->attr.op != TokenType::LT && cond->attr.op != TokenType::EQ)) {
+        this->expr(cond, 0);
+        as_->test(SCRATCH[0], SCRATCH[0]);
+        as_->jcc(CondE, target);
+        return;
+    }
+    this->expr(cond->children[0], 0);
+    TreeNode * r = cond->children[1];
+    if (is_const(r)) {
+        as_->alu(AluCmp, SCRATCH[0], r->attr.val);
+    } else if (is_var(r)) {
+        as_->alu(AluCmp, SCRATCH[0], RBX, frame_offset(r));
+    } else {
+        this->expr(r, 1);
+        as_->alu(AluCmp, SCRATCH[0], SCRATCH[1]);
+    }
+    as_->jcc(cond->attr.op == TokenType::LT ? CondGE : CondNE, target);
+}
+
+} /* namespace tinylang */
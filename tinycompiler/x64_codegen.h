@@ -0,0 +1,81 @@
+/*
+ * x64_codegen.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef X64_CODEGEN_H
+#define X64_CODEGEN_H
+
+#include "parser.h"
+#include "x64_assembler.h"
+#include <vector>
+
+namespace tinylang {
+
+/**
+ * @brief Routines of the runtime called by the generated code, with the
+ *  runtime pointer as the first argument:
+ *  int read(rt), void write(rt, int value), void div_zero(rt, int line_no).
+ */
+enum RuntimeCall {
+    CallRead,
+    CallWrite,
+    CallDivZero,
+    RUNTIME_CALL_COUNT
+};
+
+/**
+ * @brief Generate x86-64 code for an analysed syntax tree, shared by the
+ *  JIT and the ELF writer. The program is the function
+ *  int entry(void * rt, int * vars), returning 0, or -1 after a run-time
+ *  error. The variables live in the frame indexed by the slots of the
+ *  analyser, whose address is kept in RBX; expressions are evaluated in
+ *  scratch registers, spilling to the machine stack when nested too deep.
+ *  The semantics are those of the Interpreter.
+ */
+class X64CodeGenerator {
+public:
+    explicit X64CodeGenerator(X64Assembler * as) : as_(as) {}
+
+    //! @brief Call the routine at an absolute address instead of its label
+    void set_target(RuntimeCall call, const void * target) { targets_[call] = target; }
+
+    //! @brief Label of a routine without a target, for the caller to bind
+    X64Assembler::Label & label(RuntimeCall call) { return labels_[call]; }
+
+    //! @brief Emit the entry function at the current position
+    void generate(TreeNode * tree);
+
+private:
+    struct DivCheck {
+        X64Assembler::Label label;
+        int line_no;
+    };
+
+    void call(RuntimeCall call);
+
+    void stmt_sequence(TreeNode * t);
+
+    //! @brief Evaluate e into the scratch register of the depth
+    void expr(TreeNode * e, int depth);
+
+    //! @brief Apply the operator of e to the register of the depth and the
+    //!  right operand of e
+    void binary(TreeNode * e, int depth);
+    void divide(TreeNode * e, X64Reg dst, X64Reg divisor);
+
+    void jump_unless(TreeNode * cond, X64Assembler::Label & target);
+
+private:
+    X64Assembler * as_;
+    const void * targets_[RUNTIME_CALL_COUNT] = {};
+    X64Assembler::Label labels_[RUNTIME_CALL_COUNT];
+    std::vector<DivCheck> div_checks_; // out-of-line error paths
+    X64Assembler::Label fail_;
+};
+
+} /* namespace tinylang */
+
+#endif /* !X64_CODEGEN_H */
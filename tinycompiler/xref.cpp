@@ -0,0 +1,207 @@
+/*
+ * xref.cpp
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "xref.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace tinylang {
+
+int XrefIndex::add_file(const std::string & path) {
+    files_.push_back(path);
+    return files_.size() - 1;
+}
+
+int XrefIndex::add_symbol(const char * name) {
+    int id = names_.lookup(name);
+    if (id >= 0) {
+        return id;
+    }
+    id = names_.insert(name, 0);
+    symbols_.emplace_back();
+    symbols_.back().name = name;
+    return id;
+}
+
+void XrefIndex::add_def(int id, int file, uint32_t offset) {
+    symbols_[id].defs.push_back(XrefSite{static_cast<uint32_t>(file), offset});
+}
+
+void XrefIndex::add_use(int id, int file, uint32_t offset) {
+    symbols_[id].uses.push_back(XrefSite{static_cast<uint32_t>(file), offset});
+}
+
+void XrefIndex::finish() {
+    spans_.clear();
+    for (size_t id = 0; id < symbols_.size(); ++id) {
+        for (const XrefSite & site : symbols_[id].defs)
+            spans_.push_back(Span{site.file, site.offset, static_cast<int>(id)});
+        for (const XrefSite & site : symbols_[id].uses)
+            spans_.push_back(Span{site.file, site.offset, static_cast<int>(id)});
+    }
+    std::sort(spans_.begin(), spans_.end(), [](const Span & a, const Span & b) {
+        return a.file != b.file ? a.file < b.file : a.offset < b.offset;
+    });
+}
+
+int XrefIndex::symbol_at(int file, uint32_t offset) const {
+    // the last occurrence starting at or before the position
+    auto it = std::upper_bound(spans_.begin(), spans_.end(),
+                               Span{static_cast<uint32_t>(file), offset, 0},
+                               [](const Span & a, const Span & b) {
+                                   return a.file != b.file ? a.file < b.file
+                                                           : a.offset < b.offset;
+                               });
+    if (it == spans_.begin())
+        return -1;
+    --it;
+    if (it->file != static_cast<uint32_t>(file) ||
+        offset >= it->offset + symbols_[it->id].name.size())
+        return -1;
+    return it->id;
+}
+
+static void write_u32(FILE * fp, uint32_t v) {
+    fwrite(&v, sizeof(v), 1, fp);
+}
+
+static bool read_u32(FILE * fp, uint32_t * v) {
+    return fread(v, sizeof(*v), 1, fp) == 1;
+}
+
+//! @brief Read the count of the entries that follow, each at least
+//!  entry_size bytes; a count the rest of the file cannot hold is an error
+static bool read_count(FILE * fp, long file_size, size_t entry_size, uint32_t * count) {
+    if (!read_u32(fp, count))
+        return false;
+    long pos = ftell(fp);
+    return pos >= 0 && pos <= file_size &&
+           *count <= static_cast<unsigned long>(file_size - pos) / entry_size;
+}
+
+static void write_string(FILE * fp, const std::string & s) {
+    write_u32(fp, s.size());
+    fwrite(s.data(), 1, s.size(), fp);
+}
+
+static bool read_string(FILE * fp, long file_size, std::string * s) {
+    uint32_t len;
+    if (!read_count(fp, file_size, 1, &len))
+        return false;
+    s->resize(len);
+    return len == 0 || fread(&(*s)[0], 1, len, fp) == len;
+}
+
+static void write_sites(FILE * fp, const std::vector<XrefSite> & sites) {
+    write_u32(fp, sites.size());
+    fwrite(sites.data(), sizeof(XrefSite), sites.size(), fp);
+}
+
+//! @brief Read the sites, each in one of the first file_count files
+static bool read_sites(FILE * fp, long file_size, size_t file_count,
+                       std::vector<XrefSite> * sites) {
+    uint32_t count;
+    if (!read_count(fp, file_size, sizeof(XrefSite), &count))
+        return false;
+    sites->resize(count);
+    if (fread(sites->data(), sizeof(XrefSite), count, fp) != count)
+        return false;
+    for (const XrefSite & site : *sites) {
+        if (site.file >= file_count)
+            return false;
+    }
+    return true;
+}
+
+static const uint32_t XREF_MAGIC = 0x46525854; // "TXRF"
+static const uint32_t XREF_VERSION = 1;
+
+int XrefIndex::save(const char * path) const {
+    FILE * fp = fopen(path, "wb");
+    if (fp == nullptr) {
+        printf("error: cannot open file %s\n", path);
+        return -1;
+    }
+    write_u32(fp, XREF_MAGIC);
+    write_u32(fp, XREF_VERSION);
+    write_u32(fp, files_.size());
+    for (const std::string & f : files_) {
+        write_string(fp, f);
+    }
+    write_u32(fp, symbols_.size());
+    for (const XrefSymbol & sym : symbols_) {
+        write_string(fp, sym.name);
+        write_sites(fp, sym.defs);
+        write_sites(fp, sym.uses);
+    }
+    bool ok = !ferror(fp);
+    return (fclose(fp) == 0 && ok) ? 0 : -1;
+}
+
+int XrefIndex::load(const char * path) {
+    FILE * fp = fopen(path, "rb");
+    if (fp == nullptr) {
+        printf("error: cannot open file %s\n", path);
+        return -1;
+    }
+    *this = XrefIndex();
+    // counts are checked against the size, so that a broken file cannot
+    // make us allocate more than it holds
+    long size = fseek(fp, 0, SEEK_END) == 0 ? ftell(fp) : -1;
+    rewind(fp);
+    uint32_t magic = 0, version = 0, count = 0;
+    bool ok = size >= 0 &&
+              read_u32(fp, &magic) && magic == XREF_MAGIC &&
+              read_u32(fp, &version) && version == XREF_VERSION &&
+              read_count(fp, size, sizeof(uint32_t), &count);
+    files_.resize(ok ? count : 0);
+    for (size_t i = 0; ok && i < files_.size(); ++i) {
+        ok = read_string(fp, size, &files_[i]);
+    }
+    // a symbol is at least its name length and two site counts
+    ok = ok && read_count(fp, size, 3 * sizeof(uint32_t), &count);
+    std::string name;
+    for (uint32_t i = 0; ok && i < count; ++i) {
+        ok = read_string(fp, size, &name);
+        if (!ok)
+            break;
+        int id = this->add_symbol(name.c_str());
+        ok = read_sites(fp, size, files_.size(), &symbols_[id].defs) &&
+             read_sites(fp, size, files_.size(), &symbols_[id].uses);
+    }
+    fclose(fp);
+    if (!ok) {
+        printf("error: malformed index %s\n", path);
+        *this = XrefIndex();
+        return -1;
+    }
+    this->finish();
+    return 0;
+}
+
+int XrefBuilder::pre_visit(TreeNode * t) {
+    bool def = t->node_type == NodeStmt &&
+               (t->stmt == StmtAssign || t->stmt == StmtRead);
+    bool use = t->node_type == NodeExpr && t->expr == ExprIdentifier;
+    if (!def && !use)
+        return 0;
+    int st_id = symtable_.lookup(t->attr.name);
+    if (st_id < 0)
+        return 0; // undeclared
+    if (static_cast<size_t>(st_id) >= ids_.size())
+        ids_.resize(st_id + 1, -1);
+    if (ids_[st_id] < 0)
+        ids_[st_id] = index_->add_symbol(t->attr.name);
+    if (def) {
+        index_->add_def(ids_[st_id], file_, t->offset);
+    } else {
+        index_->add_use(ids_[st_id], file_, t->offset);
+    }
+    return 0;
+}
+
+} /* namespace tinylang */
@@ -0,0 +1,112 @@
+/*
+ * xref.h
+ * Copyright (C) 2018 StrayWarrior <i@straywarrior.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef XREF_H
+#define XREF_H
+
+#include "ast_visitor.h"
+#include "symtable.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tinylang {
+
+//! @brief A position in a source file
+struct XrefSite {
+    uint32_t file;
+    uint32_t offset;
+
+    bool operator==(const XrefSite & other) const {
+        return file == other.file && offset == other.offset;
+    }
+};
+
+struct XrefSymbol {
+    std::string name;
+    std::vector<XrefSite> defs; // assigned or read
+    std::vector<XrefSite> uses;
+};
+
+/**
+ * @brief Cross-reference index of the symbols of one or more files.
+ *  Symbols are keyed by name across files. Finding a symbol is one hash
+ *  probe, its definitions and uses are stored with it, and the symbol at a
+ *  position is a binary search over the sorted occurrences.
+ */
+class XrefIndex {
+public:
+    //! @return the id of the file
+    int add_file(const std::string & path);
+
+    const std::string & file(int id) const { return files_[id]; }
+    size_t file_count() const { return files_.size(); }
+
+    //! @return the id of the symbol, added if it is new
+    int add_symbol(const char * name);
+
+    void add_def(int id, int file, uint32_t offset);
+    void add_use(int id, int file, uint32_t offset);
+
+    //! @brief Sort the occurrences for symbol_at(), after the last addition
+    void finish();
+
+    //! @return the symbol id, or -1 if the name is not in the index
+    int lookup(const char * name) const { return names_.lookup(name); }
+
+    const XrefSymbol & symbol(int id) const { return symbols_[id]; }
+    size_t size() const { return symbols_.size(); }
+
+    const std::vector<XrefSite> & defs(int id) const { return symbols_[id].defs; }
+    const std::vector<XrefSite> & uses(int id) const { return symbols_[id].uses; }
+
+    //! @return the symbol whose name covers the position, or -1
+    int symbol_at(int file, uint32_t offset) const;
+
+    //! @return 0 for success
+    int save(const char * path) const;
+
+    //! @brief Replace the index with one saved before
+    //! @return 0 for success
+    int load(const char * path);
+
+private:
+    struct Span {
+        uint32_t file;
+        uint32_t offset;
+        int id;
+    };
+
+private:
+    std::vector<std::string> files_;
+    std::vector<XrefSymbol> symbols_;
+    SymTable names_; // interns the names into symbol ids
+    std::vector<Span> spans_; // sorted by position
+};
+
+/**
+ * @brief Pass that records the symbol occurrences of a file in an index.
+ *  Fuse it into Analyser::analyse_with(), the symbol table passed in is
+ *  the one of the analyser. Uses of undeclared names are left out.
+ */
+class XrefBuilder : public AstVisitor<XrefBuilder> {
+public:
+    XrefBuilder(XrefIndex * index, const SymTable & symtable, int file)
+        : index_(index), symtable_(symtable), file_(file) {}
+
+    int pre_visit(TreeNode * t);
+
+private:
+    XrefIndex * index_;
+    const SymTable & symtable_;
+    int file_;
+    std::vector<int> ids_; // symbol table id -> index id
+};
+
+} /* namespace tinylang */
+
+#endif /* !XREF_H */